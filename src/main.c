@@ -79,6 +79,175 @@ int main(int argc, char **argv) {
 	}
 	yvector_foreach(&v, func, &v);
 }
+#elif 0
+/* ystring append benchmark */
+int main(int argc, char **argv) {
+	size_t count = (argc > 1) ? (size_t)atol(argv[1]) : 10000000;
+	ytimer_t *timer = ytimer_new();
+	ystr_t s = ys_new("");
+
+	ytimer_start(timer);
+	for (size_t i = 0; i < count; ++i)
+		ys_addc(&s, 'a' + (i % 26));
+	ytimer_stop(timer);
+	printf("ys_addc:    %zu bytes in %ld us (%.1f MB/s)\n", ys_bytesize(s),
+	       ytimer_get_usec(timer), (double)count / ytimer_get_usec(timer));
+	ys_delete(&s);
+
+	s = ys_new("");
+	ytimer_start(timer);
+	for (size_t i = 0; i < count / 16; ++i)
+		ys_nappend(&s, "abcdefghijklmnopqrstuvwxyz", 16);
+	ytimer_stop(timer);
+	printf("ys_nappend: %zu bytes in %ld us (%.1f MB/s)\n", ys_bytesize(s),
+	       ytimer_get_usec(timer), (double)ys_bytesize(s) / ytimer_get_usec(timer));
+	ys_delete(&s);
+	ytimer_del(timer);
+	return (0);
+}
+#elif 0
+/* JSON parsers benchmark */
+int main(int argc, char **argv) {
+	size_t count = (argc > 1) ? (size_t)atol(argv[1]) : 200000;
+	ytimer_t *timer = ytimer_new();
+	yjson_parser_t json;
+	ystr_t doc = ys_new("[");
+	char buf[256];
+
+	for (size_t i = 0; i < count; ++i) {
+		snprintf(buf, sizeof(buf), "%s{\"id\": %zu, \"name\": \"item number %zu\", \"price\": %zu.25, "
+		         "\"active\": %s, \"tags\": [\"a\", \"b\\nc\", null]}",
+		         (i ? ", " : ""), i, i, i % 1000, ((i % 2) ? "true" : "false"));
+		ys_append(&doc, buf);
+	}
+	ys_append(&doc, "]");
+	size_t len = ys_bytesize(doc);
+	char *input = malloc0(len + 1);
+
+	memcpy(input, doc, len + 1);
+	ytimer_start(timer);
+	yres_var_t res = yjson_parse(&json, input);
+	ytimer_stop(timer);
+	printf("yjson_parse:      %zu bytes in %ld us (%.1f MB/s) status %d\n", len,
+	       ytimer_get_usec(timer), (double)len / ytimer_get_usec(timer), res.status);
+
+	memcpy(input, doc, len + 1);
+	ytimer_start(timer);
+	res = yjson_parse_fast(&json, input);
+	ytimer_stop(timer);
+	printf("yjson_parse_fast: %zu bytes in %ld us (%.1f MB/s) status %d\n", len,
+	       ytimer_get_usec(timer), (double)len / ytimer_get_usec(timer), res.status);
+
+	memcpy(input, doc, len + 1);
+	ytimer_start(timer);
+	yarena_t *arena = yarena_new(0);
+	res = yjson_parse_arena(&json, input, arena);
+	yarena_free(arena);
+	ytimer_stop(timer);
+	printf("yjson_parse_arena (with free): %zu bytes in %ld us (%.1f MB/s) status %d\n", len,
+	       ytimer_get_usec(timer), (double)len / ytimer_get_usec(timer), res.status);
+
+	free0(input);
+	ys_free(doc);
+	ytimer_del(timer);
+	return (0);
+}
+#elif 0
+/* NDJSON parser benchmark */
+int main(int argc, char **argv) {
+	size_t count = (argc > 1) ? (size_t)atol(argv[1]) : 1000000;
+	uint32_t nb_threads = (argc > 2) ? (uint32_t)atoi(argv[2]) : 0;
+	ytimer_t *timer = ytimer_new();
+	ystr_t doc = ys_new("");
+	char buf[256];
+
+	for (size_t i = 0; i < count; ++i) {
+		snprintf(buf, sizeof(buf), "{\"id\": %zu, \"name\": \"item number %zu\", \"price\": %zu.25, "
+		         "\"active\": %s, \"tags\": [\"a\", \"b\\nc\", null]}\n",
+		         i, i, i % 1000, ((i % 2) ? "true" : "false"));
+		ys_append(&doc, buf);
+	}
+	size_t len = ys_bytesize(doc);
+	yres_var_t *results;
+	size_t nb_results;
+	ytimer_start(timer);
+	ystatus_t st = yjson_parse_lines(doc, len, nb_threads, &results, &nb_results);
+	ytimer_stop(timer);
+	printf("yjson_parse_lines: %zu lines, %zu bytes in %ld us (%.1f MB/s) status %d\n",
+	       nb_results, len, ytimer_get_usec(timer), (double)len / ytimer_get_usec(timer), st);
+	free0(results);
+	ys_free(doc);
+	ytimer_del(timer);
+	return (0);
+}
+#elif 0
+/* ytable keyed access benchmark */
+int main(int argc, char **argv) {
+	size_t counts[] = {1000, 1000000, 10000000};
+	ytimer_t *timer = ytimer_new();
+	char buf[32];
+
+	for (size_t c = 0; c < sizeof(counts) / sizeof(counts[0]); ++c) {
+		size_t count = counts[c];
+		size_t rounds = MAX(1, 10000000 / count);
+		char **keys = malloc0(count * sizeof(char*));
+		for (size_t i = 0; i < count; ++i) {
+			snprintf(buf, sizeof(buf), "key-%zu", (i * 2654435761u) % 100000007);
+			keys[i] = strdup(buf);
+		}
+		long set_usec = 0, get_usec = 0;
+		size_t found = 0;
+		for (size_t r = 0; r < rounds; ++r) {
+			ytable_t *table = ytable_new();
+			ytimer_start(timer);
+			for (size_t i = 0; i < count; ++i)
+				ytable_set_key(table, keys[i], keys[i]);
+			ytimer_stop(timer);
+			set_usec += ytimer_get_usec(timer);
+			// lookups in another order than insertions
+			ytimer_start(timer);
+			for (size_t i = 0; i < count; ++i)
+				found += (ytable_get_key_data(table, keys[(i * 7919) % count]) != NULL);
+			ytimer_stop(timer);
+			get_usec += ytimer_get_usec(timer);
+			ytable_free(table);
+		}
+		printf("%8zu keys: ytable_set_key %6.1f ns/op, ytable_get_key %6.1f ns/op (%zu found)\n",
+		       count, set_usec * 1000.0 / (count * rounds),
+		       get_usec * 1000.0 / (count * rounds), found / rounds);
+		for (size_t i = 0; i < count; ++i)
+			free(keys[i]);
+		free0(keys);
+	}
+	ytimer_del(timer);
+	return (0);
+}
+#elif 0
+/* ytable FIFO benchmark */
+int main(int argc, char **argv) {
+	size_t backlogs[] = {1000, 100000, 1000000};
+	ytimer_t *timer = ytimer_new();
+
+	for (size_t b = 0; b < sizeof(backlogs) / sizeof(backlogs[0]); ++b) {
+		size_t backlog = backlogs[b];
+		size_t count = 1000000;
+		ytable_t *table = ytable_new();
+		for (size_t i = 0; i < backlog; ++i)
+			ytable_add(table, (void*)(i + 1));
+		// dequeue a job and enqueue a new one
+		ytimer_start(timer);
+		for (size_t i = 0; i < count; ++i) {
+			void *job = ytable_shift(table);
+			ytable_add(table, job);
+		}
+		ytimer_stop(timer);
+		printf("%8zu pending jobs: ytable_shift + ytable_add %8.1f ns/op\n",
+		       backlog, ytimer_get_usec(timer) * 1000.0 / count);
+		ytable_free(table);
+	}
+	ytimer_del(timer);
+	return (0);
+}
 #elif 1
 int main(int argc, char **argv) {
 	yjson_parser_t json;
@@ -26,12 +26,16 @@ extern "C" {
 #include <sys/param.h>	// MIN() and MAX() macros
 #include "ystatus.h"
 #include "ymemory.h"
+#include "yarena.h"
 #include "yresult.h"
 #include "ybin.h"
+#include "ycache.h"
 #include "ystr.h"
 #include "yarray.h"
+#include "yvector.h"
 #include "ybase64.h"
 #include "ycgi.h"
+#include "yctable.h"
 #include "ydaemon.h"
 #include "ydom.h"
 #include "yexception.h"
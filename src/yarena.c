@@ -0,0 +1,145 @@
+#include "y.h"
+
+/* ************ PRIVATE DEFINITIONS AND MACROS ************ */
+/** @define _YARENA_ALIGN Alignment of the allocated memory areas. */
+#define _YARENA_ALIGN		(sizeof(max_align_t))
+/** @define _YARENA_ALIGN_SIZE Round a size up to the alignment. */
+#define _YARENA_ALIGN_SIZE(s)	(((s) + _YARENA_ALIGN - 1) & ~(_YARENA_ALIGN - 1))
+
+/* ********** DECLARATION OF PRIVATE FUNCTIONS ********** */
+static yarena_chunk_t *_yarena_chunk_new(yarena_t *arena, size_t size);
+
+/* ************ CREATION/DELETION FUNCTIONS ************* */
+/* Create a new arena. */
+yarena_t *yarena_new(size_t chunk_size) {
+	yarena_t *arena = malloc0(sizeof(yarena_t));
+	if (!arena)
+		return (NULL);
+	arena->chunk_size = _YARENA_ALIGN_SIZE(chunk_size ? chunk_size : YARENA_DEFAULT_CHUNK_SIZE);
+	return (arena);
+}
+/* Destroy an arena. */
+void yarena_free(yarena_t *arena) {
+	if (!arena)
+		return;
+	yarena_chunk_t *chunk = arena->chunks;
+	while (chunk) {
+		yarena_chunk_t *next = chunk->next;
+		free0(chunk);
+		chunk = next;
+	}
+	free0(arena);
+}
+/* Release all the memory of an arena, but keep one chunk. */
+void yarena_reset(yarena_t *arena) {
+	if (!arena)
+		return;
+	yarena_chunk_t *kept = NULL;
+	yarena_chunk_t *chunk = arena->chunks;
+	while (chunk) {
+		yarena_chunk_t *next = chunk->next;
+		// keep the first chunk of standard size
+		if (!kept && chunk->size == arena->chunk_size)
+			kept = chunk;
+		else
+			free0(chunk);
+		chunk = next;
+	}
+	arena->chunks = kept;
+	arena->last = NULL;
+	arena->total = 0;
+	if (kept) {
+		kept->next = NULL;
+		kept->used = 0;
+		arena->total = sizeof(yarena_chunk_t) + kept->size;
+	}
+}
+
+/* ************ ALLOCATION FUNCTIONS ************* */
+/* Allocate memory from an arena. */
+void *yarena_alloc(yarena_t *arena, size_t size) {
+	if (!arena)
+		return (NULL);
+	size = _YARENA_ALIGN_SIZE(size ? size : 1);
+	yarena_chunk_t *chunk = arena->chunks;
+	// fast path: there is enough space in the current chunk
+	if (chunk && (chunk->size - chunk->used) >= size) {
+		void *ptr = (char*)chunk->data + chunk->used;
+		chunk->used += size;
+		arena->last = ptr;
+		return (ptr);
+	}
+	// big allocation: dedicated chunk, placed after the current one
+	if (size > arena->chunk_size / 4) {
+		yarena_chunk_t *big = _yarena_chunk_new(arena, size);
+		if (!big)
+			return (NULL);
+		big->used = size;
+		if (chunk) {
+			big->next = chunk->next;
+			chunk->next = big;
+		} else
+			arena->chunks = big;
+		return (big->data);
+	}
+	// new standard chunk
+	chunk = _yarena_chunk_new(arena, arena->chunk_size);
+	if (!chunk)
+		return (NULL);
+	chunk->next = arena->chunks;
+	arena->chunks = chunk;
+	chunk->used = size;
+	arena->last = chunk->data;
+	return (chunk->data);
+}
+/* Allocate zeroed memory from an arena. */
+void *yarena_calloc(yarena_t *arena, size_t nmemb, size_t size) {
+	if (size && nmemb > SIZE_MAX / size)
+		return (NULL);
+	void *ptr = yarena_alloc(arena, nmemb * size);
+	if (ptr)
+		memset(ptr, 0, nmemb * size);
+	return (ptr);
+}
+/* Resize a memory area allocated from an arena. */
+void *yarena_realloc(yarena_t *arena, void *ptr, size_t old_size, size_t new_size) {
+	if (!arena)
+		return (NULL);
+	if (!ptr)
+		return (yarena_alloc(arena, new_size));
+	// last allocation of the current chunk: try to resize it in place
+	yarena_chunk_t *chunk = arena->chunks;
+	if (ptr == arena->last && chunk) {
+		size_t offset = (char*)ptr - (char*)chunk->data;
+		size_t size = _YARENA_ALIGN_SIZE(new_size ? new_size : 1);
+		if (size <= chunk->size - offset) {
+			chunk->used = offset + size;
+			return (ptr);
+		}
+	}
+	if (new_size <= old_size)
+		return (ptr);
+	void *new_ptr = yarena_alloc(arena, new_size);
+	if (!new_ptr)
+		return (NULL);
+	memcpy(new_ptr, ptr, old_size);
+	return (new_ptr);
+}
+
+/* ********** PRIVATE FUNCTIONS ********** */
+/*
+ * Allocate a new chunk of memory.
+ * @param	arena	Pointer to the arena.
+ * @param	size	Usable size of the chunk.
+ * @return	A pointer to the allocated chunk, or NULL if an error occurred.
+ */
+static yarena_chunk_t *_yarena_chunk_new(yarena_t *arena, size_t size) {
+	yarena_chunk_t *chunk = malloc0(sizeof(yarena_chunk_t) + size);
+	if (!chunk)
+		return (NULL);
+	chunk->next = NULL;
+	chunk->size = size;
+	chunk->used = 0;
+	arena->total += sizeof(yarena_chunk_t) + size;
+	return (chunk);
+}
@@ -0,0 +1,110 @@
+/**
+ * @header	yarena.h
+ * @abstract	Arena (region-based) memory allocator.
+ * @discussion	An arena allocates memory by carving it out of big chunks. Allocations are
+ *		very cheap (a pointer increment most of the time) and individual allocations
+ *		are never freed: the whole memory of the arena is released at once, by a call
+ *		to yarena_free() or yarena_reset().
+ *		It is useful for request-scoped data, like parsed documents (see
+ *		yjson_parse_arena()).
+ * @version	1.0.0 Oct 15 2026
+ * @author	Amaury Bouchard <amaury@amaury.net>
+ */
+#pragma once
+
+#if defined(__cplusplus) || defined(c_plusplus)
+extern "C" {
+#endif /* __cplusplus || c_plusplus */
+
+#include <stddef.h>
+#include "ystatus.h"
+
+/** @define YARENA_DEFAULT_CHUNK_SIZE Default size of arena chunks (64 KB). */
+#define YARENA_DEFAULT_CHUNK_SIZE	65536
+
+/**
+ * @typedef	yarena_chunk_t
+ *		Chunk of memory used by an arena.
+ * @field	next	Pointer to the next chunk of the list.
+ * @field	size	Usable size of the chunk.
+ * @field	used	Used size of the chunk.
+ * @field	data	Chunk's memory.
+ */
+typedef struct yarena_chunk_s {
+	struct yarena_chunk_s *next;
+	size_t size;
+	size_t used;
+	max_align_t data[];
+} yarena_chunk_t;
+
+/**
+ * @typedef	yarena_t
+ *		Arena allocator.
+ * @field	chunks		List of chunks. The first one is the chunk currently used.
+ * @field	chunk_size	Size of newly created chunks.
+ * @field	last		Pointer to the last allocation (could be extended in place).
+ * @field	total		Total number of bytes allocated from the system.
+ */
+typedef struct {
+	yarena_chunk_t *chunks;
+	size_t chunk_size;
+	void *last;
+	size_t total;
+} yarena_t;
+
+/**
+ * @function	yarena_new
+ *		Create a new arena.
+ * @param	chunk_size	Size of the memory chunks. If set to zero, the default size
+ *				(YARENA_DEFAULT_CHUNK_SIZE) will be used.
+ * @return	A pointer to the allocated arena, or NULL if an error occurred.
+ */
+yarena_t *yarena_new(size_t chunk_size);
+/**
+ * @function	yarena_free
+ *		Destroy an arena and all the memory allocated from it.
+ * @param	arena	Pointer to the arena.
+ */
+void yarena_free(yarena_t *arena);
+/**
+ * @function	yarena_reset
+ *		Release all the memory allocated from an arena, but keep one chunk of memory
+ *		to reuse it for the next allocations.
+ * @param	arena	Pointer to the arena.
+ */
+void yarena_reset(yarena_t *arena);
+/**
+ * @function	yarena_alloc
+ *		Allocate memory from an arena. The memory is not zeroed.
+ * @param	arena	Pointer to the arena.
+ * @param	size	Number of bytes to allocate.
+ * @return	A pointer to the allocated memory (aligned for any type), or NULL if an
+ *		error occurred.
+ */
+void *yarena_alloc(yarena_t *arena, size_t size);
+/**
+ * @function	yarena_calloc
+ *		Allocate zeroed memory from an arena.
+ * @param	arena	Pointer to the arena.
+ * @param	nmemb	Number of elements to allocate.
+ * @param	size	Number of bytes of each allocated element.
+ * @return	A pointer to the allocated memory, or NULL if an error occurred.
+ */
+void *yarena_calloc(yarena_t *arena, size_t nmemb, size_t size);
+/**
+ * @function	yarena_realloc
+ *		Resize a memory area allocated from an arena. If it is the last allocation,
+ *		it is extended in place when possible; otherwise a new area is allocated and
+ *		the data is copied. The added memory is not zeroed.
+ * @param	arena		Pointer to the arena.
+ * @param	ptr		Pointer to the memory area. Could be NULL.
+ * @param	old_size	Current size of the memory area.
+ * @param	new_size	New size of the memory area.
+ * @return	A pointer to the resized memory area, or NULL if an error occurred (the
+ *		original memory area is left untouched).
+ */
+void *yarena_realloc(yarena_t *arena, void *ptr, size_t old_size, size_t new_size);
+
+#if defined(__cplusplus) || defined(c_plusplus)
+}
+#endif /* __cplusplus || c_plusplus */
@@ -11,18 +11,6 @@
 /** @define _YARRAY_HEAD Get a pointer to a yarray's header. */
 #define _YARRAY_HEAD(p)  ((yarray_head_t*)((void*)(p) - sizeof(yarray_head_t)))
 
-/* ************ PRIVATE STRUCTURES AND TYPES ************** */
-/**
- * @typedef	yarray_head_s
- *		Structure used for the head of yarrays.
- * @field	total	Total size of the yarray.
- * @field	used	Used size of the yarray.
- */
-typedef struct {
-	size_t total;
-	size_t used;
-} yarray_head_t;
-
 /* ************ FUNCTIONS ************* */
 
 /* Create a new yarray of the default size. */
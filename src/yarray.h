@@ -15,6 +15,17 @@ extern "C" {
 
 /* ************** TYPE DEFINITIONS ************* */
 
+/**
+ * @typedef	yarray_head_t
+ *		Structure placed in memory before the elements of yarrays (and of typed
+ *		vectors, see yvector.h).
+ * @field	total	Total size of the yarray.
+ * @field	used	Used size of the yarray.
+ */
+typedef struct {
+	size_t total;
+	size_t used;
+} yarray_head_t;
 /** @typedef yarray_t Array type definition. Always equivalent to (void**). */
 typedef void** yarray_t;
 /**
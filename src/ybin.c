@@ -116,7 +116,7 @@ ystatus_t ybin_append(ybin_t *bin, void *data, size_t bytesize) {
 		return (YENOERR);
 	if (!bin->data) {
 		size_t buffer_size = NEXT_POW2(bytesize);
-		bin->data = malloc0(bytesize);
+		bin->data = malloc0(buffer_size);
 		if (!bin->data)
 			return (YENOMEM);
 		memcpy(bin->data, data, bytesize);
@@ -151,7 +151,7 @@ ystatus_t ybin_prepend(ybin_t *bin, void *data, size_t bytesize) {
 		return (YENOERR);
 	if (!bin->data) {
 		size_t buffer_size = NEXT_POW2(bytesize);
-		bin->data = malloc0(bytesize);
+		bin->data = malloc0(buffer_size);
 		if (!bin->data)
 			return (YENOMEM);
 		memcpy(bin->data, data, bytesize);
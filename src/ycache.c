@@ -0,0 +1,238 @@
+#include <time.h>
+#include "y.h"
+#include "ycache.h"
+
+/* ************ PRIVATE STRUCTURES AND TYPES ************** */
+/**
+ * @typedef	_ycache_entry_t
+ *		Entry of a cache, stored as the data of a yhashtable element.
+ * @field	data		Pointer to the data.
+ * @field	size		Size of the data.
+ * @field	expiration	Expiration date (monotonic time, in milliseconds), or 0.
+ * @field	key		Copy of the key.
+ */
+typedef struct {
+	void *data;
+	size_t size;
+	uint64_t expiration;
+	char key[];
+} _ycache_entry_t;
+/**
+ * @typedef	ycache_t
+ *		Cache.
+ * @field	table		Hash table of the entries, whose list of elements is ordered
+ *				from the least recently used to the most recently used.
+ * @field	max_entries	Maximum number of entries (0 for no limit).
+ * @field	max_bytes	Maximum sum of the sizes of the entries (0 for no limit).
+ * @field	bytes		Sum of the sizes of the entries.
+ * @field	destroy_func	Pointer to the function called when an entry is removed.
+ * @field	destroy_data	Pointer to some data given to the destroy function.
+ * @field	hits		Number of reads which found their entry.
+ * @field	misses		Number of reads which didn't find their entry.
+ * @field	evictions	Number of entries removed to respect the limits.
+ * @field	expirations	Number of expired entries removed.
+ */
+struct ycache_s {
+	yhashtable_t *table;
+	size_t max_entries;
+	size_t max_bytes;
+	size_t bytes;
+	ycache_function_t destroy_func;
+	void *destroy_data;
+	uint64_t hits;
+	uint64_t misses;
+	uint64_t evictions;
+	uint64_t expirations;
+};
+
+/* ********** DECLARATION OF PRIVATE FUNCTIONS ********** */
+static uint64_t _ycache_now(void);
+static void _ycache_entry_delete(size_t hash_value, char *key, void *data, void *user_data);
+static void _ycache_evict(ycache_t *cache);
+
+/* ************ CREATION/DELETION FUNCTIONS ************* */
+/* Create a new cache. */
+ycache_t *ycache_new(size_t max_entries, size_t max_bytes, ycache_function_t destroy_func,
+                     void *destroy_data) {
+	ycache_t *cache = malloc0(sizeof(ycache_t));
+	if (!cache)
+		return (NULL);
+	*cache = (ycache_t){
+		.max_entries = max_entries,
+		.max_bytes = max_bytes,
+		.destroy_func = destroy_func,
+		.destroy_data = destroy_data,
+	};
+	// the hash table is sized for the maximum number of entries
+	size_t size = max_entries ? MIN(COMPUTE_SIZE(max_entries + (max_entries / 2), YHT_SIZE_MINI),
+	                                YHT_SIZE_HUGE) : YHT_SIZE_MINI;
+	cache->table = yhashtable_new((yhashtable_size_t)size, _ycache_entry_delete, cache);
+	if (!cache->table) {
+		free0(cache);
+		return (NULL);
+	}
+	return (cache);
+}
+/* Destroy a cache. */
+void ycache_free(ycache_t *cache) {
+	if (!cache)
+		return;
+	yhashtable_delete(cache->table);
+	free0(cache);
+}
+
+/* ************ ACCESS FUNCTIONS ************* */
+/* Add an entry to a cache. */
+ystatus_t ycache_set(ycache_t *cache, const char *key, void *data, size_t size, uint64_t ttl) {
+	if (!cache || !key)
+		return (YEINVAL);
+	if (cache->max_bytes && size > cache->max_bytes)
+		return (YE2BIG);
+	uint64_t expiration = ttl ? (_ycache_now() + ttl) : 0;
+	yhashtable_element_t *element = yhashtable_search_element_from_string(cache->table, key);
+	if (element) {
+		// replace the data of the existing entry
+		_ycache_entry_t *entry = element->data;
+		if (cache->destroy_func)
+			cache->destroy_func(entry->key, entry->data, cache->destroy_data);
+		cache->bytes = cache->bytes - entry->size + size;
+		*entry = (_ycache_entry_t){
+			.data = data,
+			.size = size,
+			.expiration = expiration,
+		};
+		yhashtable_move_to_end(cache->table, element);
+	} else {
+		// create a new entry, added at the end of the list
+		size_t key_len = strlen(key);
+		_ycache_entry_t *entry = malloc0(sizeof(_ycache_entry_t) + key_len + 1);
+		if (!entry)
+			return (YENOMEM);
+		*entry = (_ycache_entry_t){
+			.data = data,
+			.size = size,
+			.expiration = expiration,
+		};
+		memcpy(entry->key, key, key_len + 1);
+		size_t length = cache->table->used;
+		yhashtable_add_from_string(cache->table, entry->key, entry);
+		if (cache->table->used == length) {
+			free0(entry);
+			return (YENOMEM);
+		}
+		cache->bytes += size;
+	}
+	_ycache_evict(cache);
+	return (YENOERR);
+}
+/* Return the data of a cache entry. */
+yres_pointer_t ycache_get(ycache_t *cache, const char *key) {
+	if (!cache || !key)
+		return (YRESULT_ERR(yres_pointer_t, YEINVAL));
+	yhashtable_element_t *element = yhashtable_search_element_from_string(cache->table, key);
+	if (!element) {
+		cache->misses++;
+		return (YRESULT_ERR(yres_pointer_t, YEUNDEF));
+	}
+	_ycache_entry_t *entry = element->data;
+	if (entry->expiration && entry->expiration <= _ycache_now()) {
+		cache->misses++;
+		cache->expirations++;
+		yhashtable_remove_element(cache->table, element);
+		return (YRESULT_ERR(yres_pointer_t, YEUNDEF));
+	}
+	cache->hits++;
+	yhashtable_move_to_end(cache->table, element);
+	return (YRESULT_VAL(yres_pointer_t, entry->data));
+}
+/* Return the data of a cache entry. */
+void *ycache_get_data(ycache_t *cache, const char *key) {
+	yres_pointer_t res = ycache_get(cache, key);
+	return (YRES_VAL(res));
+}
+/* Remove an entry from a cache. */
+ystatus_t ycache_remove(ycache_t *cache, const char *key) {
+	if (!cache || !key)
+		return (YEINVAL);
+	yhashtable_element_t *element = yhashtable_search_element_from_string(cache->table, key);
+	if (!element)
+		return (YEUNDEF);
+	yhashtable_remove_element(cache->table, element);
+	return (YENOERR);
+}
+/* Remove the expired entries of a cache. */
+size_t ycache_purge(ycache_t *cache) {
+	if (!cache || !cache->table->used)
+		return (0);
+	uint64_t now = _ycache_now();
+	size_t removed = 0;
+	yhashtable_iterator_t it = yhashtable_iterator(cache->table);
+	while (yhashtable_iterator_next(&it)) {
+		_ycache_entry_t *entry = it.data;
+		if (!entry->expiration || entry->expiration > now)
+			continue;
+		yhashtable_iterator_remove(&it);
+		removed++;
+	}
+	cache->expirations += removed;
+	return (removed);
+}
+
+/* ************ GENERAL FUNCTIONS ************* */
+/* Return the number of entries of a cache. */
+size_t ycache_length(ycache_t *cache) {
+	if (!cache)
+		return (0);
+	return (cache->table->used);
+}
+/* Return the counters of a cache. */
+ycache_stats_t ycache_stats(ycache_t *cache) {
+	if (!cache)
+		return ((ycache_stats_t){0});
+	return ((ycache_stats_t){
+		.length = cache->table->used,
+		.bytes = cache->bytes,
+		.hits = cache->hits,
+		.misses = cache->misses,
+		.evictions = cache->evictions,
+		.expirations = cache->expirations,
+	});
+}
+
+/* ************ PRIVATE FUNCTIONS ************* */
+/*
+ * Return the current monotonic time.
+ * @return	The time, in milliseconds.
+ */
+static uint64_t _ycache_now(void) {
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (((uint64_t)ts.tv_sec * 1000) + ((uint64_t)ts.tv_nsec / 1000000));
+}
+/*
+ * Delete an entry removed from the hash table of a cache.
+ * @param	hash_value	Hash value of the key.
+ * @param	key		Key of the entry.
+ * @param	data		Pointer to the entry.
+ * @param	user_data	Pointer to the cache.
+ */
+static void _ycache_entry_delete(size_t hash_value, char *key, void *data, void *user_data) {
+	ycache_t *cache = user_data;
+	_ycache_entry_t *entry = data;
+	if (cache->destroy_func)
+		cache->destroy_func(entry->key, entry->data, cache->destroy_data);
+	cache->bytes -= entry->size;
+	free0(entry);
+}
+/*
+ * Remove the least recently used entries of a cache, until it respects its limits.
+ * @param	cache	Pointer to the cache.
+ */
+static void _ycache_evict(ycache_t *cache) {
+	while (cache->table->items &&
+	       ((cache->max_entries && cache->table->used > cache->max_entries) ||
+	        (cache->max_bytes && cache->bytes > cache->max_bytes))) {
+		yhashtable_remove_element(cache->table, cache->table->items);
+		cache->evictions++;
+	}
+}
@@ -0,0 +1,156 @@
+/**
+ * @header	ycache.h
+ * @abstract	LRU cache, with capacity limits and per-entry expiration.
+ * @discussion	A ycache stores data associated to string keys (which are copied), in a
+ *		yhashtable whose list of elements is kept ordered by last use: a hit moves
+ *		the entry to the end of the list, and the least recently used entry (the
+ *		first one) is evicted in constant time when the cache exceeds its maximum
+ *		number of entries or of bytes.
+ *		Each entry could have a time-to-live. Expired entries are removed when they
+ *		are read, or by ycache_purge().
+ *		A cache is not thread-safe.
+ *		<code>
+ *		ycache_t *cache = ycache_new(10000, 0, free_session, NULL);
+ *		ycache_set(cache, "session-id", session, sizeof(*session), 30000);
+ *		session_t *s = ycache_get_data(cache, "session-id");
+ *		</code>
+ * @version	1.0.0 Oct 16 2026
+ * @author	Amaury Bouchard <amaury@amaury.net>
+ */
+#pragma once
+
+#if defined(__cplusplus) || defined(c_plusplus)
+extern "C" {
+#endif /* __cplusplus || c_plusplus */
+
+#include "ystatus.h"
+#include "yhashtable.h"
+
+/** @typedef ycache_t Cache (opaque structure). */
+typedef struct ycache_s ycache_t;
+/**
+ * @typedef	ycache_function_t
+ *		Function called when an entry is removed from a cache (evicted, expired,
+ *		replaced or removed).
+ * @param	key		Key of the entry.
+ * @param	data		Data of the entry.
+ * @param	user_data	Pointer to some user data.
+ */
+typedef void (*ycache_function_t)(const char *key, void *data, void *user_data);
+/**
+ * @typedef	ycache_stats_t
+ *		Counters of a cache. See ycache_stats().
+ * @field	length		Number of entries.
+ * @field	bytes		Sum of the sizes of the entries.
+ * @field	hits		Number of reads which found their entry.
+ * @field	misses		Number of reads which didn't find their entry (or found it
+ *				expired).
+ * @field	evictions	Number of entries removed to respect the capacity limits.
+ * @field	expirations	Number of expired entries removed.
+ */
+typedef struct {
+	size_t length;
+	size_t bytes;
+	uint64_t hits;
+	uint64_t misses;
+	uint64_t evictions;
+	uint64_t expirations;
+} ycache_stats_t;
+
+#include "yresult.h"
+
+/* ********** CREATION / DELETION ********** */
+/**
+ * @function	ycache_new
+ *		Create a new cache.
+ * @param	max_entries	Maximum number of entries, or 0 for no limit.
+ * @param	max_bytes	Maximum sum of the sizes of the entries, or 0 for no limit.
+ * @param	destroy_func	Pointer to the function called when an entry is removed.
+ *				Could be NULL.
+ * @param	destroy_data	Pointer to some data given to the destroy function.
+ * @return	A pointer to the allocated cache, or NULL if an error occurred.
+ */
+ycache_t *ycache_new(size_t max_entries, size_t max_bytes, ycache_function_t destroy_func,
+                     void *destroy_data);
+/**
+ * @function	ycache_free
+ *		Destroy a cache. The destroy function is called on all its entries.
+ * @param	cache	Pointer to the cache.
+ */
+void ycache_free(ycache_t *cache);
+
+/* ********** ACCESS FUNCTIONS ********** */
+/**
+ * @function	ycache_set
+ *		Add an entry to a cache, or replace the entry which has the same key (the
+ *		destroy function is called on the previous data). The entry becomes the most
+ *		recently used one. The least recently used entries are evicted if the cache
+ *		exceeds its limits.
+ * @param	cache	Pointer to the cache.
+ * @param	key	Key of the entry (copied).
+ * @param	data	Pointer to the data.
+ * @param	size	Size of the data, as counted against the maximum number of bytes.
+ * @param	ttl	Time-to-live of the entry, in milliseconds. 0 if it never expires.
+ * @return	YENOERR if OK.
+ *		YEINVAL if the cache or the key is NULL.
+ *		YE2BIG if the size is greater than the maximum number of bytes.
+ *		YENOMEM if the memory couldn't be allocated.
+ */
+ystatus_t ycache_set(ycache_t *cache, const char *key, void *data, size_t size, uint64_t ttl);
+/**
+ * @function	ycache_get
+ *		Return the data of a cache entry, which becomes the most recently used one.
+ *		An expired entry is removed.
+ * @param	cache	Pointer to the cache.
+ * @param	key	Key of the entry.
+ * @return	YENOERR if the entry exists, and a pointer to its data.
+ *		YEINVAL if the cache or the key is NULL.
+ *		YEUNDEF if the entry doesn't exist or has expired.
+ */
+yres_pointer_t ycache_get(ycache_t *cache, const char *key);
+/**
+ * @function	ycache_get_data
+ *		Return the data of a cache entry. See ycache_get().
+ * @param	cache	Pointer to the cache.
+ * @param	key	Key of the entry.
+ * @return	A pointer to the data, or NULL if the entry doesn't exist or has expired.
+ */
+void *ycache_get_data(ycache_t *cache, const char *key);
+/**
+ * @function	ycache_remove
+ *		Remove an entry from a cache (the destroy function is called on it).
+ * @param	cache	Pointer to the cache.
+ * @param	key	Key of the entry.
+ * @return	YENOERR if OK.
+ *		YEINVAL if the cache or the key is NULL.
+ *		YEUNDEF if the entry doesn't exist.
+ */
+ystatus_t ycache_remove(ycache_t *cache, const char *key);
+/**
+ * @function	ycache_purge
+ *		Remove all the expired entries of a cache. All the entries are checked.
+ * @param	cache	Pointer to the cache.
+ * @return	The number of removed entries.
+ */
+size_t ycache_purge(ycache_t *cache);
+
+/* ********** GENERAL FUNCTIONS ********** */
+/**
+ * @function	ycache_length
+ *		Return the number of entries of a cache (including the expired entries
+ *		which were not removed yet).
+ * @param	cache	Pointer to the cache.
+ * @return	The number of entries.
+ */
+size_t ycache_length(ycache_t *cache);
+/**
+ * @function	ycache_stats
+ *		Return the counters of a cache.
+ * @param	cache	Pointer to the cache.
+ * @return	The counters.
+ */
+ycache_stats_t ycache_stats(ycache_t *cache);
+
+#if defined(__cplusplus) || defined(c_plusplus)
+}
+#endif /* __cplusplus || c_plusplus */
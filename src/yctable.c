@@ -0,0 +1,352 @@
+#include <pthread.h>
+#include <sched.h>
+#include <stdatomic.h>
+#include "y.h"
+#include "yctable.h"
+
+/* ************ PRIVATE DEFINITIONS AND MACROS ************ */
+/** @define _YCTABLE_NB_SLOTS Number of readers counters (threads are spread over them). */
+#define _YCTABLE_NB_SLOTS	64
+/** @define _YCTABLE_SLOT_SIZE Size of a readers counter (two cache lines, to avoid false sharing). */
+#define _YCTABLE_SLOT_SIZE	128
+
+/* ************ PRIVATE STRUCTURES AND TYPES ************** */
+/**
+ * @typedef	_yctable_slot_t
+ *		Counters of the readers of a concurrent table, for a set of threads.
+ * @field	readers	Number of running read sections, for each epoch parity.
+ */
+typedef union {
+	atomic_uint readers[2];
+	char padding[_YCTABLE_SLOT_SIZE];
+} _yctable_slot_t;
+/**
+ * @typedef	_yctable_retired_t
+ *		Element removed from a concurrent table, to be deleted when no reader could
+ *		use it anymore.
+ * @field	hash	Index of the element.
+ * @field	key	String key of the element.
+ * @field	data	Data of the element.
+ */
+typedef struct {
+	uint64_t hash;
+	char *key;
+	void *data;
+} _yctable_retired_t;
+/**
+ * @typedef	yctable_t
+ *		Concurrent table.
+ * @field	current		Pointer to the current version of the table.
+ * @field	epoch		Epoch counter, incremented twice by each modification. Read
+ *				sections use the counters of its parity.
+ * @field	mutex		Mutex used to serialize the modifications.
+ * @field	delete_function	Pointer to a function used to delete elements.
+ * @field	delete_data	Pointer to data given to the delete function.
+ * @field	retired		Elements removed by the modification in progress.
+ * @field	nb_retired	Number of removed elements.
+ * @field	retired_size	Allocated size of the list of removed elements.
+ * @field	slots		Readers counters.
+ */
+struct yctable_s {
+	_Atomic(ytable_t*) current;
+	atomic_uint epoch;
+	pthread_mutex_t mutex;
+	ytable_function_t delete_function;
+	void *delete_data;
+	_yctable_retired_t *retired;
+	uint32_t nb_retired;
+	uint32_t retired_size;
+	_yctable_slot_t slots[_YCTABLE_NB_SLOTS];
+};
+
+/* ************ PRIVATE VARIABLES ************** */
+/** @var _yctable_next_slot Readers counter given to the next thread which reads a table. */
+static atomic_uint _yctable_next_slot;
+/** @var _yctable_thread_slot Readers counter of the current thread (plus one; zero if unset). */
+static _Thread_local uint32_t _yctable_thread_slot;
+
+/* ********** DECLARATION OF PRIVATE FUNCTIONS ********** */
+static ystatus_t _yctable_retire(uint64_t hash, char *key, void *data, void *user_data);
+static void _yctable_delete_retired(yctable_t *table);
+static void _yctable_synchronize(yctable_t *table);
+static ystatus_t _yctable_add(ytable_t *table, void *user_data);
+static ystatus_t _yctable_set_index(ytable_t *table, void *user_data);
+static ystatus_t _yctable_remove_index(ytable_t *table, void *user_data);
+static ystatus_t _yctable_set_key(ytable_t *table, void *user_data);
+
+/* ************ CREATION/DELETION FUNCTIONS ************* */
+/* Create a new concurrent table. */
+yctable_t *yctable_new(ytable_function_t delete_function, void *delete_data) {
+	yctable_t *table = malloc0(sizeof(yctable_t));
+	if (!table)
+		return (NULL);
+	// removed elements are kept until no reader could use them
+	ytable_t *current = ytable_create(0, delete_function ? _yctable_retire : NULL, table);
+	if (!current) {
+		free0(table);
+		return (NULL);
+	}
+	*table = (yctable_t){
+		.delete_function = delete_function,
+		.delete_data = delete_data,
+	};
+	atomic_init(&table->current, current);
+	atomic_init(&table->epoch, 0);
+	for (uint32_t i = 0; i < _YCTABLE_NB_SLOTS; ++i) {
+		atomic_init(&table->slots[i].readers[0], 0);
+		atomic_init(&table->slots[i].readers[1], 0);
+	}
+	pthread_mutex_init(&table->mutex, NULL);
+	return (table);
+}
+/* Destroy a concurrent table. */
+void yctable_free(yctable_t *table) {
+	if (!table)
+		return;
+	ytable_free(atomic_load(&table->current));
+	_yctable_delete_retired(table);
+	free0(table->retired);
+	pthread_mutex_destroy(&table->mutex);
+	free0(table);
+}
+
+/* ********** READ FUNCTIONS ********** */
+/* Start a read section. */
+yctable_read_t yctable_read_begin(yctable_t *table) {
+	if (!table)
+		return ((yctable_read_t){0});
+	if (!_yctable_thread_slot)
+		_yctable_thread_slot = (atomic_fetch_add(&_yctable_next_slot, 1) %
+		                        _YCTABLE_NB_SLOTS) + 1;
+	yctable_read_t read = {
+		.ctable = table,
+		.slot = _yctable_thread_slot - 1,
+		.epoch = atomic_load(&table->epoch) & 1,
+	};
+	// the counter is incremented before the current version is read: a writer which
+	// replaces it after that waits for the end of the section
+	atomic_fetch_add(&table->slots[read.slot].readers[read.epoch], 1);
+	read.table = atomic_load(&table->current);
+	return (read);
+}
+/* End a read section. */
+void yctable_read_end(yctable_read_t *read) {
+	if (!read || !read->ctable)
+		return;
+	atomic_fetch_sub(&read->ctable->slots[read->slot].readers[read->epoch], 1);
+	read->ctable = NULL;
+	read->table = NULL;
+}
+/* Return the number of elements of a concurrent table. */
+uint32_t yctable_length(yctable_t *table) {
+	yctable_read_t read = yctable_read_begin(table);
+	uint32_t length = ytable_length(read.table);
+	yctable_read_end(&read);
+	return (length);
+}
+/* Tell if a given index exists in a concurrent table. */
+bool yctable_index_exists(yctable_t *table, uint64_t index) {
+	return ((YRES_STATUS(yctable_get_index(table, index)) == YENOERR) ? true : false);
+}
+/* Tell if a given index exists and is set in a concurrent table. */
+bool yctable_index_isset(yctable_t *table, uint64_t index) {
+	return (yctable_get_index_data(table, index) ? true : false);
+}
+/* Return the value associated to the given index. */
+yres_pointer_t yctable_get_index(yctable_t *table, uint64_t index) {
+	if (!table)
+		return (YRESULT_ERR(yres_pointer_t, YEINVAL));
+	yctable_read_t read = yctable_read_begin(table);
+	yres_pointer_t res = ytable_get_index(read.table, index);
+	yctable_read_end(&read);
+	return (res);
+}
+/* Return the data value associated to the given index. */
+void *yctable_get_index_data(yctable_t *table, uint64_t index) {
+	yres_pointer_t res = yctable_get_index(table, index);
+	RETURN_NULL_IF_ERR(YRES_STATUS(res));
+	return (YRES_VAL(res));
+}
+/* Return the data values associated to a list of indexes. */
+uint32_t yctable_get_indexes_batch(yctable_t *table, uint32_t count, const uint64_t *indexes,
+                                   void **results) {
+	if (!table)
+		return (0);
+	yctable_read_t read = yctable_read_begin(table);
+	uint32_t found = ytable_get_indexes_batch(read.table, count, indexes, results);
+	yctable_read_end(&read);
+	return (found);
+}
+/* Tell if a given string key exists in a concurrent table. */
+bool yctable_key_exists(yctable_t *table, const char *key) {
+	return ((YRES_STATUS(yctable_get_key(table, key)) == YENOERR) ? true : false);
+}
+/* Tell if a given string key exists and is set in a concurrent table. */
+bool yctable_key_isset(yctable_t *table, const char *key) {
+	return (yctable_get_key_data(table, key) ? true : false);
+}
+/* Return the value associated to the given string key. */
+yres_pointer_t yctable_get_key(yctable_t *table, const char *key) {
+	if (!table || !key)
+		return (YRESULT_ERR(yres_pointer_t, YEINVAL));
+	yctable_read_t read = yctable_read_begin(table);
+	yres_pointer_t res = ytable_get_key(read.table, key);
+	yctable_read_end(&read);
+	return (res);
+}
+/* Return the data value associated to the given string key. */
+void *yctable_get_key_data(yctable_t *table, const char *key) {
+	yres_pointer_t res = yctable_get_key(table, key);
+	RETURN_NULL_IF_ERR(YRES_STATUS(res));
+	return (YRES_VAL(res));
+}
+/* Return the data values associated to a list of string keys. */
+uint32_t yctable_get_keys_batch(yctable_t *table, uint32_t count, const char **keys,
+                                void **results) {
+	if (!table)
+		return (0);
+	yctable_read_t read = yctable_read_begin(table);
+	uint32_t found = ytable_get_keys_batch(read.table, count, keys, results);
+	yctable_read_end(&read);
+	return (found);
+}
+/* Apply a function on every elements of a concurrent table. */
+ystatus_t yctable_foreach(yctable_t *table, ytable_function_t func, void *user_data) {
+	if (!table)
+		return (YEINVAL);
+	// the version read at the beginning is kept until the end of the loop
+	yctable_read_t read = yctable_read_begin(table);
+	ystatus_t st = ytable_foreach(read.table, func, user_data);
+	yctable_read_end(&read);
+	return (st);
+}
+
+/* ********** WRITE FUNCTIONS ********** */
+/* Modify a concurrent table. */
+ystatus_t yctable_update(yctable_t *table, yctable_update_function_t func, void *user_data) {
+	if (!table || !func)
+		return (YEINVAL);
+	pthread_mutex_lock(&table->mutex);
+	// the modifications are done on a new version of the table (its memory is shared
+	// with the current one until the first modification)
+	ytable_t *current = atomic_load(&table->current);
+	ytable_t *next = ytable_clone(current);
+	ystatus_t st = next ? func(next, user_data) : YENOMEM;
+	if (st != YENOERR) {
+		// nothing was removed from the current version
+		table->nb_retired = 0;
+		if (next) {
+			next->delete_function = NULL;
+			ytable_free(next);
+		}
+		pthread_mutex_unlock(&table->mutex);
+		return (st);
+	}
+	atomic_store(&table->current, next);
+	// wait for the readers of the previous version, which can then be freed
+	_yctable_synchronize(table);
+	current->delete_function = NULL;
+	ytable_free(current);
+	_yctable_delete_retired(table);
+	pthread_mutex_unlock(&table->mutex);
+	return (YENOERR);
+}
+/* Add an element at the end of a concurrent table. */
+ystatus_t yctable_add(yctable_t *table, void *data) {
+	return (yctable_update(table, _yctable_add, data));
+}
+/* Add an element in a concurrent table using an index. */
+ystatus_t yctable_set_index(yctable_t *table, uint64_t index, void *data) {
+	_yctable_retired_t element = {
+		.hash = index,
+		.data = data,
+	};
+	return (yctable_update(table, _yctable_set_index, &element));
+}
+/* Remove an element from its index. */
+ystatus_t yctable_remove_index(yctable_t *table, uint64_t index) {
+	return (yctable_update(table, _yctable_remove_index, &index));
+}
+/* Add an element in a concurrent table using a string key. */
+ystatus_t yctable_set_key(yctable_t *table, const char *key, void *data) {
+	if (!key)
+		return (YEINVAL);
+	_yctable_retired_t element = {
+		.key = (char*)key,
+		.data = data,
+	};
+	return (yctable_update(table, _yctable_set_key, &element));
+}
+
+/* ********** PRIVATE FUNCTIONS ********** */
+/*
+ * Delete function of the versions of a concurrent table: the removed elements are kept
+ * until no reader could use them anymore.
+ * @param	hash		Index of the element.
+ * @param	key		String key of the element.
+ * @param	data		Data of the element.
+ * @param	user_data	Pointer to the concurrent table.
+ * @return	YENOERR if OK, YENOMEM if the element couldn't be kept.
+ */
+static ystatus_t _yctable_retire(uint64_t hash, char *key, void *data, void *user_data) {
+	yctable_t *table = user_data;
+	if (table->nb_retired == table->retired_size) {
+		uint32_t size = COMPUTE_SIZE(table->nb_retired + 1, 8);
+		_yctable_retired_t *retired = realloc0(table->retired,
+		                                       size * sizeof(_yctable_retired_t));
+		if (!retired)
+			return (YENOMEM);
+		table->retired = retired;
+		table->retired_size = size;
+	}
+	table->retired[table->nb_retired++] = (_yctable_retired_t){
+		.hash = hash,
+		.key = key,
+		.data = data,
+	};
+	return (YENOERR);
+}
+/*
+ * Call the delete function on the removed elements of a concurrent table.
+ * @param	table	Pointer to the concurrent table.
+ */
+static void _yctable_delete_retired(yctable_t *table) {
+	for (uint32_t i = 0; i < table->nb_retired; ++i) {
+		_yctable_retired_t *e = &table->retired[i];
+		table->delete_function(e->hash, e->key, e->data, table->delete_data);
+	}
+	table->nb_retired = 0;
+}
+/*
+ * Wait until no reader could use the previous version of a concurrent table. A read
+ * section could have read the epoch long before incrementing its counter, so the
+ * counters of both parities are waited for: the epoch is incremented before each wait,
+ * so that new read sections use the other counters and the wait ends.
+ * @param	table	Pointer to the concurrent table.
+ */
+static void _yctable_synchronize(yctable_t *table) {
+	for (uint32_t n = 0; n < 2; ++n) {
+		uint32_t epoch = atomic_fetch_add(&table->epoch, 1) & 1;
+		for (uint32_t i = 0; i < _YCTABLE_NB_SLOTS; ++i)
+			while (atomic_load(&table->slots[i].readers[epoch]))
+				sched_yield();
+	}
+}
+/* Add an element at the end of a table version (see yctable_add()). */
+static ystatus_t _yctable_add(ytable_t *table, void *user_data) {
+	return (ytable_add(table, user_data));
+}
+/* Add an element in a table version using an index (see yctable_set_index()). */
+static ystatus_t _yctable_set_index(ytable_t *table, void *user_data) {
+	_yctable_retired_t *element = user_data;
+	return (ytable_set_index(table, element->hash, element->data));
+}
+/* Remove an element of a table version from its index (see yctable_remove_index()). */
+static ystatus_t _yctable_remove_index(ytable_t *table, void *user_data) {
+	return (ytable_remove_index(table, *(uint64_t*)user_data));
+}
+/* Add an element in a table version using a string key (see yctable_set_key()). */
+static ystatus_t _yctable_set_key(ytable_t *table, void *user_data) {
+	_yctable_retired_t *element = user_data;
+	return (ytable_set_key(table, element->key, element->data));
+}
@@ -0,0 +1,278 @@
+/**
+ * @header	yctable.h
+ * @abstract	Concurrent ytable, for read-mostly data shared between threads.
+ * @discussion	A yctable contains a ytable which could be read by many threads at once,
+ *		without any lock. Modifications are serialized by a mutex; each one is done
+ *		on a clone of the current version of the table (see ytable_clone()), which
+ *		then replaces it. The previous version, and the data removed or overwritten
+ *		by the modification, are deleted when no reader uses them anymore (the
+ *		writer waits for the end of the read sections started before the
+ *		replacement, whose counters are spread over several cache lines so readers
+ *		don't contend with each other).
+ *		As each modification copies the table, several modifications should be done
+ *		at once using yctable_update(). Only the most common modifications have
+ *		their own function; the others (ytable_push(), ytable_pop(), ytable_shift(),
+ *		ytable_extract_index()...) are done by calling the ytable functions from
+ *		yctable_update().
+ *
+ *		Data could be read with the yctable_get_*() functions, or by using the
+ *		ytable functions on the table given by yctable_read_begin():
+ *		<code>
+ *		yctable_read_t read = yctable_read_begin(ctable);
+ *		char *value = ytable_get_key_data(read.table, "foo");
+ *		// use the value; it can't be deleted before the end of the read section
+ *		yctable_read_end(&read);
+ *		</code>
+ * @version	1.0.0 Oct 16 2026
+ * @author	Amaury Bouchard <amaury@amaury.net>
+ */
+#pragma once
+
+#if defined(__cplusplus) || defined(c_plusplus)
+extern "C" {
+#endif /* __cplusplus || c_plusplus */
+
+#include "ystatus.h"
+#include "ytable.h"
+
+/** @typedef yctable_t Concurrent table (opaque structure). */
+typedef struct yctable_s yctable_t;
+/**
+ * @typedef	yctable_update_function_t
+ *		Function used to modify a concurrent table.
+ * @param	table		Pointer to the new version of the table, to modify with the
+ *				ytable functions.
+ * @param	user_data	Pointer to some user data.
+ * @return	YENOERR if the modifications must be kept.
+ */
+typedef ystatus_t (*yctable_update_function_t)(ytable_t *table, void *user_data);
+/**
+ * @typedef	yctable_read_t
+ *		Read section, allocated by the caller (usually on the stack). See
+ *		yctable_read_begin().
+ * @field	table		Pointer to the version of the table which could be read during
+ *				the read section. It must not be modified.
+ * @field	ctable		Pointer to the concurrent table.
+ * @field	slot		Index of the readers counter used by the section.
+ * @field	epoch		Parity of the epoch when the section started.
+ */
+typedef struct {
+	ytable_t *table;
+	yctable_t *ctable;
+	uint32_t slot;
+	uint32_t epoch;
+} yctable_read_t;
+
+#include "yresult.h"
+
+/* ********** CREATION / DELETION ********** */
+/**
+ * @function	yctable_new
+ *		Create a new concurrent table.
+ * @param	delete_function	Pointer to a function used to delete elements, when no
+ *				reader could use them anymore. Could be NULL.
+ * @param	delete_data	Pointer to some data given to the delete function. Could be NULL.
+ * @return	A pointer to the allocated table, or NULL if an error occurred.
+ */
+yctable_t *yctable_new(ytable_function_t delete_function, void *delete_data);
+/**
+ * @function	yctable_free
+ *		Destroy a concurrent table. No other thread must use it anymore.
+ * @param	table	Pointer to the concurrent table.
+ */
+void yctable_free(yctable_t *table);
+
+/* ********** READ FUNCTIONS ********** */
+/**
+ * @function	yctable_read_begin
+ *		Start a read section. No lock is taken. The elements of the table given in
+ *		the returned structure are not deleted before the end of the section.
+ *		Read sections must be short, because writers wait for their end.
+ * @param	table	Pointer to the concurrent table.
+ * @return	The read section.
+ */
+yctable_read_t yctable_read_begin(yctable_t *table);
+/**
+ * @function	yctable_read_end
+ *		End a read section.
+ * @param	read	Pointer to the read section.
+ */
+void yctable_read_end(yctable_read_t *read);
+/**
+ * @function	yctable_length
+ *		Return the number of elements of a concurrent table.
+ * @param	table	Pointer to the concurrent table.
+ * @return	The length of the table.
+ */
+uint32_t yctable_length(yctable_t *table);
+/**
+ * @function	yctable_index_exists
+ *		Tell if a given index exists in a concurrent table.
+ * @param	table	Pointer to the concurrent table.
+ * @param	index	Index of the searched element.
+ * @return	true if the index exists.
+ */
+bool yctable_index_exists(yctable_t *table, uint64_t index);
+/**
+ * @function	yctable_index_isset
+ *		Tell if a given index exists and is set in a concurrent table.
+ * @param	table	Pointer to the concurrent table.
+ * @param	index	Index of the searched element.
+ * @return	true if the index exists and the associated value is not NULL.
+ */
+bool yctable_index_isset(yctable_t *table, uint64_t index);
+/**
+ * @function	yctable_get_index
+ *		Return the value associated to the given index. If the table has a delete
+ *		function, the data could be deleted by another thread as soon as the
+ *		function returns; use yctable_read_begin() to use it safely.
+ * @param	table	Pointer to the concurrent table.
+ * @param	index	Index of the element.
+ * @return	YENOERR if the element exists, and a pointer to the element's data.
+ *		YEINVAL if the table doesn't exist.
+ *		YEUNDEF if the index doesn't exist.
+ */
+yres_pointer_t yctable_get_index(yctable_t *table, uint64_t index);
+/**
+ * @function	yctable_get_index_data
+ *		Return the data value associated to the given index. See yctable_get_index().
+ * @param	table	Pointer to the concurrent table.
+ * @param	index	Index of the element.
+ * @return	A pointer to the element's data, or NULL if the element doesn't exist.
+ */
+void *yctable_get_index_data(yctable_t *table, uint64_t index);
+/**
+ * @function	yctable_get_indexes_batch
+ *		Return the data values associated to a list of indexes, all read from the
+ *		same version of a concurrent table. See ytable_get_indexes_batch() and
+ *		yctable_get_index().
+ * @param	table	Pointer to the concurrent table.
+ * @param	count	Number of indexes.
+ * @param	indexes	Array of indexes.
+ * @param	results	Array of (at least) count pointers, filled with the data of the
+ *			elements, or NULL for the elements which don't exist.
+ * @return	The number of elements found.
+ */
+uint32_t yctable_get_indexes_batch(yctable_t *table, uint32_t count, const uint64_t *indexes,
+                                   void **results);
+/**
+ * @function	yctable_key_exists
+ *		Tell if a given string key exists in a concurrent table.
+ * @param	table	Pointer to the concurrent table.
+ * @param	key	String key of the searched element.
+ * @return	true if the string key exists.
+ */
+bool yctable_key_exists(yctable_t *table, const char *key);
+/**
+ * @function	yctable_key_isset
+ *		Tell if a given string key exists and is set in a concurrent table.
+ * @param	table	Pointer to the concurrent table.
+ * @param	key	String key of the searched element.
+ * @return	true if the string key exists and the associated value is not NULL.
+ */
+bool yctable_key_isset(yctable_t *table, const char *key);
+/**
+ * @function	yctable_get_key
+ *		Return the value associated to the given string key. If the table has a
+ *		delete function, the data could be deleted by another thread as soon as
+ *		the function returns; use yctable_read_begin() to use it safely.
+ * @param	table	Pointer to the concurrent table.
+ * @param	key	String key of the searched element.
+ * @return	YENOERR if the element exists, and a pointer to the element's data.
+ *		YEINVAL if the table doesn't exist.
+ *		YEUNDEF if the key doesn't exist.
+ */
+yres_pointer_t yctable_get_key(yctable_t *table, const char *key);
+/**
+ * @function	yctable_get_key_data
+ *		Return the data value associated to the given string key. See
+ *		yctable_get_key().
+ * @param	table	Pointer to the concurrent table.
+ * @param	key	String key of the searched element.
+ * @return	A pointer to the element's data, or NULL if the element doesn't exist.
+ */
+void *yctable_get_key_data(yctable_t *table, const char *key);
+/**
+ * @function	yctable_get_keys_batch
+ *		Return the data values associated to a list of string keys, all read from
+ *		the same version of a concurrent table. See ytable_get_keys_batch() and
+ *		yctable_get_key().
+ * @param	table	Pointer to the concurrent table.
+ * @param	count	Number of keys.
+ * @param	keys	Array of string keys.
+ * @param	results	Array of (at least) count pointers, filled with the data of the
+ *			elements, or NULL for the keys which don't exist.
+ * @return	The number of elements found.
+ */
+uint32_t yctable_get_keys_batch(yctable_t *table, uint32_t count, const char **keys,
+                                void **results);
+/**
+ * @function	yctable_foreach
+ *		Apply a function on every elements of a concurrent table. The elements are
+ *		those of the version of the table current when the function is called; they
+ *		are not deleted before the end of the loop. The loop is a read section, so
+ *		the function must be quick (writers wait for its end) and must not modify
+ *		the concurrent table (it would wait for itself).
+ * @param	table		Pointer to the concurrent table.
+ * @param	func		Pointer to the callback function.
+ * @param	user_data	Pointer to some user data.
+ * @return	YENOERR if the callback returned YENOERR for all elements.
+ *		YEINVAL if the table doesn't exist.
+ */
+ystatus_t yctable_foreach(yctable_t *table, ytable_function_t func, void *user_data);
+
+/* ********** WRITE FUNCTIONS ********** */
+/**
+ * @function	yctable_update
+ *		Modify a concurrent table. The function is called with a new version of the
+ *		table, which replaces the current one if the function returns YENOERR (the
+ *		modifications are dropped otherwise). Several modifications done by the same
+ *		call cost the copy of the table only once.
+ * @param	table		Pointer to the concurrent table.
+ * @param	func		Pointer to the function which modifies the table.
+ * @param	user_data	Pointer to some data given to the function.
+ * @return	YENOERR if OK.
+ *		YEINVAL if a parameter is NULL.
+ *		YENOMEM if the memory couldn't be allocated.
+ *		Other error code returned by the function.
+ */
+ystatus_t yctable_update(yctable_t *table, yctable_update_function_t func, void *user_data);
+/**
+ * @function	yctable_add
+ *		Add an element at the end of a concurrent table.
+ * @param	table	Pointer to the concurrent table.
+ * @param	data	Pointer to data.
+ * @return	YENOERR if OK.
+ */
+ystatus_t yctable_add(yctable_t *table, void *data);
+/**
+ * @function	yctable_set_index
+ *		Add an element in a concurrent table using an index.
+ * @param	table	Pointer to the concurrent table.
+ * @param	index	Index of the element.
+ * @param	data	Pointer to the data.
+ * @return	YENOERR if OK.
+ */
+ystatus_t yctable_set_index(yctable_t *table, uint64_t index, void *data);
+/**
+ * @function	yctable_remove_index
+ *		Remove an element from its index.
+ * @param	table	Pointer to the concurrent table.
+ * @param	index	Index of the element.
+ * @return	YENOERR if OK.
+ *		YEUNDEF if the index doesn't exist.
+ */
+ystatus_t yctable_remove_index(yctable_t *table, uint64_t index);
+/**
+ * @function	yctable_set_key
+ *		Add an element in a concurrent table using a string key.
+ * @param	table	Pointer to the concurrent table.
+ * @param	key	String key of the element.
+ * @param	data	Pointer to the data.
+ * @return	YENOERR if OK.
+ */
+ystatus_t yctable_set_key(yctable_t *table, const char *key, void *data);
+
+#if defined(__cplusplus) || defined(c_plusplus)
+}
+#endif /* __cplusplus || c_plusplus */
@@ -1,5 +1,30 @@
-#include "yhash.h"
+#include <pthread.h>
+#include <sys/random.h>
+#include <time.h>
+#include <unistd.h>
+#include "y.h"
 
+/* ************ PRIVATE DEFINITIONS AND MACROS ************ */
+/** @typedef _yhash_uint128_t Unsigned 128-bit integer, used for 64x64 bits multiplications. */
+__extension__ typedef unsigned __int128 _yhash_uint128_t;
+
+/* ************ PRIVATE VARIABLES ************ */
+/** @var _yhash_secret Default secret values of the wyhash algorithm. */
+static const uint64_t _yhash_secret[4] = {
+	0x2d358dccaa6c78a5ULL, 0x8bb84b93962eacc9ULL, 0x4b33a62ed433d4a3ULL, 0x4d5a2da51de1aa47ULL
+};
+/** @var _yhash_seed_value Process-wide seed. */
+static uint64_t _yhash_seed_value;
+/** @var _yhash_seed_once Used to initialize the process-wide seed only once. */
+static pthread_once_t _yhash_seed_once = PTHREAD_ONCE_INIT;
+
+/* ********** DECLARATION OF PRIVATE FUNCTIONS ********** */
+static inline uint64_t _yhash_mix(uint64_t a, uint64_t b);
+static inline uint64_t _yhash_read8(const uint8_t *p);
+static inline uint64_t _yhash_read4(const uint8_t *p);
+static void _yhash_seed_init(void);
+
+/* ********** PUBLIC FUNCTIONS ********** */
 /*
  * yhash_compute()
  * Compute the hash value of a string, using the SDBM algorithm.
@@ -11,4 +36,138 @@ yhash_value_t yhash_compute(const char *key) {
 		hash_value = *key + (hash_value << 6) + (hash_value << 16) - hash_value;
 	return (hash_value);
 }
+/* Compute the 64-bit hash value of some data (wyhash algorithm). */
+uint64_t yhash64(const void *data, size_t len, uint64_t seed) {
+	const uint8_t *p = data;
+	uint64_t a, b;
+
+	seed ^= _yhash_mix(seed ^ _yhash_secret[0], _yhash_secret[1]);
+	if (len <= 16) {
+		if (len >= 4) {
+			a = (_yhash_read4(p) << 32) | _yhash_read4(p + ((len >> 3) << 2));
+			b = (_yhash_read4(p + len - 4) << 32) |
+			    _yhash_read4(p + len - 4 - ((len >> 3) << 2));
+		} else if (len) {
+			a = ((uint64_t)p[0] << 16) | ((uint64_t)p[len >> 1] << 8) | p[len - 1];
+			b = 0;
+		} else
+			a = b = 0;
+	} else {
+		size_t i = len;
+		if (i >= 48) {
+			// three independent lanes
+			uint64_t see1 = seed, see2 = seed;
+			do {
+				seed = _yhash_mix(_yhash_read8(p) ^ _yhash_secret[1],
+				                  _yhash_read8(p + 8) ^ seed);
+				see1 = _yhash_mix(_yhash_read8(p + 16) ^ _yhash_secret[2],
+				                  _yhash_read8(p + 24) ^ see1);
+				see2 = _yhash_mix(_yhash_read8(p + 32) ^ _yhash_secret[3],
+				                  _yhash_read8(p + 40) ^ see2);
+				p += 48;
+				i -= 48;
+			} while (i >= 48);
+			seed ^= see1 ^ see2;
+		}
+		while (i > 16) {
+			seed = _yhash_mix(_yhash_read8(p) ^ _yhash_secret[1], _yhash_read8(p + 8) ^ seed);
+			i -= 16;
+			p += 16;
+		}
+		// last 16 bytes (could overlap already processed bytes)
+		a = _yhash_read8(p + i - 16);
+		b = _yhash_read8(p + i - 8);
+	}
+	_yhash_uint128_t r = (_yhash_uint128_t)(a ^ _yhash_secret[1]) * (b ^ seed);
+	return (_yhash_mix((uint64_t)r ^ _yhash_secret[0] ^ len, (uint64_t)(r >> 64) ^ _yhash_secret[1]));
+}
+/* Compute the 64-bit hash value of a string. */
+uint64_t yhash64_str(const char *key, uint64_t seed) {
+	return (yhash64(key, strlen(key), seed));
+}
+/* Compute the hash value of some data, using the SDBM algorithm. */
+uint64_t yhash_sdbm(const void *data, size_t len, uint64_t seed) {
+	const char *pt = data;
+	yhash_value_t hash_value = (yhash_value_t)seed;
+
+	for (size_t i = 0; i < len; ++i)
+		hash_value = pt[i] + (hash_value << 6) + (hash_value << 16) - hash_value;
+	return (hash_value);
+}
+/* Return the process-wide seed. */
+uint64_t yhash_seed(void) {
+	pthread_once(&_yhash_seed_once, _yhash_seed_init);
+	return (_yhash_seed_value);
+}
+/* Compute the default hash value of a string key. */
+uint64_t yhash_string(const char *key) {
+	return (yhash64(key, strlen(key), yhash_seed()));
+}
+#ifdef USE_HASH_STATS
+/* Fill the counter fields of hash statistics. */
+void yhash_stats_fill(yhash_stats_t *stats, const yhash_counters_t *counters) {
+	stats->resizes = __atomic_load_n(&counters->resizes, __ATOMIC_RELAXED);
+	stats->shrinks = __atomic_load_n(&counters->shrinks, __ATOMIC_RELAXED);
+	stats->lookups = __atomic_load_n(&counters->lookups, __ATOMIC_RELAXED);
+	stats->probes = __atomic_load_n(&counters->probes, __ATOMIC_RELAXED);
+	stats->average_probes = stats->lookups ? ((double)stats->probes / stats->lookups) : 0.0;
+}
+/* Write hash statistics in the logs. */
+void yhash_stats_log(const char *name, const yhash_stats_t *stats) {
+	char histogram[YHASH_STATS_HISTOGRAM_SIZE * 32] = "";
+	size_t len = 0;
 
+	if (!stats)
+		return;
+	name = name ? name : "hash";
+	YLOG_ADD(YLOG_INFO, "%s: %zu elements, %zu slots, load factor %.3f, %zu bytes",
+	         name, stats->length, stats->size, stats->load_factor, stats->bytes);
+	YLOG_ADD(YLOG_INFO, "%s: %" PRIu64 " resizes, %" PRIu64 " shrinks, %" PRIu64
+	         " lookups, %.3f probes per lookup", name, stats->resizes, stats->shrinks,
+	         stats->lookups, stats->average_probes);
+	// only the non-empty entries of the histogram are written
+	for (size_t i = 0; i < YHASH_STATS_HISTOGRAM_SIZE; ++i) {
+		if (!stats->histogram[i])
+			continue;
+		len += snprintf(histogram + len, sizeof(histogram) - len, " %zu%s:%zu", i,
+		                (i == YHASH_STATS_HISTOGRAM_SIZE - 1) ? "+" : "",
+		                stats->histogram[i]);
+	}
+	YLOG_ADD(YLOG_INFO, "%s: histogram%s", name, histogram);
+}
+#endif /* USE_HASH_STATS */
+
+/* ********** PRIVATE FUNCTIONS ********** */
+/*
+ * Multiply two 64-bit values and fold the 128-bit result.
+ * @param	a	First value.
+ * @param	b	Second value.
+ * @return	The xor of the low and high halves of the product.
+ */
+static inline uint64_t _yhash_mix(uint64_t a, uint64_t b) {
+	_yhash_uint128_t r = (_yhash_uint128_t)a * b;
+	return ((uint64_t)r ^ (uint64_t)(r >> 64));
+}
+/* Read 8 bytes from an unaligned pointer. */
+static inline uint64_t _yhash_read8(const uint8_t *p) {
+	uint64_t v;
+	memcpy(&v, p, sizeof(v));
+	return (v);
+}
+/* Read 4 bytes from an unaligned pointer. */
+static inline uint64_t _yhash_read4(const uint8_t *p) {
+	uint32_t v;
+	memcpy(&v, p, sizeof(v));
+	return (v);
+}
+/* Initialize the process-wide seed, from the system's random source if possible. */
+static void _yhash_seed_init(void) {
+	uint64_t seed = 0;
+	if (getrandom(&seed, sizeof(seed), GRND_NONBLOCK) != sizeof(seed)) {
+		struct timespec ts;
+		clock_gettime(CLOCK_REALTIME, &ts);
+		seed = ((uint64_t)ts.tv_sec << 32) ^ (uint64_t)ts.tv_nsec ^
+		       ((uint64_t)getpid() << 16) ^ (uint64_t)(uintptr_t)&ts;
+	}
+	_yhash_seed_value = yhash_mix64(seed);
+}
@@ -26,10 +26,77 @@
 extern "C" {
 #endif /* __cplusplus || c_plusplus */
 
-#include "y.h"
+#include <stdint.h>
+#include <stddef.h>
 
 /** @typedef yhash_value_t	Type of a hash result. */
 typedef uint32_t yhash_value_t;
+/**
+ * @typedef	yhash_function_t
+ *		Pointer to a seeded 64-bit hash function, used by ytable, yhashmap and
+ *		yhashtable to hash their string keys.
+ * @param	data	Pointer to the data to hash.
+ * @param	len	Size of the data.
+ * @param	seed	Seed value.
+ * @return	The computed hash value.
+ */
+typedef uint64_t (*yhash_function_t)(const void *data, size_t len, uint64_t seed);
+
+#ifdef USE_HASH_STATS
+/** @define YHASH_STATS_HISTOGRAM_SIZE Number of entries of the histograms of hash statistics. */
+#define YHASH_STATS_HISTOGRAM_SIZE	16
+/**
+ * @typedef	yhash_counters_t
+ *		Counters updated by ytable, yhashmap and yhashtable, when the library is
+ *		compiled with USE_HASH_STATS. They are updated with relaxed atomic operations,
+ *		because lock-free readers (see yctable.h) search the same table at once.
+ * @field	resizes	Number of times the hash index (or the array of slots or buckets) was grown.
+ * @field	shrinks	Number of times it was shrunk.
+ * @field	lookups	Number of key searches.
+ * @field	probes	Number of groups of slots (ytable), slots (yhashmap) or elements
+ *			(yhashtable) visited by the key searches.
+ */
+typedef struct {
+	uint64_t resizes;
+	uint64_t shrinks;
+	uint64_t lookups;
+	uint64_t probes;
+} yhash_counters_t;
+/**
+ * @typedef	yhash_stats_t
+ *		Statistics of a hash container. See ytable_stats(), yhashmap_stats() and
+ *		yhashtable_stats().
+ * @field	length		Number of elements.
+ * @field	size		Number of slots (ytable, yhashmap) or buckets (yhashtable).
+ * @field	load_factor	Number of hashed elements divided by the size.
+ * @field	histogram	Number of buckets containing N elements (yhashtable), or number
+ *				of elements found after visiting N slots (yhashmap) or N groups
+ *				of slots (ytable). The last entry counts all the greater values.
+ * @field	resizes		Number of times the container was grown.
+ * @field	shrinks		Number of times the container was shrunk.
+ * @field	lookups		Number of key searches.
+ * @field	probes		Number of slots, groups of slots or elements visited by the searches.
+ * @field	average_probes	Average number of probes per search.
+ * @field	bytes		Memory used by the container (the keys and data excepted).
+ */
+typedef struct {
+	size_t length;
+	size_t size;
+	double load_factor;
+	size_t histogram[YHASH_STATS_HISTOGRAM_SIZE];
+	uint64_t resizes;
+	uint64_t shrinks;
+	uint64_t lookups;
+	uint64_t probes;
+	double average_probes;
+	size_t bytes;
+} yhash_stats_t;
+/** @define YHASH_COUNT Add a value to a counter of a hash container. */
+#define YHASH_COUNT(counters, field, n)	\
+	((void)__atomic_fetch_add(&(counters).field, (uint64_t)(n), __ATOMIC_RELAXED))
+#else
+#define YHASH_COUNT(counters, field, n)	((void)0)
+#endif /* USE_HASH_STATS */
 
 /**
  * @function	yhash_compute
@@ -40,6 +107,88 @@ typedef uint32_t yhash_value_t;
  * @return	The computed hash value.
  */
 yhash_value_t yhash_compute(const char *key);
+/**
+ * @function	yhash64
+ *		Compute the 64-bit hash value of some data, using the wyhash algorithm
+ *		(fast, and with a good distribution even on keys sharing long prefixes).
+ *		The data doesn't need to be NUL-terminated.
+ * @see		https://github.com/wangyi-fudan/wyhash
+ * @param	data	Pointer to the data to hash.
+ * @param	len	Size of the data.
+ * @param	seed	Seed value.
+ * @return	The computed hash value.
+ */
+uint64_t yhash64(const void *data, size_t len, uint64_t seed);
+/**
+ * @function	yhash64_str
+ *		Compute the 64-bit hash value of a NUL-terminated string, using yhash64().
+ * @param	key	The string to hash.
+ * @param	seed	Seed value.
+ * @return	The computed hash value.
+ */
+uint64_t yhash64_str(const char *key, uint64_t seed);
+/**
+ * @function	yhash_sdbm
+ *		Compute the hash value of some data using the SDBM algorithm, with the
+ *		signature of a yhash_function_t. The seed is used as the initial value.
+ *		With a zero seed, the result is the same as yhash_compute().
+ * @param	data	Pointer to the data to hash.
+ * @param	len	Size of the data.
+ * @param	seed	Seed value.
+ * @return	The computed hash value.
+ */
+uint64_t yhash_sdbm(const void *data, size_t len, uint64_t seed);
+/**
+ * @function	yhash_seed
+ *		Return the process-wide seed used by default to hash string keys. It is
+ *		randomly chosen on first call, so keys could not be crafted to collide
+ *		(hash flooding).
+ * @return	The seed value.
+ */
+uint64_t yhash_seed(void);
+/**
+ * @function	yhash_string
+ *		Compute the default hash value of a string key, as used by ytable, yhashmap
+ *		and yhashtable when no other hash function was set (yhash64() with the
+ *		process-wide seed).
+ * @param	key	The string to hash.
+ * @return	The computed hash value.
+ */
+uint64_t yhash_string(const char *key);
+#ifdef USE_HASH_STATS
+/**
+ * @function	yhash_stats_fill
+ *		Fill the counter fields of a statistics structure, and compute the average
+ *		number of probes per search.
+ * @param	stats		Pointer to the statistics.
+ * @param	counters	Pointer to the counters of the hash container.
+ */
+void yhash_stats_fill(yhash_stats_t *stats, const yhash_counters_t *counters);
+/**
+ * @function	yhash_stats_log
+ *		Write the statistics of a hash container in the logs (see ylog.h), with the
+ *		informational priority.
+ * @param	name	Name of the container, written at the beginning of the log lines.
+ * @param	stats	Pointer to the statistics.
+ */
+void yhash_stats_log(const char *name, const yhash_stats_t *stats);
+#endif /* USE_HASH_STATS */
+/**
+ * @function	yhash_mix64
+ *		Mix the bits of an integer (murmur3 finalizer). It is a bijection, so
+ *		different integers always give different results. Useful to spread
+ *		numeric keys over a power-of-2 number of buckets.
+ * @param	value	The integer to mix.
+ * @return	The mixed value.
+ */
+static inline uint64_t yhash_mix64(uint64_t value) {
+	value ^= value >> 33;
+	value *= 0xff51afd7ed558ccdULL;
+	value ^= value >> 33;
+	value *= 0xc4ceb9fe1a85ec53ULL;
+	value ^= value >> 33;
+	return (value);
+}
 
 #if defined(__cplusplus) || defined(c_plusplus)
 }
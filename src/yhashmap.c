@@ -13,9 +13,14 @@
 #define YHM_MAX_LOAD_FACTOR	0.7
 /** @define YHM_MIN_LOAD_FACTOR Minimum load factor before reducing a hash map. */
 #define YHM_MIN_LOAD_FACTOR	0.25
+/** @define _YHASHMAP_DISTANCE Distance between the slot of an element and the slot given by its hash value. */
+#define _YHASHMAP_DISTANCE(hashmap, elem, slot)	(((slot) - (elem)->hash) & ((hashmap)->size - 1))
 
 /* ********** DECLARATION OF PRIVATE FUNCTIONS ********** */
-ystatus_t _yhashmap_clone_bucket(size_t index, void *data, void *user_data);
+static uint64_t _yhashmap_hash(const yhashmap_t *hashmap, const char *key);
+static yhashmap_element_t *_yhashmap_find(yhashmap_t *hashmap, uint64_t hash, const char *key);
+static void _yhashmap_insert(yhashmap_t *hashmap, yhashmap_element_t element);
+static void _yhashmap_remove_slot(yhashmap_t *hashmap, size_t slot);
 
 /* ********** FUNCTIONS ********** */
 /* Create a new hash map. */
@@ -30,56 +35,74 @@ yhashmap_t *yhashmap_create(size_t size, yhashmap_function_t destroy_func, void
 	hash = (yhashmap_t*)malloc0(sizeof(yhashmap_t));
 	if (!hash)
 		return (NULL);
-	hash->buckets = yarray_create(size);
+	hash->elements = (yhashmap_element_t*)calloc0(size, sizeof(yhashmap_element_t));
+	if (!hash->elements) {
+		free0(hash);
+		return (NULL);
+	}
 	hash->size = size;
 	hash->used = 0;
 	hash->destroy_func = destroy_func;
 	hash->destroy_data = destroy_data;
+	hash->hash_function = NULL;
+	hash->hash_seed = 0;
 	return (hash);
 }
 /* Duplicate a hashmap. */
 yhashmap_t *yhashmap_clone(const yhashmap_t *src) {
-	yhashmap_t *dest = (yhashmap_t*)malloc0(sizeof(yhashmap_t));
+	yhashmap_t *dest = yhashmap_create(src->size, NULL, NULL);
 	if (!dest)
 		return (NULL);
-	dest->buckets = yarray_create(yarray_size(src->buckets));
-	if (!dest->buckets) {
-		free0(dest);
-		return (NULL);
-	}
-	ystatus_t st = yarray_foreach(src->buckets, _yhashmap_clone_bucket, dest);
-	if (st != YENOERR) {
-		yhashmap_delete(dest);
-		return (NULL);
-	}
+	// the keys and data are shared, so the destroy function is not copied
+	memcpy(dest->elements, src->elements, src->size * sizeof(yhashmap_element_t));
+	dest->used = src->used;
+	dest->hash_function = src->hash_function;
+	dest->hash_seed = src->hash_seed;
 	return (dest);
 }
-ystatus_t _yhashmap_clone_bucket(size_t index, void *data, void *user_data) {
-	yarray_t src_bucket = (yarray_t)data;
-	yarray_t dest_bucket = yarray_clone(src_bucket);
-	if (!dest_bucket)
+/* Define the hash function of a hash map. */
+ystatus_t yhashmap_set_hash_function(yhashmap_t *hashmap, yhash_function_t hash_function,
+                                     uint64_t seed) {
+	yhashmap_element_t *old_elements;
+
+	if (!hashmap)
+		return (YEINVAL);
+	if (!hashmap->used) {
+		hashmap->hash_function = hash_function;
+		hashmap->hash_seed = seed;
+		return (YENOERR);
+	}
+	// the new array is allocated first, so the hash map is not modified if it fails
+	old_elements = hashmap->elements;
+	hashmap->elements = (yhashmap_element_t*)calloc0(hashmap->size, sizeof(yhashmap_element_t));
+	if (!hashmap->elements) {
+		hashmap->elements = old_elements;
 		return (YENOMEM);
-	yhashmap_t *dest = (yhashmap_t*)user_data;
-	yarray_push(&dest->buckets, dest_bucket);
+	}
+	hashmap->hash_function = hash_function;
+	hashmap->hash_seed = seed;
+	// rehash the elements
+	for (size_t slot = 0; slot < hashmap->size; ++slot) {
+		yhashmap_element_t elem = old_elements[slot];
+		if (!elem.key)
+			continue;
+		elem.hash = _yhashmap_hash(hashmap, elem.key);
+		_yhashmap_insert(hashmap, elem);
+	}
+	free0(old_elements);
 	return (YENOERR);
 }
 /* Destroy an hash map. */
 void yhashmap_delete(yhashmap_t *hashmap) {
-	// remove elements and buckets
-	while (yarray_length(hashmap->buckets)) {
-		yarray_t bucket = yarray_pop(hashmap->buckets);
-		if (!bucket)
-			continue;
-		while (yarray_length(bucket)) {
-			yhashmap_element_t *elem = yarray_pop(bucket);
-			if (elem && hashmap->destroy_func) {
-				hashmap->destroy_func(elem->key, elem->data,
-				                      hashmap->destroy_data);
-			}
-		}
-		yarray_free(bucket);
+	if (!hashmap)
+		return;
+	// remove elements
+	for (size_t slot = 0; hashmap->destroy_func && slot < hashmap->size; ++slot) {
+		yhashmap_element_t *elem = &hashmap->elements[slot];
+		if (elem->key)
+			hashmap->destroy_func(elem->key, elem->data, hashmap->destroy_data);
 	}
-	yarray_free(hashmap->buckets);
+	free0(hashmap->elements);
 	// remove the hash map itself
 	free0(hashmap);
 }
@@ -97,68 +120,32 @@ size_t yhashmap_size(yhashmap_t *hashmap) {
 }
 /* Add an element to an hash map. */
 void yhashmap_add(yhashmap_t *hashmap, char *key, void *data) {
-	double load_factor;
-	yhash_value_t hash_value;
-	yarray_t *bucket;
 	yhashmap_element_t *element;
+	uint64_t hash_value;
 
-	if (!key)
+	if (!hashmap || !key)
 		return;
+	hash_value = _yhashmap_hash(hashmap, key);
+	// update the element if it already exists
+	if ((element = _yhashmap_find(hashmap, hash_value, key))) {
+		if (hashmap->destroy_func)
+			hashmap->destroy_func(element->key, element->data, hashmap->destroy_data);
+		element->key = key;
+		element->data = data;
+		return;
+	}
 	// resize the map if its load factor will excess the limit
-	load_factor = (double)(hashmap->used + 1) / hashmap->size;
-	if (load_factor > YHM_MAX_LOAD_FACTOR) {
+	if ((double)(hashmap->used + 1) / hashmap->size > YHM_MAX_LOAD_FACTOR)
 		yhashmap_resize(hashmap, (hashmap->size * 2));
-	}
-	// compute the key's hash value
-	hash_value = yhash_compute(key);
-	hash_value %= hashmap->size;
-	// check the bucket
-	bucket = (yarray_t*)&(hashmap->buckets[hash_value]);
-	if (!*bucket) {
-		// create the bucket
-		yarray_t new_bucket = yarray_new();
-		yarray_set(hashmap->buckets, new_bucket, hash_value, NULL, NULL);
-		bucket = &new_bucket;
-	} else {
-		// there is already some elements in the bucket, checking if the
-		// element exists and must be updated
-		for (size_t offset = 0; offset < yarray_length(*bucket); ++offset) {
-			element = (*bucket)[offset];
-			if (element && element->key && !strcmp(key, element->key)) {
-				// an existing element was found with the same key
-				// remove old data
-				if (hashmap->destroy_func) {
-					hashmap->destroy_func(element->key,
-					                      element->data,
-					                      hashmap->destroy_data);
-				}
-				// update the element
-				element->data = data;
-				return;
-			}
-		}
-		// no existing element with this key
-	}
-	// create the element
-	element = (yhashmap_element_t*)malloc0(sizeof(yhashmap_element_t));
-	// filling the element
-	element->key = key;
-	element->data = data;
-	// add the element to the bucket
-	yarray_push(bucket, element);
-	// update the hash map
+	// at least one slot must stay empty (the resize could have failed)
+	if (hashmap->used + 1 >= hashmap->size)
+		return;
+	_yhashmap_insert(hashmap, (yhashmap_element_t){
+		.key = key,
+		.data = data,
+		.hash = hash_value,
+	});
 	hashmap->used++;
-
-	int total = 0;
-	for (size_t i = 0; i < yarray_size(hashmap->buckets); ++i) {
-		yarray_t bucket = hashmap->buckets[i];
-		if (!bucket)
-			continue;
-		for (size_t j = 0; j < yarray_length(bucket); ++j) {
-			if (bucket[j])
-				total++;
-		}
-	}
 }
 /* Search an element in an hash map, and returns its value. */
 void *yhashmap_search(yhashmap_t *hashmap, const char *key) {
@@ -171,129 +158,183 @@ void *yhashmap_search(yhashmap_t *hashmap, const char *key) {
 }
 /* Search an element in a hash map, and return a pointer to the element item. */
 yhashmap_element_t *yhashmap_search_element(yhashmap_t *hashmap, const char *key) {
-	yhash_value_t hash_value;
-	yarray_t bucket;
-	yhashmap_element_t *element;
-
-	if (!key)
-		return (NULL);
-	/* compute the key's hash value */
-	hash_value = yhash_compute(key);
-	hash_value %= hashmap->size;
-	/* retreiving the bucket */
-	bucket = hashmap->buckets[hash_value];
-	if (!*bucket)
+	if (!hashmap || !key || !hashmap->used)
 		return (NULL);
-	size_t len = yarray_length(bucket);
-	if (!len)
-		return (NULL);
-	if (len == 1) {
-		element = bucket[0];
-		if (element && element->key && !strcmp(key, element->key))
-			return (element);
-		return (NULL);
-	}
-	for (size_t offset = 0; offset < len; ++offset) {
-		element = bucket[offset];
-		if (element && element->key && !strcmp(key, element->key))
-			return (element);
-	}
-	return (NULL);
+	return (_yhashmap_find(hashmap, _yhashmap_hash(hashmap, key), key));
 }
 /* Extract an element from an hash map. */
 void *yhashmap_extract(yhashmap_t *hashmap, const char *key) {
-	yhash_value_t hash_value;
-	yarray_t bucket;
 	yhashmap_element_t *element;
-	void *result = NULL;
-	bool found = false;
-	double load_factor;
+	void *result;
 
-	/* compute the key's hash value */
-	hash_value = yhash_compute(key);
-	hash_value %= hashmap->size;
-	/* retreiving the bucket */
-	bucket = &(hashmap->buckets[hash_value]);
-	if (!bucket)
-		return (NULL);
-	size_t len = yarray_length(bucket);
-	if (!len)
+	if (!(element = yhashmap_search_element(hashmap, key)))
 		return (NULL);
-	if (len == 1) {
-		found = true;
-		element = yarray_pop(bucket);
-		if (!element)
-			return (NULL);
-		result = element->data;
-		free0(element);
-		hashmap->used--;
-		return (result);
-	}
-	size_t max_offset = yarray_length(bucket);
-	for (size_t offset = 0; offset < max_offset; ++offset) {
-		element = bucket[offset];
-		if (!element || !element->key || strcmp(key, element->key))
-			continue;
-		found = true;
-		yarray_extract(bucket, offset);
-		result = element->data;
-		free0(element);
-		break;
-	}
-	if (found) {
-		hashmap->used--;
-		// resize the map if its load factor felt under the limit
-		load_factor = (double)(hashmap->used + 1) / hashmap->size;
-		if (load_factor < YHM_MIN_LOAD_FACTOR)
-			yhashmap_resize(hashmap, (hashmap->size / 2));
-	}
+	result = element->data;
+	_yhashmap_remove_slot(hashmap, element - hashmap->elements);
+	hashmap->used--;
+	// resize the map if its load factor felt under the limit
+	if (hashmap->size > _YHASHMAP_DEFAULT_SIZE &&
+	    (double)(hashmap->used + 1) / hashmap->size < YHM_MIN_LOAD_FACTOR)
+		yhashmap_resize(hashmap, (hashmap->size / 2));
 	return (result);
 }
 /* Resize an hashmap. */
 void yhashmap_resize(yhashmap_t *hashmap, size_t size) {
-	yhashmap_t *new_hashmap;
+	yhashmap_element_t *old_elements;
+	size_t old_size;
 
-	if (!hashmap || size < hashmap->used)
+	if (!hashmap)
+		return;
+	size = _YHASHMAP_SIZE(size);
+	// at least one slot must stay empty
+	if (hashmap->used >= size)
+		return;
+	old_elements = hashmap->elements;
+	old_size = hashmap->size;
+	hashmap->elements = (yhashmap_element_t*)calloc0(size, sizeof(yhashmap_element_t));
+	if (!hashmap->elements) {
+		hashmap->elements = old_elements;
 		return;
-	new_hashmap = yhashmap_create(size, hashmap->destroy_func, hashmap->destroy_data);
-	for (size_t i = 0; i < yarray_size(hashmap->buckets); ++i) {
-		yarray_t bucket = hashmap->buckets[i];
-		if (!bucket)
-			continue;
-		while (yarray_length(bucket)) {
-			yhashmap_element_t *elem = yarray_pop(bucket);
-			if (!elem)
-				continue;
-			yhashmap_add(new_hashmap, elem->key, elem->data);
-			free0(elem);
-		}
-		yarray_free(bucket);
 	}
-	yarray_free(hashmap->buckets);
-	// moving data from new hashmap to old hashmap
-	hashmap->size = new_hashmap->size;
-	hashmap->used = new_hashmap->used;
-	hashmap->buckets = new_hashmap->buckets;
-	// free memory
-	free0(new_hashmap);
+	YHASH_COUNT(hashmap->stats, resizes, size > old_size);
+	YHASH_COUNT(hashmap->stats, shrinks, size < old_size);
+	hashmap->size = size;
+	for (size_t slot = 0; slot < old_size; ++slot) {
+		if (old_elements[slot].key)
+			_yhashmap_insert(hashmap, old_elements[slot]);
+	}
+	free0(old_elements);
 }
 /* Apply a function on every elements of an hash map. */
 ystatus_t yhashmap_foreach(yhashmap_t *hashmap, yhashmap_function_t func, void *user_data) {
 	if (!hashmap || !func)
 		return (YENOERR);
-	for (size_t offset = 0; offset < yarray_size(hashmap->buckets); ++offset) {
-		yarray_t bucket = hashmap->buckets[offset];
-		if (!bucket)
+	for (size_t slot = 0; slot < hashmap->size; ++slot) {
+		yhashmap_element_t *elem = &hashmap->elements[slot];
+		if (!elem->key)
 			continue;
-		for (size_t offset2 = 0; offset2 < yarray_length(bucket); ++offset2) {
-			yhashmap_element_t *elem = bucket[offset2];
-			if (!elem)
-				continue;
-			ystatus_t st = func(elem->key, elem->data, user_data);
-			if (st != YENOERR)
-				return (st);
-		}
+		ystatus_t st = func(elem->key, elem->data, user_data);
+		if (st != YENOERR)
+			return (st);
 	}
 	return (YENOERR);
 }
+#ifdef USE_HASH_STATS
+/* Compute the statistics of a hash map. */
+ystatus_t yhashmap_stats(const yhashmap_t *hashmap, yhash_stats_t *stats) {
+	if (!hashmap || !stats)
+		return (YEINVAL);
+	*stats = (yhash_stats_t){
+		.length = hashmap->used,
+		.size = hashmap->size,
+		.load_factor = (double)hashmap->used / hashmap->size,
+		.bytes = sizeof(yhashmap_t) + (hashmap->size * sizeof(yhashmap_element_t)),
+	};
+	yhash_stats_fill(stats, &hashmap->stats);
+	for (size_t slot = 0; slot < hashmap->size; ++slot) {
+		const yhashmap_element_t *elem = &hashmap->elements[slot];
+		if (elem->key)
+			++stats->histogram[MIN(_YHASHMAP_DISTANCE(hashmap, elem, slot) + 1,
+			                       YHASH_STATS_HISTOGRAM_SIZE - 1)];
+	}
+	return (YENOERR);
+}
+#endif /* USE_HASH_STATS */
+/* Remove the current element of an iterator. */
+ystatus_t yhashmap_iterator_remove(yhashmap_iterator_t *it) {
+	if (!it || !it->hashmap || !it->offset)
+		return (YEINVAL);
+	size_t slot = (it->start + it->offset) & (it->hashmap->size - 1);
+	yhashmap_element_t *elem = &it->hashmap->elements[slot];
+	if (!elem->key)
+		return (YEINVAL);
+	if (it->hashmap->destroy_func)
+		it->hashmap->destroy_func(elem->key, elem->data, it->hashmap->destroy_data);
+	// the next elements could be shifted to this slot, which must be visited again
+	_yhashmap_remove_slot(it->hashmap, slot);
+	it->hashmap->used--;
+	it->offset--;
+	return (YENOERR);
+}
+
+/* ********** PRIVATE FUNCTIONS ********** */
+/*
+ * Compute the hash value of a key, using the hash function of a hash map. The result
+ * of custom hash functions is mixed, because the slots are chosen with its low bits.
+ * @param	hashmap	Pointer to the hash map.
+ * @param	key	Key to hash.
+ * @return	The hash value.
+ */
+static uint64_t _yhashmap_hash(const yhashmap_t *hashmap, const char *key) {
+	if (hashmap->hash_function)
+		return (yhash_mix64(hashmap->hash_function(key, strlen(key), hashmap->hash_seed)));
+	return (yhash_string(key));
+}
+/*
+ * Search an element in a hash map. The elements are sorted by distance from their
+ * initial slot (Robin Hood), so the search stops at the first element closer to its
+ * initial slot than the searched one would be.
+ * @param	hashmap	Pointer to the hash map.
+ * @param	hash	Hash value of the key.
+ * @param	key	Key of the element.
+ * @return	A pointer to the element, or NULL if it wasn't found.
+ */
+static yhashmap_element_t *_yhashmap_find(yhashmap_t *hashmap, uint64_t hash, const char *key) {
+	size_t mask = hashmap->size - 1;
+	size_t slot = hash & mask;
+
+	YHASH_COUNT(hashmap->stats, lookups, 1);
+	for (size_t distance = 0; ; ++distance, slot = (slot + 1) & mask) {
+		yhashmap_element_t *elem = &hashmap->elements[slot];
+		YHASH_COUNT(hashmap->stats, probes, 1);
+		if (!elem->key || _YHASHMAP_DISTANCE(hashmap, elem, slot) < distance)
+			return (NULL);
+		if (elem->hash == hash && !strcmp(key, elem->key))
+			return (elem);
+	}
+}
+/*
+ * Insert an element whose key is not already in a hash map, which must have an empty
+ * slot. The element takes the place of the first element closer to its initial slot,
+ * which is then moved further the same way (Robin Hood).
+ * @param	hashmap	Pointer to the hash map.
+ * @param	element	The element to insert.
+ */
+static void _yhashmap_insert(yhashmap_t *hashmap, yhashmap_element_t element) {
+	size_t mask = hashmap->size - 1;
+	size_t slot = element.hash & mask;
+
+	for (size_t distance = 0; ; ++distance, slot = (slot + 1) & mask) {
+		yhashmap_element_t *elem = &hashmap->elements[slot];
+		if (!elem->key) {
+			*elem = element;
+			return;
+		}
+		size_t elem_distance = _YHASHMAP_DISTANCE(hashmap, elem, slot);
+		if (elem_distance < distance) {
+			yhashmap_element_t tmp = *elem;
+			*elem = element;
+			element = tmp;
+			distance = elem_distance;
+		}
+	}
+}
+/*
+ * Empty a slot of a hash map. The next elements which are not in their initial slot
+ * are shifted back, so no search could be stopped by the emptied slot. No element is
+ * moved over an empty slot.
+ * @param	hashmap	Pointer to the hash map.
+ * @param	slot	The slot to empty.
+ */
+static void _yhashmap_remove_slot(yhashmap_t *hashmap, size_t slot) {
+	size_t mask = hashmap->size - 1;
+	size_t next = (slot + 1) & mask;
 
+	while (hashmap->elements[next].key &&
+	       _YHASHMAP_DISTANCE(hashmap, &hashmap->elements[next], next)) {
+		hashmap->elements[slot] = hashmap->elements[next];
+		slot = next;
+		next = (next + 1) & mask;
+	}
+	hashmap->elements[slot] = (yhashmap_element_t){0};
+}
@@ -2,6 +2,10 @@
  * @header	yhashmap.h
  * @abstract	All definitions about hash maps.
  * @discussion  Hash maps are data structures that uses hash function to map values.
+ *		The elements are stored in a single array (open addressing with linear
+ *		probing, Robin Hood insertion and backward shift deletion), with the hash
+ *		value of their key, so most searches read only one cache line and call
+ *		strcmp() only on the matching key.
  * @version     1.0 Aug 13 2012
  * @author      Amaury Bouchard <amaury@amaury.net>
  */
@@ -12,17 +16,20 @@ extern "C" {
 #endif /* __cplusplus || c_plusplus */
 
 #include "yarray.h"
+#include "yhash.h"
 #include "ystatus.h"
 
 /**
  * typedef	yhashmap_element_t
  *		Structure used to store a hash map's element.
- * @field	key	Element's key.
+ * @field	key	Element's key. NULL if the slot is empty.
  * @field	data	Element's data.
+ * @field	hash	Hash value of the key.
  */
 typedef struct {
 	char *key;
 	void *data;
+	uint64_t hash;
 } yhashmap_element_t;
 
 /**
@@ -37,19 +44,47 @@ typedef ystatus_t (*yhashmap_function_t)(char *key, void *data, void *user_data)
 
 /**
  * @typedef	yhashmap_t
- * @field	size		Current size of the hash map.
+ * @field	size		Current number of slots of the hash map (power of 2).
  * @field	used		Current number of elements stored in the hash map.
- * @field	buckets		Array of buckets.
+ * @field	elements	Array of slots.
  * @field	destroy_func	Pointer to the function called when an element is removed.
  * @field	destroy_data	Pointer to some user data given to the destroy function.
+ * @field	hash_function	Function used to hash the keys, or NULL to use yhash_string().
+ * @field	hash_seed	Seed given to the hash function.
+ * @field	stats		Counters of resizes and searches (only if the library is compiled
+ *				with USE_HASH_STATS).
  */
 typedef struct yhashmap_s {
 	size_t size;
 	size_t used;
-	yarray_t buckets;
+	yhashmap_element_t *elements;
 	yhashmap_function_t destroy_func;
 	void *destroy_data;
+	yhash_function_t hash_function;
+	uint64_t hash_seed;
+#ifdef USE_HASH_STATS
+	yhash_counters_t stats;
+#endif /* USE_HASH_STATS */
 } yhashmap_t;
+/**
+ * @typedef	yhashmap_iterator_t
+ *		Iterator on the elements of a hash map, allocated by the caller (usually on
+ *		the stack). See yhashmap_iterator().
+ * @field	hashmap	Pointer to the hash map.
+ * @field	start	Empty slot after which the iteration starts. As no element is moved
+ *			over an empty slot when another one is removed, the removal of the
+ *			current element can't move an already returned element after it.
+ * @field	offset	Number of slots visited after the starting one.
+ * @field	key	Key of the current element.
+ * @field	data	Data of the current element.
+ */
+typedef struct {
+	yhashmap_t *hashmap;
+	size_t start;
+	size_t offset;
+	char *key;
+	void *data;
+} yhashmap_iterator_t;
 
 /* ****************** FUNCTIONS **************** */
 /**
@@ -76,6 +111,20 @@ yhashmap_t *yhashmap_create(size_t size, yhashmap_function_t destroy_func, void
  * @return	The created yhashmap.
  */
 yhashmap_t *yhashmap_clone(const yhashmap_t *src);
+/**
+ * @function	yhashmap_set_hash_function
+ *		Define the function used to hash the keys of a hash map. If the hash map
+ *		already contains elements, they are rehashed.
+ * @param	hashmap		Pointer to the hash map.
+ * @param	hash_function	Pointer to the hash function, or NULL to use the default one
+ *				(yhash_string()).
+ * @param	seed		Seed given to the hash function.
+ * @return	YENOERR if OK.
+ *		YEINVAL if the hash map is NULL.
+ *		YENOMEM if the memory couldn't be allocated (the hash map is not modified).
+ */
+ystatus_t yhashmap_set_hash_function(yhashmap_t *hashmap, yhash_function_t hash_function,
+                                     uint64_t seed);
 /**
  * @function	yhashmap_delete
  *		Destroy a hash map.
@@ -98,7 +147,8 @@ size_t yhashmap_length(yhashmap_t *hashmap);
 size_t yhashmap_size(yhashmap_t *hashmap);
 /**
  * @function	yhashmap_add
- *		Add an element to a hash map.
+ *		Add an element to a hash map. If an element already exists with the same
+ *		key, the destroy function is called on it, and it is replaced.
  * @param	hashmap	Pointer to the hash map.
  * @param	key	Key used to index the element.
  * @param	data	The element's data.
@@ -119,7 +169,8 @@ void *yhashmap_search(yhashmap_t *hashmap, const char *key);
  *		Search an element in a hash map, and returns a pointer to the
  *		element item. Returns NULL if the element doesn't exist. This
  *		function is useful to find an element wich contains the NULL value,
- *		or to chek if an element exists.
+ *		or to chek if an element exists. The pointer is valid until the next
+ *		modification of the hash map.
  * @param	hashmap	Pointer to the hash map.
  * @param	key	Key used to index the element.
  * @return	A pointer to the element's structure.
@@ -135,9 +186,10 @@ yhashmap_element_t *yhashmap_search_element(yhashmap_t *hahsmap, const char *key
 void *yhashmap_extract(yhashmap_t *hashmap, const char *key);
 /**
  * @function	yhashmap_resize
- *		Resize a hash map.
+ *		Resize a hash map. Nothing is done if the new size is too small to contain
+ *		the elements of the hash map.
  * @param	hashmap	Pointer to the hash map.
- * @param	size	The new size.
+ * @param	size	The new size (rounded to the next power of 2).
  */
 void yhashmap_resize(yhashmap_t *hashmap, size_t size);
 /**
@@ -149,6 +201,67 @@ void yhashmap_resize(yhashmap_t *hashmap, size_t size);
  * @return	YENOERR if OK.
  */
 ystatus_t yhashmap_foreach(yhashmap_t *hashmap, yhashmap_function_t func, void *user_data);
+#ifdef USE_HASH_STATS
+/**
+ * @function	yhashmap_stats
+ *		Compute the statistics of a hash map. The histogram gives the number of
+ *		elements found after visiting N slots.
+ * @param	hashmap	Pointer to the hash map.
+ * @param	stats	Pointer to the statistics structure to fill.
+ * @return	YENOERR if OK.
+ *		YEINVAL if a parameter is NULL.
+ */
+ystatus_t yhashmap_stats(const yhashmap_t *hashmap, yhash_stats_t *stats);
+#endif /* USE_HASH_STATS */
+/**
+ * @function	yhashmap_iterator
+ *		Create an iterator on the elements of a hash map. Unlike yhashmap_foreach(),
+ *		no function is called for each element, and the loop could be stopped at any
+ *		time (there is nothing to free).
+ * @param	hashmap	Pointer to the hash map.
+ * @return	The iterator, placed before the first element.
+ */
+static inline yhashmap_iterator_t yhashmap_iterator(yhashmap_t *hashmap) {
+	return ((yhashmap_iterator_t){
+		.hashmap = hashmap,
+	});
+}
+/**
+ * @function	yhashmap_iterator_next
+ *		Move an iterator to the next element of its hash map. The hash map must not be
+ *		modified during the iteration, except with yhashmap_iterator_remove().
+ * @param	it	Pointer to the iterator.
+ * @return	True if the iterator is on an element, false if there is no more element.
+ */
+static inline bool yhashmap_iterator_next(yhashmap_iterator_t *it) {
+	if (!it->hashmap || !it->hashmap->used)
+		return (false);
+	yhashmap_element_t *elements = it->hashmap->elements;
+	size_t mask = it->hashmap->size - 1;
+	// search an empty slot on the first call (there is always one)
+	if (!it->offset)
+		while (elements[it->start].key)
+			++it->start;
+	while (it->offset < mask) {
+		yhashmap_element_t *elem = &elements[(it->start + ++it->offset) & mask];
+		if (!elem->key)
+			continue;
+		it->key = elem->key;
+		it->data = elem->data;
+		return (true);
+	}
+	return (false);
+}
+/**
+ * @function	yhashmap_iterator_remove
+ *		Remove the current element of an iterator from its hash map (the destroy
+ *		function is called on it). The hash map is not resized, so the iteration
+ *		could continue. Must not be called twice on the same element.
+ * @param	it	Pointer to the iterator.
+ * @return	YENOERR if OK.
+ *		YEINVAL if the iterator is not on an element.
+ */
+ystatus_t yhashmap_iterator_remove(yhashmap_iterator_t *it);
 
 #if defined(__cplusplus) || defined(c_plusplus)
 }
@@ -3,13 +3,36 @@
 #include <string.h>
 #include "yhashtable.h"
 
+/* *** private definitions *** */
+/** @define _YHT_ARENA_MIN_SIZE Minimal size of the arena chunks used to allocate the elements. */
+#define _YHT_ARENA_MIN_SIZE	1024
+/**
+ * @define _YHT_MAX_SPLITS Maximum number of buckets split by an addition (at least
+ *			   1 / YHT_MAX_LOAD_FACTOR, for the load factor to stay under its limit).
+ */
+#define _YHT_MAX_SPLITS		2
+/**
+ * @define _YHT_MAX_MERGES Maximum number of buckets merged by a removal (at least
+ *			   1 / YHT_MIN_LOAD_FACTOR, for the load factor to stay over its limit).
+ */
+#define _YHT_MAX_MERGES		4
+
 /* *** definition of private functions *** */
-static bool _yhashtable_remove(yhashtable_t *hashtable, yhash_value_t hash_value,
+static bool _yhashtable_remove(yhashtable_t *hashtable, size_t hash_value,
                                const char *key, bool try_to_destroy);
-static void *_yhashtable_search(yhashtable_t *hashtable, yhash_value_t hash_value,
-                                const char *key);
-static void _yhashtable_add(yhashtable_t *hashtable, yhash_value_t hash_value, char *key,
+static void _yhashtable_remove_element(yhashtable_t *hashtable, yhashtable_element_t *element,
+                                       bool try_to_destroy);
+static yhashtable_element_t *_yhashtable_search(yhashtable_t *hashtable, size_t hash_value,
+                                                const char *key);
+static void _yhashtable_add(yhashtable_t *hashtable, size_t hash_value, char *key,
                             void *data);
+static yhashtable_element_t *_yhashtable_element_new(yhashtable_t *hashtable);
+static size_t _yhashtable_base_size(size_t size);
+static size_t _yhashtable_bucket_index(const yhashtable_t *hashtable, size_t hash_value);
+static void _yhashtable_bucket_append(yhashtable_bucket_t *bucket, yhashtable_element_t *element);
+static bool _yhashtable_split(yhashtable_t *hashtable);
+static bool _yhashtable_merge(yhashtable_t *hashtable);
+static void _yhashtable_element_free(yhashtable_t *hashtable, yhashtable_element_t *element);
 
 /*
  * yhashtable_new()
@@ -19,13 +42,19 @@ yhashtable_t *yhashtable_new(yhashtable_size_t size, yhashtable_function_t destr
 	yhashtable_t *hash;
 
 	hash = malloc0(sizeof(yhashtable_t));
-	hash->buckets = calloc0(size, sizeof(yhashtable_bucket_t));
 	hash->size = size;
+	hash->base_size = _yhashtable_base_size(size);
+	hash->buckets = calloc0((size == hash->base_size) ? size : (hash->base_size * 2),
+	                        sizeof(yhashtable_bucket_t));
 	hash->used = 0;
 	hash->items = NULL;
 	hash->next_offset = 0;
+	hash->arena = NULL;
+	hash->free_elements = NULL;
 	hash->destroy_func = destroy_func;
 	hash->destroy_data = destroy_data;
+	hash->hash_function = NULL;
+	hash->hash_seed = 0;
 	return (hash);
 }
 
@@ -35,29 +64,69 @@ yhashtable_t *yhashtable_new(yhashtable_size_t size, yhashtable_function_t destr
  */
 void yhashtable_delete(yhashtable_t *hashtable) {
 	/* remove elements */
-	if (hashtable->used > 0) {
+	if (hashtable->used > 0 && hashtable->destroy_func != NULL) {
 		size_t offset;
-		yhashtable_list_t *old_item, *item;
 		yhashtable_element_t *element;
 
-		item = hashtable->items;
-		for (offset = 0, item = hashtable->items;
+		for (offset = 0, element = hashtable->items;
 		     offset < hashtable->used;
-		     offset++) {
-			element = item->element;
-			if (hashtable->destroy_func != NULL)
-				hashtable->destroy_func(element->hash_value, element->key, element->data, hashtable->destroy_data);
-			old_item = item;
-			item = item->next;
-			YFREE(old_item);
-			YFREE(element);
-		}
+		     offset++, element = element->list_next)
+			hashtable->destroy_func(element->hash_value, element->key, element->data, hashtable->destroy_data);
 	}
-	/* remove buckets and the hash table itself */
+	/* remove elements' memory, buckets and the hash table itself */
+	yarena_free(hashtable->arena);
 	YFREE(hashtable->buckets);
 	YFREE(hashtable);
 }
 
+/*
+ * yhashtable_set_hash_function
+ * Define the function used to hash the string keys of a hash table.
+ */
+ystatus_t yhashtable_set_hash_function(yhashtable_t *hashtable, yhash_function_t hash_function,
+                                       uint64_t seed) {
+	size_t offset;
+	yhashtable_bucket_t *new_buckets;
+	yhashtable_element_t *element;
+
+	if (hashtable->used == 0) {
+		hashtable->hash_function = hash_function;
+		hashtable->hash_seed = seed;
+		return (YENOERR);
+	}
+	/* the new buckets are allocated first, so the hash table is not modified if it fails */
+	new_buckets = (yhashtable_bucket_t*)YCALLOC((hashtable->size == hashtable->base_size) ?
+	                                            hashtable->size : (hashtable->base_size * 2),
+	                                            sizeof(yhashtable_bucket_t));
+	if (new_buckets == NULL)
+		return (YENOMEM);
+	hashtable->hash_function = hash_function;
+	hashtable->hash_seed = seed;
+	/* rehash the string keys, the split round goes on */
+	for (offset = 0, element = hashtable->items;
+	     offset < hashtable->used;
+	     offset++, element = element->list_next) {
+		if (element->key != NULL)
+			element->hash_value = yhashtable_hash_key(hashtable, element->key);
+		_yhashtable_bucket_append(&(new_buckets[_yhashtable_bucket_index(hashtable,
+		                                                                 element->hash_value)]),
+		                          element);
+	}
+	YFREE(hashtable->buckets);
+	hashtable->buckets = new_buckets;
+	return (YENOERR);
+}
+
+/*
+ * yhashtable_hash_key
+ * Compute the hash value of a string key.
+ */
+size_t yhashtable_hash_key(yhashtable_t *hashtable, const char *key) {
+	if (hashtable->hash_function != NULL)
+		return (hashtable->hash_function(key, strlen(key), hashtable->hash_seed));
+	return (yhash_string(key));
+}
+
 /*
  * yhashtable_add_from_string
  * Add an element to a hash table, using a string key.
@@ -89,6 +158,15 @@ void yhashtable_push_data(yhashtable_t *hashtable, void *data) {
  * Search an element in a hash table, from its string key.
  */
 void *yhashtable_search_from_string(yhashtable_t *hashtable, const char *key) {
+	yhashtable_element_t *element = _yhashtable_search(hashtable, 0, key);
+	return (element ? element->data : NULL);
+}
+
+/*
+ * yhashtable_search_element_from_string
+ * Search an element in a hash table, from its string key, and return the element.
+ */
+yhashtable_element_t *yhashtable_search_element_from_string(yhashtable_t *hashtable, const char *key) {
 	return (_yhashtable_search(hashtable, 0, key));
 }
 
@@ -97,7 +175,8 @@ void *yhashtable_search_from_string(yhashtable_t *hashtable, const char *key) {
  * Search an element in a hash table, from its integer key.
  */
 void *yhashtable_search_from_int(yhashtable_t *hashtable, size_t key) {
-	return (_yhashtable_search(hashtable, key, NULL));
+	yhashtable_element_t *element = _yhashtable_search(hashtable, key, NULL);
+	return (element ? element->data : NULL);
 }
 
 /*
@@ -105,7 +184,8 @@ void *yhashtable_search_from_int(yhashtable_t *hashtable, size_t key) {
  * Search an element in a hash table, from its hashed string key.
  */
 void *yhashtable_search_from_hashed_string(yhashtable_t *hashtable, size_t hash_value, const char *key) {
-	return (_yhashtable_search(hashtable, hash_value, key));
+	yhashtable_element_t *element = _yhashtable_search(hashtable, hash_value, key);
+	return (element ? element->data : NULL);
 }
 
 /*
@@ -118,7 +198,7 @@ void *yhashtable_pop_data(yhashtable_t *hashtable) {
 
 	if (hashtable->items == NULL)
 		return (NULL);
-	element = hashtable->items->previous->element;
+	element = hashtable->items->list_previous;
 	data = element->data;
 	_yhashtable_remove(hashtable, element->hash_value, element->key, false);
 	return (data);
@@ -140,41 +220,62 @@ bool yhashtable_remove_from_int(yhashtable_t *hashtable, size_t key) {
 	return (_yhashtable_remove(hashtable, key, NULL, true));
 }
 
+/*
+ * yhashtable_remove_element
+ * Remove an element from a hash table, using a pointer to the element.
+ */
+void yhashtable_remove_element(yhashtable_t *hashtable, yhashtable_element_t *element) {
+	_yhashtable_remove_element(hashtable, element, true);
+}
+
+/*
+ * yhashtable_move_to_end
+ * Move an element to the end of the list of elements.
+ */
+void yhashtable_move_to_end(yhashtable_t *hashtable, yhashtable_element_t *element) {
+	if (hashtable->items == element) {
+		/* the list is circular: the first element becomes the last one */
+		hashtable->items = element->list_next;
+		return;
+	}
+	if (hashtable->items->list_previous == element)
+		return;
+	/* unlink the element */
+	element->list_next->list_previous = element->list_previous;
+	element->list_previous->list_next = element->list_next;
+	/* insert it before the first element */
+	element->list_next = hashtable->items;
+	element->list_previous = hashtable->items->list_previous;
+	hashtable->items->list_previous->list_next = element;
+	hashtable->items->list_previous = element;
+}
+
 /*
  * yhashtable_resize
  * Resize a hash table.
  */
 void yhashtable_resize(yhashtable_t *hashtable, size_t size) {
-	size_t offset;
-	size_t modulo_value;
-	yhashtable_bucket_t *new_buckets, *bucket;
-	yhashtable_list_t *item;
+	size_t offset, base_size;
+	yhashtable_bucket_t *new_buckets;
 	yhashtable_element_t *element;
 
-	new_buckets = (yhashtable_bucket_t*)YCALLOC(size, sizeof(yhashtable_bucket_t));
-	for (offset = 0, item = hashtable->items;
+	/* the split round goes on from the previous power of 2, so the buckets can be merged */
+	base_size = _yhashtable_base_size(size);
+	new_buckets = (yhashtable_bucket_t*)YCALLOC((size == base_size) ? size : (base_size * 2),
+	                                            sizeof(yhashtable_bucket_t));
+	YHASH_COUNT(hashtable->stats, resizes, size > hashtable->size);
+	YHASH_COUNT(hashtable->stats, shrinks, size < hashtable->size);
+	hashtable->size = size;
+	hashtable->base_size = base_size;
+	for (offset = 0, element = hashtable->items;
 	     offset < hashtable->used;
-	     offset++, item = item->next) {
-		element = item->element;
-		modulo_value = element->hash_value % size;
-		bucket = &(new_buckets[modulo_value]);
-		/* checking the new bucket */
-		if (bucket->nbr_elements == 0) {
-			element->previous = element->next = element;
-			bucket->elements = element;
-		} else {
-			element->next = bucket->elements;
-			element->previous = bucket->elements->previous;
-			bucket->elements->previous->next = element;
-			bucket->elements->previous = element;
-		}
-		bucket->nbr_elements++;
-	}
+	     offset++, element = element->list_next)
+		_yhashtable_bucket_append(&(new_buckets[_yhashtable_bucket_index(hashtable,
+		                                                                 element->hash_value)]),
+		                          element);
 	/* freeing old array of buckets */
 	YFREE(hashtable->buckets);
-	/* swapping buckets */
 	hashtable->buckets = new_buckets;
-	hashtable->size = size;
 }
 
 /*
@@ -183,96 +284,132 @@ void yhashtable_resize(yhashtable_t *hashtable, size_t size) {
  */
 void yhashtable_foreach(yhashtable_t *hashtable, yhashtable_function_t func, void *user_data) {
 	size_t offset;
-	yhashtable_list_t *item;
 	yhashtable_element_t *element;
 
-	for (offset = 0, item = hashtable->items;
+	for (offset = 0, element = hashtable->items;
 	     offset < hashtable->used;
-	     offset++, item = item->next) {
-		element = item->element;
+	     offset++, element = element->list_next) {
 		func(element->hash_value, element->key, element->data, user_data);
 	}
 }
 
+#ifdef USE_HASH_STATS
+/*
+ * yhashtable_stats
+ * Compute the statistics of a hash table.
+ */
+ystatus_t yhashtable_stats(const yhashtable_t *hashtable, yhash_stats_t *stats) {
+	size_t offset;
+
+	if (hashtable == NULL || stats == NULL)
+		return (YEINVAL);
+	*stats = (yhash_stats_t){
+		.length = hashtable->used,
+		.size = hashtable->size,
+		.load_factor = (double)hashtable->used / hashtable->size,
+		.bytes = sizeof(yhashtable_t) +
+		         (((hashtable->size == hashtable->base_size) ? hashtable->size : (hashtable->base_size * 2)) *
+		          sizeof(yhashtable_bucket_t)) +
+		         (hashtable->arena ? hashtable->arena->total : 0),
+	};
+	yhash_stats_fill(stats, &hashtable->stats);
+	for (offset = 0; offset < hashtable->size; offset++)
+		stats->histogram[MIN(hashtable->buckets[offset].nbr_elements,
+		                     YHASH_STATS_HISTOGRAM_SIZE - 1)]++;
+	return (YENOERR);
+}
+#endif /* USE_HASH_STATS */
+
+/*
+ * yhashtable_iterator_remove
+ * Remove the current element of an iterator.
+ */
+bool yhashtable_iterator_remove(yhashtable_iterator_t *it) {
+	if (it == NULL || it->element == NULL)
+		return (false);
+	yhashtable_element_t *element = it->element;
+	it->element = NULL;
+	/* the iterator already points to the next item, the list could be modified */
+	return (_yhashtable_remove(it->hashtable, element->hash_value, element->key, true));
+}
+
 /* ****** PRIVATE FUNCTIONS ******* */
 /**
  * _yhashtable_remove
  * Remove an element from a hash table, using a string or an integer key.
  */
-static bool _yhashtable_remove(yhashtable_t *hashtable, yhash_value_t hash_value,
+static bool _yhashtable_remove(yhashtable_t *hashtable, size_t hash_value,
                                const char *key, bool try_to_destroy) {
-	size_t modulo_value;
-	yhashtable_bucket_t *bucket;
 	yhashtable_element_t *element;
-	yhashtable_list_t *item;
-	size_t offset;
-	bool found = false;
-	float load_factor;
 
 	/* compute the key's hash value */
 	if (key != NULL)
-		hash_value = yhash_compute(key);
-	modulo_value = hash_value % hashtable->size;
-	/* retreiving the bucket */
-	bucket = &(hashtable->buckets[modulo_value]);
-	if (bucket->nbr_elements == 0)
+		hash_value = yhashtable_hash_key(hashtable, key);
+	element = _yhashtable_search(hashtable, hash_value, key);
+	if (element == NULL)
 		return (false);
-	/* searching in the bucket */
-	for (offset = 0, element = bucket->elements;
-	     offset < bucket->nbr_elements;
-	     offset++, element = element->next) {
-		if (element->hash_value == hash_value &&
-		    ((key == NULL && element->key == NULL) ||
-		     (key != NULL && element->key != NULL && !strcmp(key, element->key)))) {
-			found = true;
-			if (try_to_destroy && hashtable->destroy_func != NULL)
-				hashtable->destroy_func(element->hash_value, element->key, element->data, hashtable->destroy_data);
-			item = element->item;
-			if (hashtable->used == 1)
-				YFREE(hashtable->items);
-			else {
-				item->next->previous = item->previous;
-				item->previous->next = item->next;
-				YFREE(item);
-			}
-			if (bucket->nbr_elements == 1)
-				YFREE(bucket->elements);
-			else {
-				element->next->previous = element->previous;
-				element->previous->next = element->next;
-				YFREE(element);
-			}
-			break;
-		}
+	_yhashtable_remove_element(hashtable, element, try_to_destroy);
+	return (true);
+}
+
+/**
+ * _yhashtable_remove_element
+ * Remove an element from its bucket and from the list of elements, then free it.
+ */
+static void _yhashtable_remove_element(yhashtable_t *hashtable, yhashtable_element_t *element,
+                                       bool try_to_destroy) {
+	yhashtable_bucket_t *bucket;
+	int merges;
+
+	if (try_to_destroy && hashtable->destroy_func != NULL)
+		hashtable->destroy_func(element->hash_value, element->key, element->data, hashtable->destroy_data);
+	/* remove the element from the list */
+	if (hashtable->used == 1)
+		hashtable->items = NULL;
+	else {
+		element->list_next->list_previous = element->list_previous;
+		element->list_previous->list_next = element->list_next;
+		if (hashtable->items == element)
+			hashtable->items = element->list_next;
+	}
+	/* remove the element from the bucket */
+	bucket = &(hashtable->buckets[_yhashtable_bucket_index(hashtable, element->hash_value)]);
+	if (bucket->nbr_elements == 1)
+		bucket->elements = NULL;
+	else {
+		element->next->previous = element->previous;
+		element->previous->next = element->next;
+		if (bucket->elements == element)
+			bucket->elements = element->next;
 	}
-	if (found) {
-		bucket->nbr_elements--;
-		hashtable->used--;
-		/* resize the map if its load factor will fall under the limit */
-		load_factor = (float)(hashtable->used + 1) / hashtable->size;
-		if (load_factor < YHT_MIN_LOAD_FACTOR)
-			yhashtable_resize(hashtable, (hashtable->size / 2));
+	_yhashtable_element_free(hashtable, element);
+	bucket->nbr_elements--;
+	hashtable->used--;
+	/* merge buckets while the load factor is under the limit */
+	for (merges = 0;
+	     merges < _YHT_MAX_MERGES && ((float)(hashtable->used + 1) / hashtable->size) < YHT_MIN_LOAD_FACTOR;
+	     merges++) {
+		if (!_yhashtable_merge(hashtable))
+			break;
 	}
-	return (found);
 }
 
 /**
  * _yhashtable_search
  * Search an element in a hash table, using a string or an integer key.
  */
-static void *_yhashtable_search(yhashtable_t *hashtable, yhash_value_t hash_value,
-                                const char *key) {
-	size_t modulo_value;
+static yhashtable_element_t *_yhashtable_search(yhashtable_t *hashtable, size_t hash_value,
+                                                const char *key) {
 	yhashtable_bucket_t *bucket;
 	yhashtable_element_t *element;
 	size_t offset;
 
 	/* compute the key's hash value if necessary */
 	if (hash_value == 0 && key != NULL)
-		hash_value = yhash_compute(key);
-	modulo_value = hash_value % hashtable->size;
+		hash_value = yhashtable_hash_key(hashtable, key);
 	/* retreiving the bucket */
-	bucket = &(hashtable->buckets[modulo_value]);
+	bucket = &(hashtable->buckets[_yhashtable_bucket_index(hashtable, hash_value)]);
+	YHASH_COUNT(hashtable->stats, lookups, 1);
 	if (bucket->nbr_elements == 0)
 		return (NULL);
 	/* searching in the bucket's elements */
@@ -282,9 +419,12 @@ static void *_yhashtable_search(yhashtable_t *hashtable, yhash_value_t hash_valu
 	     offset++, element = element->next) {
 		if (element->hash_value == hash_value &&
 		    ((key == NULL && element->key == NULL) ||
-		     (key != NULL && element->key != NULL && !strcmp(key, element->key))))
-			return (element->data);
+		     (key != NULL && element->key != NULL && !strcmp(key, element->key)))) {
+			YHASH_COUNT(hashtable->stats, probes, offset + 1);
+			return (element);
+		}
 	}
+	YHASH_COUNT(hashtable->stats, probes, bucket->nbr_elements);
 	return (NULL);
 }
 
@@ -292,31 +432,28 @@ static void *_yhashtable_search(yhashtable_t *hashtable, yhash_value_t hash_valu
  * _yhashtable_add
  * Add an element to a hash table, using a string or an integer key.
  */
-static void _yhashtable_add(yhashtable_t *hashtable, yhash_value_t hash_value,
+static void _yhashtable_add(yhashtable_t *hashtable, size_t hash_value,
                             char *key, void *data) {
-	float load_factor;
-	size_t modulo_value;
+	int splits;
 	yhashtable_bucket_t *bucket;
 	yhashtable_element_t *element;
-	yhashtable_list_t *item;
 
-	/* resize the table if its load factor would excess the limit */
-	load_factor = (float)(hashtable->used + 1) / hashtable->size;
-	if (load_factor > YHT_MAX_LOAD_FACTOR)
-		yhashtable_resize(hashtable, (hashtable->size * 2));
+	/* split buckets while the load factor would excess the limit */
+	for (splits = 0;
+	     splits < _YHT_MAX_SPLITS && ((float)(hashtable->used + 1) / hashtable->size) > YHT_MAX_LOAD_FACTOR;
+	     splits++) {
+		if (!_yhashtable_split(hashtable))
+			break;
+	}
 	/* compute the key's hash value */
 	if (key != NULL)
-		hash_value = yhash_compute(key);
-	modulo_value = hash_value % hashtable->size;
+		hash_value = yhashtable_hash_key(hashtable, key);
 	/* checking the bucket */
-	bucket = &(hashtable->buckets[modulo_value]);
+	bucket = &(hashtable->buckets[_yhashtable_bucket_index(hashtable, hash_value)]);
 	if (bucket->nbr_elements == 0) {
 		/* create the first element */
-		element = malloc0(sizeof(yhashtable_element_t));
-		item = malloc0(sizeof(yhashtable_list_t));
-		element->previous = element->next = element;
-		/* add the element to the bucket */
-		bucket->elements = element;
+		if ((element = _yhashtable_element_new(hashtable)) == NULL)
+			return;
 	} else {
 		/* there is already some elements in the bucket, checking if the element exists and must be updated */
 		size_t	offset;
@@ -338,33 +475,180 @@ static void _yhashtable_add(yhashtable_t *hashtable, yhash_value_t hash_value,
 			}
 		}
 		/* no element was already existing with this key */
-		element = malloc0(sizeof(yhashtable_element_t));
-		item = malloc0(sizeof(yhashtable_list_t));
-		/* add the element to the bucket */
-		element->next = bucket->elements;
-		element->previous = bucket->elements->previous;
-		bucket->elements->previous->next = element;
-		bucket->elements->previous = element;
+		if ((element = _yhashtable_element_new(hashtable)) == NULL)
+			return;
 	}
-	/* filling the element and the item */
+	/* filling the element */
 	element->hash_value = hash_value;
 	element->key = key;
 	element->data = data;
-	element->item = item;
-	item->element = element;
-	/* update the bucket */
-	bucket->nbr_elements++;
+	/* add the element to the bucket */
+	_yhashtable_bucket_append(bucket, element);
 	/* update the hash table */
 	hashtable->used++;
-	/* add the item to the list */
+	/* add the element to the list */
 	if (hashtable->items == NULL) {
-		hashtable->items = item;
-		item->next = item->previous = item;
+		hashtable->items = element;
+		element->list_next = element->list_previous = element;
 	} else {
-		item->next = hashtable->items;
-		item->previous = hashtable->items->previous;
-		hashtable->items->previous->next = item;
-		hashtable->items->previous = item;
+		element->list_next = hashtable->items;
+		element->list_previous = hashtable->items->list_previous;
+		hashtable->items->list_previous->list_next = element;
+		hashtable->items->list_previous = element;
 	}
 }
 
+/*
+ * _yhashtable_element_new
+ * Allocate an element, reusing a removed one if possible. The arena is created on the
+ * first allocation, with chunks big enough for as many elements as the table has buckets.
+ */
+static yhashtable_element_t *_yhashtable_element_new(yhashtable_t *hashtable) {
+	yhashtable_element_t *element;
+
+	if (hashtable->free_elements != NULL) {
+		element = hashtable->free_elements;
+		hashtable->free_elements = element->next;
+		return (element);
+	}
+	if (hashtable->arena == NULL) {
+		size_t chunk_size = MIN(hashtable->size * sizeof(yhashtable_element_t),
+		                        YARENA_DEFAULT_CHUNK_SIZE);
+		hashtable->arena = yarena_new(MAX(chunk_size, _YHT_ARENA_MIN_SIZE));
+		if (hashtable->arena == NULL)
+			return (NULL);
+	}
+	return (yarena_alloc(hashtable->arena, sizeof(yhashtable_element_t)));
+}
+
+/*
+ * _yhashtable_element_free
+ * Put a removed element in the list of free elements.
+ */
+static void _yhashtable_element_free(yhashtable_t *hashtable, yhashtable_element_t *element) {
+	element->next = hashtable->free_elements;
+	hashtable->free_elements = element;
+}
+
+
+/*
+ * _yhashtable_base_size
+ * Return the number of buckets at the beginning of the split round of a given size: the
+ * highest power of 2 lower than or equal to the size.
+ */
+static size_t _yhashtable_base_size(size_t size) {
+	size_t base_size = 1;
+
+	while (base_size <= (size / 2))
+		base_size *= 2;
+	return (base_size);
+}
+
+/*
+ * _yhashtable_bucket_index
+ * Return the index of the bucket of a hash value. Buckets already split during the
+ * current round use the modulo of the next round.
+ */
+static size_t _yhashtable_bucket_index(const yhashtable_t *hashtable, size_t hash_value) {
+	size_t index = hash_value % hashtable->base_size;
+
+	if (index < (hashtable->size - hashtable->base_size))
+		index = hash_value % (hashtable->base_size * 2);
+	return (index);
+}
+
+/*
+ * _yhashtable_bucket_append
+ * Add an element at the end of a bucket.
+ */
+static void _yhashtable_bucket_append(yhashtable_bucket_t *bucket, yhashtable_element_t *element) {
+	if (bucket->nbr_elements == 0) {
+		element->previous = element->next = element;
+		bucket->elements = element;
+	} else {
+		element->next = bucket->elements;
+		element->previous = bucket->elements->previous;
+		bucket->elements->previous->next = element;
+		bucket->elements->previous = element;
+	}
+	bucket->nbr_elements++;
+}
+
+/*
+ * _yhashtable_split
+ * Add a bucket to a hash table, by splitting the next bucket of the current round
+ * between itself and the new bucket. The array of buckets is doubled when a round
+ * begins, but no element is moved at that time.
+ * @return	false if the array of buckets couldn't be reallocated.
+ */
+static bool _yhashtable_split(yhashtable_t *hashtable) {
+	size_t base_size = hashtable->base_size;
+	size_t split = hashtable->size - base_size;
+	yhashtable_bucket_t *bucket;
+	yhashtable_element_t *element, *next;
+	size_t count;
+
+	if (split == 0) {
+		yhashtable_bucket_t *buckets = realloc0(hashtable->buckets,
+		                                        base_size * 2 * sizeof(yhashtable_bucket_t));
+		if (buckets == NULL)
+			return (false);
+		hashtable->buckets = buckets;
+	}
+	/* move the elements of the split bucket */
+	bucket = &(hashtable->buckets[split]);
+	element = bucket->elements;
+	count = bucket->nbr_elements;
+	*bucket = (yhashtable_bucket_t){0};
+	hashtable->buckets[split + base_size] = (yhashtable_bucket_t){0};
+	for (; count > 0; count--, element = next) {
+		next = element->next;
+		_yhashtable_bucket_append(&(hashtable->buckets[element->hash_value % (base_size * 2)]),
+		                          element);
+	}
+	hashtable->size++;
+	/* end of the round */
+	if (hashtable->size == (base_size * 2)) {
+		hashtable->base_size = hashtable->size;
+		YHASH_COUNT(hashtable->stats, resizes, 1);
+	}
+	return (true);
+}
+
+/*
+ * _yhashtable_merge
+ * Remove a bucket from a hash table, by merging the last split bucket into the bucket
+ * it was split from. The array of buckets is halved when a round is undone.
+ * @return	false if the hash table is already at its minimal size.
+ */
+static bool _yhashtable_merge(yhashtable_t *hashtable) {
+	yhashtable_bucket_t *bucket, *last;
+	yhashtable_element_t *element, *next;
+	size_t count;
+
+	if (hashtable->size <= YHT_SIZE_NANO)
+		return (false);
+	/* go back to the previous round */
+	if (hashtable->size == hashtable->base_size) {
+		if (hashtable->base_size % 2)
+			return (false);
+		hashtable->base_size /= 2;
+		YHASH_COUNT(hashtable->stats, shrinks, 1);
+	}
+	hashtable->size--;
+	/* move the elements of the last bucket */
+	bucket = &(hashtable->buckets[hashtable->size - hashtable->base_size]);
+	last = &(hashtable->buckets[hashtable->size]);
+	for (count = last->nbr_elements, element = last->elements; count > 0; count--, element = next) {
+		next = element->next;
+		_yhashtable_bucket_append(bucket, element);
+	}
+	*last = (yhashtable_bucket_t){0};
+	if (hashtable->size == hashtable->base_size) {
+		yhashtable_bucket_t *buckets = realloc0(hashtable->buckets,
+		                                        hashtable->size * sizeof(yhashtable_bucket_t));
+		if (buckets != NULL)
+			hashtable->buckets = buckets;
+	}
+	return (true);
+}
@@ -3,6 +3,10 @@
  * @abstract	All definitions about hash tables (like an hashmap, but items are ordered
  *		as their creation order).
  * @discussion  Hash tables are data structures that uses hash function to map values.
+ *		They grow and shrink by linear hashing: when the load factor exceeds its
+ *		limits, a single bucket is split (or two buckets are merged), so the cost
+ *		of a resize is spread over the additions and removals instead of rehashing
+ *		all the elements at once.
  * @version     1.0 Aug 14 2012
  * @author      Amaury Bouchard <amaury@amaury.net>
  */
@@ -50,7 +54,10 @@ typedef enum yhashtable_size_e {
  * @field	key		Element's key.
  * @field	data		Element's data.
  * @field	previous	Pointer to the previous element with the same hash value.
- * @field	next		Pointer to the next element with the same hash value.
+ * @field	next		Pointer to the next element with the same hash value (or to the
+ *				next free element, for removed elements).
+ * @field	list_previous	Pointer to the previously created element.
+ * @field	list_next	Pointer to the next created element.
  */
 typedef struct yhashtable_element_s {
 	size_t hash_value;
@@ -58,7 +65,8 @@ typedef struct yhashtable_element_s {
 	void *data;
 	struct yhashtable_element_s *previous;
 	struct yhashtable_element_s *next;
-	struct yhashtable_list_s *item;
+	struct yhashtable_element_s *list_previous;
+	struct yhashtable_element_s *list_next;
 } yhashtable_element_t;
 
 /**
@@ -72,19 +80,6 @@ typedef struct yhashtable_bucket_s {
 	yhashtable_element_t *elements;
 } yhashtable_bucket_t;
 
-/**
- * typedef	yhashtable_list_t
- *		Double linked structure used to list the created elements.
- * @field	element		Pointer to the element.
- * @field	previous	Pointer to the previous list item.
- * @field	next		Pointer to the next list item.
- */
-typedef struct yhashtable_list_s {
-	yhashtable_element_t *element;
-	struct yhashtable_list_s *previous;
-	struct yhashtable_list_s *next;
-} yhashtable_list_t;
-
 /**
  * typedef	yhashtable_function_t
  *		Function pointer, used to apply a procedure to an element.
@@ -97,23 +92,62 @@ typedef void (*yhashtable_function_t)(size_t hash_value, char *key, void *data,
 
 /**
  * @typedef	yhashtable_t
- * @field	size		Current size of the hash table.
+ * @field	size		Current number of buckets in use.
+ * @field	base_size	Number of buckets at the beginning of the current split round (a
+ *				power of 2). The buckets before (size - base_size) were already
+ *				split, using the hash value modulo (base_size * 2).
  * @field	used		Current number of elements stored in the hash table.
  * @field	buckets		Array of buckets.
- * @field	items		List of pointers to the stored elements.
+ * @field	items		First element of the circular list of elements, in creation order.
  * @field	next_offset	Next free hash value.
+ * @field	arena		Arena from which the elements are allocated. They are all freed at
+ *				once when the hash table is deleted.
+ * @field	free_elements	List of removed elements, reused by the next additions.
  * @field	destroy_func	Pointer to the function called when an element is removed.
  * @field	destroy_data	Pointer to some user data given to the destroy function.
+ * @field	hash_function	Function used to hash string keys, or NULL to use yhash_string().
+ * @field	hash_seed	Seed given to the hash function.
+ * @field	stats		Counters of resizes and searches (only if the library is compiled
+ *				with USE_HASH_STATS).
  */
 typedef struct yhashtable_s {
 	size_t size;
+	size_t base_size;
 	size_t used;
 	yhashtable_bucket_t *buckets;
-	yhashtable_list_t *items;
+	yhashtable_element_t *items;
 	size_t next_offset;
+	yarena_t *arena;
+	yhashtable_element_t *free_elements;
 	yhashtable_function_t destroy_func;
 	void *destroy_data;
+	yhash_function_t hash_function;
+	uint64_t hash_seed;
+#ifdef USE_HASH_STATS
+	yhash_counters_t stats;
+#endif /* USE_HASH_STATS */
 } yhashtable_t;
+/**
+ * @typedef	yhashtable_iterator_t
+ *		Iterator on the elements of a hash table (in insertion order), allocated by the
+ *		caller (usually on the stack). See yhashtable_iterator().
+ * @field	hashtable	Pointer to the hash table.
+ * @field	item		Pointer to the next element.
+ * @field	remaining	Number of elements not yet returned.
+ * @field	element		Pointer to the current element.
+ * @field	hash_value	Hash value of the current element.
+ * @field	key		Key of the current element. Null if it was inserted using an integer key.
+ * @field	data		Data of the current element.
+ */
+typedef struct {
+	yhashtable_t *hashtable;
+	yhashtable_element_t *item;
+	size_t remaining;
+	yhashtable_element_t *element;
+	size_t hash_value;
+	char *key;
+	void *data;
+} yhashtable_iterator_t;
 
 /* ****************** FUNCTIONS **************** */
 /**
@@ -128,11 +162,35 @@ yhashtable_t *yhashtable_new(yhashtable_size_t size, yhashtable_function_t destr
 
 /**
  * @function	yhashtable_delete
- *		Destroy a hash table.
+ *		Destroy a hash table. The destroy function is called on each element, then the
+ *		memory of all the elements is released at once.
  * @param	hash	Pointer to the hash table.
  */
 void yhashtable_delete(yhashtable_t *hashtable);
 
+/**
+ * @function	yhashtable_set_hash_function
+ *		Define the function used to hash the string keys of a hash table. If the hash
+ *		table already contains elements, they are rehashed.
+ * @param	hashtable	Pointer to the hash table.
+ * @param	hash_function	Pointer to the hash function, or NULL to use the default one
+ *				(yhash_string()).
+ * @param	seed		Seed given to the hash function.
+ * @return	YENOERR if OK.
+ *		YENOMEM if the memory couldn't be allocated (the hash table is not modified).
+ */
+ystatus_t yhashtable_set_hash_function(yhashtable_t *hashtable, yhash_function_t hash_function,
+                                       uint64_t seed);
+
+/**
+ * @function	yhashtable_hash_key
+ *		Compute the hash value of a string key, using the hash function of a hash table.
+ * @param	hashtable	Pointer to the hash table.
+ * @param	key		String key.
+ * @return	The hash value.
+ */
+size_t yhashtable_hash_key(yhashtable_t *hashtable, const char *key);
+
 /**
  * @function	yhashtable_add_from_string
  *		Add an element to a hash table, using a string key.
@@ -168,6 +226,16 @@ void yhashtable_push_data(yhashtable_t *hashtable, void *data);
  */
 void *yhashtable_search_from_string(yhashtable_t *hashtable, const char *key);
 
+/**
+ * @function	yhashtable_search_element_from_string
+ *		Search an element in a hash table, from its string key, and return the element
+ *		itself. The pointer is valid until the element is removed.
+ * @param	hashtable	Pointer to the hash table.
+ * @param	key		Key used to index the element.
+ * @return	A pointer to the element, or NULL if it wasn't found.
+ */
+yhashtable_element_t *yhashtable_search_element_from_string(yhashtable_t *hashtable, const char *key);
+
 /**
  * @function	yhashtable_search_from_int
  *		Search an element in a hash table, from its integer key.
@@ -181,7 +249,7 @@ void *yhashtable_search_from_int(yhashtable_t *hashtable, size_t key);
  * @function	yhashtable_search_from_hashed_string
  *		Search an element in a hash table, from its hashed string key.
  * @param	hashtable	Pointer to the hash table.
- * @param	hash_value	Hash value of the string.
+ * @param	hash_value	Hash value of the string (see yhashtable_hash_key()).
  * @param	key		String key used to index the element.
  * @return	A pointer to the element's data.
  */
@@ -213,9 +281,29 @@ bool yhashtable_remove_from_string(yhashtable_t *hashtable, const char *key);
  */
 bool yhashtable_remove_from_int(yhashtable_t *hashtable, size_t key);
 
+/**
+ * @function	yhashtable_remove_element
+ * 		Remove an element from a hash table, without searching it (the destroy function
+ *		is called on it).
+ * @param	hashtable	Pointer to the hash table.
+ * @param	element		Pointer to the element (see yhashtable_search_element_from_string()).
+ */
+void yhashtable_remove_element(yhashtable_t *hashtable, yhashtable_element_t *element);
+
+/**
+ * @function	yhashtable_move_to_end
+ *		Move an element to the end of the list of elements, as if it was the last
+ *		added one. Used to keep the elements ordered by last use (LRU).
+ * @param	hashtable	Pointer to the hash table.
+ * @param	element		Pointer to the element.
+ */
+void yhashtable_move_to_end(yhashtable_t *hashtable, yhashtable_element_t *element);
+
 /**
  * @function	yhashtable_resize
- *		Resize a hash table.
+ *		Resize a hash table, rehashing all its elements at once. Not needed to make
+ *		the table grow or shrink, which is done incrementally (and goes on from the
+ *		new size, whether it is a power of 2 or not).
  * @param	hashtable	Pointer to the hash table.
  * @param	size		The new size.
  */
@@ -229,6 +317,63 @@ void yhashtable_resize(yhashtable_t *hashtable, size_t size);
  * @param	user_data	Pointer to some user data.
  */
 void yhashtable_foreach(yhashtable_t *hashtable, yhashtable_function_t func, void *user_data);
+#ifdef USE_HASH_STATS
+/**
+ * @function	yhashtable_stats
+ *		Compute the statistics of a hash table. The histogram gives the number of
+ *		buckets for each number of elements, which helps to choose the initial size
+ *		of hash tables (see yhashtable_size_t).
+ * @param	hashtable	Pointer to the hash table.
+ * @param	stats		Pointer to the statistics structure to fill.
+ * @return	YENOERR if OK.
+ *		YEINVAL if a parameter is NULL.
+ */
+ystatus_t yhashtable_stats(const yhashtable_t *hashtable, yhash_stats_t *stats);
+#endif /* USE_HASH_STATS */
+
+/**
+ * @function	yhashtable_iterator
+ *		Create an iterator on the elements of a hash table. Unlike yhashtable_foreach(),
+ *		no function is called for each element, and the loop could be stopped at any
+ *		time (there is nothing to free).
+ * @param	hashtable	Pointer to the hash table.
+ * @return	The iterator, placed before the first element.
+ */
+static inline yhashtable_iterator_t yhashtable_iterator(yhashtable_t *hashtable) {
+	return ((yhashtable_iterator_t){
+		.hashtable = hashtable,
+		.item = hashtable ? hashtable->items : NULL,
+		.remaining = hashtable ? hashtable->used : 0,
+	});
+}
+
+/**
+ * @function	yhashtable_iterator_next
+ *		Move an iterator to the next element of its hash table. The hash table must not
+ *		be modified during the iteration, except with yhashtable_iterator_remove().
+ * @param	it	Pointer to the iterator.
+ * @return	True if the iterator is on an element, false if there is no more element.
+ */
+static inline bool yhashtable_iterator_next(yhashtable_iterator_t *it) {
+	if (!it->remaining)
+		return (false);
+	it->element = it->item;
+	it->item = it->item->list_next;
+	it->remaining--;
+	it->hash_value = it->element->hash_value;
+	it->key = it->element->key;
+	it->data = it->element->data;
+	return (true);
+}
+
+/**
+ * @function	yhashtable_iterator_remove
+ *		Remove the current element of an iterator from its hash table (the destroy
+ *		function is called on it). The iteration could continue.
+ * @param	it	Pointer to the iterator.
+ * @return	YTRUE if the element was removed, YFALSE if the iterator is not on an element.
+ */
+bool yhashtable_iterator_remove(yhashtable_iterator_t *it);
 
 #if defined(__cplusplus) || defined(c_plusplus)
 }
@@ -3,17 +3,237 @@
 #include <stdlib.h>
 #include <stdint.h>
 #include <stdio.h>
+#include <unistd.h>
+#include <errno.h>
+#include <math.h>
+#include <locale.h>
+#include <pthread.h>
+#if defined(__x86_64__) || defined(__i386__)
+# include <immintrin.h>
+#endif /* __x86_64__ || __i386__ */
 #include "yjson.h"
 
+/**
+ * @define _YJSON_TABLE_MAX_PRESIZE Maximum number of elements of the tables allocated at
+ * once by yjson_parse_fast(). Bigger arrays are remapped by the system when they grow.
+ */
+#define _YJSON_TABLE_MAX_PRESIZE	4096
+
+/**
+ * @typedef	_yjson_index_t
+ *		Structural index of a JSON document, used by yjson_parse_fast().
+ * @field	input		Pointer to the input string.
+ * @field	positions	Offsets of the structural characters ({}[]:, and opening double
+ *				quotes) and of the first character of each number or literal.
+ *				The last position is the offset of the terminating NUL.
+ * @field	count		Number of positions (without the terminating one).
+ * @field	size		Allocated size of the positions array.
+ * @field	current		Offset of the next position to process.
+ * @field	has_comments	True if a slash was found outside strings.
+ * @field	lengths		Number of elements of each array and object, in the order of
+ *				their opening characters.
+ * @field	current_length	Offset of the number of elements of the next opened
+ *				array or object.
+ */
+typedef struct {
+	const char *input;
+	uint32_t *positions;
+	size_t count;
+	size_t size;
+	size_t current;
+	bool has_comments;
+	uint32_t *lengths;
+	size_t current_length;
+} _yjson_index_t;
+/**
+ * @typedef	_yjson_block_t
+ *		Bitmaps of a 64 bytes block of input. Bit N is set if the Nth character
+ *		of the block belongs to the class.
+ * @field	quote		Double quotes.
+ * @field	backslash	Backslashes.
+ * @field	structural	Structural characters ({}[]:,).
+ * @field	space		Whitespaces (the characters accepted by isspace(): space, tab,
+ *				LF, VT, FF, CR).
+ * @field	slash		Slashes (start of comments).
+ */
+typedef struct {
+	uint64_t quote;
+	uint64_t backslash;
+	uint64_t structural;
+	uint64_t space;
+	uint64_t slash;
+} _yjson_block_t;
+
+/**
+ * @typedef	_yjson_lexer_t
+ *		State of the lexer of an incremental parsing.
+ * @constant	_YJSON_LEX_NONE			Between two tokens.
+ * @constant	_YJSON_LEX_STRING		Inside a string.
+ * @constant	_YJSON_LEX_STRING_ESCAPE	After a backslash inside a string.
+ * @constant	_YJSON_LEX_SCALAR		Inside a number or a literal (null, true, false).
+ * @constant	_YJSON_LEX_SLASH		After a slash (start of a comment).
+ * @constant	_YJSON_LEX_LINE_COMMENT		Inside a single-line comment.
+ * @constant	_YJSON_LEX_BLOCK_COMMENT	Inside a multi-lines comment.
+ * @constant	_YJSON_LEX_BLOCK_COMMENT_STAR	After a star inside a multi-lines comment.
+ */
+typedef enum {
+	_YJSON_LEX_NONE = 0,
+	_YJSON_LEX_STRING,
+	_YJSON_LEX_STRING_ESCAPE,
+	_YJSON_LEX_SCALAR,
+	_YJSON_LEX_SLASH,
+	_YJSON_LEX_LINE_COMMENT,
+	_YJSON_LEX_BLOCK_COMMENT,
+	_YJSON_LEX_BLOCK_COMMENT_STAR,
+} _yjson_lexer_t;
+/**
+ * @typedef	_yjson_expect_t
+ *		What is expected next inside an array or an object.
+ * @constant	_YJSON_EXPECT_VALUE	A value (or the end of the container).
+ * @constant	_YJSON_EXPECT_KEY	An object key (or the end of the object).
+ * @constant	_YJSON_EXPECT_COLON	A colon, after an object key.
+ * @constant	_YJSON_EXPECT_NEXT	A comma or the end of the container.
+ */
+typedef enum {
+	_YJSON_EXPECT_VALUE = 0,
+	_YJSON_EXPECT_KEY,
+	_YJSON_EXPECT_COLON,
+	_YJSON_EXPECT_NEXT,
+} _yjson_expect_t;
+/**
+ * @typedef	_yjson_frame_t
+ *		Array or object being built by an incremental parsing.
+ * @field	table		Pointer to the table.
+ * @field	key		Last read key of an object, waiting for its value.
+ * @field	is_object	True for an object, false for an array.
+ * @field	expect		What is expected next.
+ */
+typedef struct {
+	ytable_t *table;
+	ystr_t key;
+	bool is_object;
+	_yjson_expect_t expect;
+} _yjson_frame_t;
+/**
+ * @typedef	_yjson_stream_t
+ *		State of an incremental parsing.
+ * @field	frames		Stack of opened arrays and objects.
+ * @field	depth		Number of opened arrays and objects.
+ * @field	size		Allocated size of the stack.
+ * @field	lexer		State of the lexer.
+ * @field	token		Current string (raw content) or scalar token.
+ * @field	root		Root value.
+ * @field	has_root	True if the root value was entirely read.
+ * @field	sax		Pointer to the event-based parser, if values must be
+ *				given to handlers instead of being stored in a tree.
+ */
+typedef struct yjson_stream_s {
+	_yjson_frame_t *frames;
+	size_t depth;
+	size_t size;
+	_yjson_lexer_t lexer;
+	ystr_t token;
+	yvar_t root;
+	bool has_root;
+	yjson_sax_t *sax;
+} _yjson_stream_t;
+
+/**
+ * @typedef	_yjson_writer_t
+ *		Buffered output used by the JSON serializers.
+ * @field	buffer	Output buffer.
+ * @field	len	Number of bytes in the buffer.
+ * @field	str	Pointer to the destination ystring, or NULL.
+ * @field	bin	Pointer to the destination ybin, or NULL.
+ * @field	fd	Destination file descriptor (used if str and bin are NULL).
+ * @field	pretty	True to add newlines and tabulations.
+ * @field	status	Output status.
+ */
+typedef struct {
+	char buffer[16 * KB];
+	size_t len;
+	ystr_t *str;
+	ybin_t *bin;
+	int fd;
+	bool pretty;
+	ystatus_t status;
+} _yjson_writer_t;
+
 /* Private functions */
-static ystatus_t _yjson_table_print_elem(uint64_t index, char *key, void *data, void *user_data);
+static ystatus_t _yjson_write(yvar_t *value, _yjson_writer_t *writer);
+static void _yjson_writer_send(_yjson_writer_t *writer, const char *data, size_t len);
+static void _yjson_writer_flush(_yjson_writer_t *writer);
+static void _yjson_writer_append(_yjson_writer_t *writer, const char *data, size_t len);
+static void _yjson_write_value(_yjson_writer_t *writer, yvar_t *value, uint32_t depth);
+static void _yjson_write_table(_yjson_writer_t *writer, ytable_t *table, uint32_t depth);
+static void _yjson_write_indent(_yjson_writer_t *writer, uint32_t depth);
+static void _yjson_write_string(_yjson_writer_t *writer, const char *str);
+static void _yjson_write_uint(_yjson_writer_t *writer, uint64_t value);
+static void _yjson_write_int(_yjson_writer_t *writer, int64_t value);
+static void _yjson_write_float(_yjson_writer_t *writer, double value);
 static void _yjson_value_print(yvar_t *value, uint32_t depth, bool linefeed);
 static ystatus_t _yjson_remove_space(yjson_parser_t *json);
+static yres_var_t _yjson_parse_tree(yjson_parser_t *json);
 static yvar_t _yjson_parse_chunk(yjson_parser_t *json);
 static void _yjson_parse_string(yjson_parser_t *json, yvar_t *value);
 static void _yjson_parse_number(yjson_parser_t *json, yvar_t *value);
+static bool _yjson_number_fast_float(uint64_t mantissa, int64_t exp10, double *result);
+static void _yjson_c_locale_init(void);
 static void _yjson_parse_array(yjson_parser_t *json, yvar_t *value);
 static void _yjson_parse_object(yjson_parser_t *json, yvar_t *value);
+static const char *_yjson_scan_string_scalar(const char *ptr, const char *end);
+#if defined(__x86_64__) || defined(__i386__)
+static const char *_yjson_scan_string_sse2(const char *ptr, const char *end);
+static const char *_yjson_scan_string_avx2(const char *ptr, const char *end);
+#endif /* __x86_64__ || __i386__ */
+static void _yjson_simd_init(void);
+static ystatus_t _yjson_index_build(_yjson_index_t *index, const char *input, size_t len);
+static ystatus_t _yjson_index_count_elements(_yjson_index_t *index);
+static void _yjson_index_classify_scalar(const char *block, _yjson_block_t *masks);
+#if defined(__x86_64__) || defined(__i386__)
+static void _yjson_index_classify_sse2(const char *block, _yjson_block_t *masks);
+static void _yjson_index_classify_avx2(const char *block, _yjson_block_t *masks);
+#endif /* __x86_64__ || __i386__ */
+static yres_var_t _yjson_parse_indexed(yjson_parser_t *json);
+static yvar_t _yjson_fast_value(yjson_parser_t *json, _yjson_index_t *index);
+static bool _yjson_fast_check_end(yjson_parser_t *json, _yjson_index_t *index);
+static void _yjson_fast_array(yjson_parser_t *json, _yjson_index_t *index, yvar_t *value);
+static void _yjson_fast_object(yjson_parser_t *json, _yjson_index_t *index, yvar_t *value);
+static ytable_t *_yjson_table_new(yjson_parser_t *json, bool is_object, size_t size);
+static yvar_t *_yjson_value_alloc(yjson_parser_t *json, yvar_t *value);
+static void _yjson_value_discard(yjson_parser_t *json, yvar_t *value);
+static void _yjson_value_release(yvar_t *value);
+static ystatus_t _yjson_stream_init(yjson_parser_t *json, yjson_sax_t *sax);
+static void _yjson_stream_free(_yjson_stream_t *stream);
+static void _yjson_stream_char(yjson_parser_t *json, char c);
+static bool _yjson_stream_can_start(yjson_parser_t *json, bool is_string);
+static void _yjson_stream_open(yjson_parser_t *json, bool is_object);
+static void _yjson_stream_close(yjson_parser_t *json, bool is_object);
+static void _yjson_stream_string(yjson_parser_t *json);
+static void _yjson_stream_scalar(yjson_parser_t *json);
+static void _yjson_stream_value(yjson_parser_t *json, yvar_t *value);
+
+/**
+ * Pointer to the function used to find the next character of a string that needs
+ * a specific processing (double quote, backslash or control character).
+ * It is chosen once by _yjson_simd_init(), depending on the instruction sets supported
+ * by the CPU, before any parsing or serialization.
+ */
+static const char *(*_yjson_scan_string)(const char *ptr, const char *end) =
+	_yjson_scan_string_scalar;
+/** Initialization control of the functions chosen depending on the CPU. */
+static pthread_once_t _yjson_simd_once = PTHREAD_ONCE_INIT;
+/**
+ * Pointer to the function used to classify the characters of a 64 bytes block. It is
+ * chosen once by _yjson_simd_init().
+ */
+static void (*_yjson_index_classify)(const char *block, _yjson_block_t *masks) =
+	_yjson_index_classify_scalar;
+
+/** "C" locale used to convert floating-point numbers, created at the first use. */
+static locale_t _yjson_c_locale;
+/** Initialization control of the "C" locale. */
+static pthread_once_t _yjson_c_locale_once = PTHREAD_ONCE_INIT;
 
 /* Map of special characters, used to parse strings. */
 static unsigned char _yjson_special_chars[] = {
@@ -38,6 +258,11 @@ static unsigned char _yjson_special_chars[] = {
 /** @define YJSON_INDENT Macro used for indentation purpose. */
 #define YJSON_INDENT(depth) do { for (uint32_t i = 0; i < depth; ++i) printf("\t"); } while (0)
 
+/* Choose the functions best suited to the current CPU. */
+void yjson_init(void) {
+	pthread_once(&_yjson_simd_once, _yjson_simd_init);
+}
+
 /* Initialiser of JSON parser. */
 yjson_parser_t *yjson_new(void) {
 	return (malloc0(sizeof(yjson_parser_t)));
@@ -45,61 +270,333 @@ yjson_parser_t *yjson_new(void) {
 
 /* Destroy a JSON parser. */
 void yjson_free(yjson_parser_t *json) {
+	if (!json)
+		return;
+	_yjson_stream_free(json->stream);
 	free0(json);
 }
 
 /* Starts a JSON parser. */
 yres_var_t yjson_parse(yjson_parser_t *json, char *input) {
-	yres_var_t res;
+	// check parameters
+	if (!json || !input)
+		return (YRESULT_ERR(yres_var_t, YEPARAM));
+	yjson_init();
+	// parser initialization
+	*json = (yjson_parser_t){
+		.input = input,
+		.ptr = input,
+		.end = input + strlen(input),
+		.status = YENOERR,
+	};
+	return (_yjson_parse_tree(json));
+}
 
+/* Starts a JSON parser using a structural index. */
+yres_var_t yjson_parse_fast(yjson_parser_t *json, char *input) {
 	// check parameters
 	if (!json || !input)
 		return (YRESULT_ERR(yres_var_t, YEPARAM));
+	yjson_init();
 	// parser initialization
 	*json = (yjson_parser_t){
 		.input = input,
 		.ptr = input,
 		.status = YENOERR,
 	};
-	// parser execution
-	res.value = _yjson_parse_chunk(json);
+	return (_yjson_parse_indexed(json));
+}
+
+/* Starts a JSON parser which allocates the whole document from an arena. */
+yres_var_t yjson_parse_arena(yjson_parser_t *json, char *input, yarena_t *arena) {
+	// check parameters
+	if (!json || !input || !arena)
+		return (YRESULT_ERR(yres_var_t, YEPARAM));
+	yjson_init();
+	// parser initialization
+	*json = (yjson_parser_t){
+		.input = input,
+		.ptr = input,
+		.status = YENOERR,
+		.arena = arena,
+	};
+	yres_var_t res = _yjson_parse_indexed(json);
+	ys_free(json->buffer);
+	json->buffer = NULL;
+	return (res);
+}
+
+/* Give a chunk of data to an incremental JSON parser. */
+ystatus_t yjson_feed(yjson_parser_t *json, const char *chunk, size_t len) {
+	// check parameters
+	if (!json || (!chunk && len))
+		return (YEPARAM);
+	// start a new parsing if needed
+	if (!json->stream && _yjson_stream_init(json, NULL) != YENOERR)
+		return (json->status);
+	_yjson_stream_t *stream = json->stream;
+	const char *ptr = chunk;
+	const char *end = chunk + len;
+	while (ptr < end && json->status == YENOERR) {
+		switch (stream->lexer) {
+		case _YJSON_LEX_STRING: {
+			// copy all characters until the next double quote, backslash or NUL
+			const char *start = ptr;
+			while (ptr < end && *ptr != DQUOTE && *ptr != BACKSLASH && *ptr != '\0')
+				++ptr;
+			if (ptr != start && ys_nappend(&stream->token, start, ptr - start) != YENOERR) {
+				json->status = YENOMEM;
+				break;
+			}
+			if (ptr == end)
+				break;
+			if (*ptr == '\0') {
+				// the token is a NUL-terminated string
+				json->status = YESYNTAX;
+			} else if (*ptr == BACKSLASH) {
+				ys_addc(&stream->token, BACKSLASH);
+				stream->lexer = _YJSON_LEX_STRING_ESCAPE;
+			} else {
+				stream->lexer = _YJSON_LEX_NONE;
+				_yjson_stream_string(json);
+			}
+			++ptr;
+			break;
+		}
+		case _YJSON_LEX_STRING_ESCAPE:
+			if (*ptr == '\0') {
+				json->status = YESYNTAX;
+				break;
+			}
+			ys_addc(&stream->token, *ptr);
+			stream->lexer = _YJSON_LEX_STRING;
+			++ptr;
+			break;
+		case _YJSON_LEX_SCALAR:
+			if (*ptr == '\0') {
+				// strchr() would match the NUL character as a delimiter
+				json->status = YESYNTAX;
+			} else if (isspace(*ptr) || strchr("{}[]:,\"/", *ptr)) {
+				// the delimiter will be processed as a regular character
+				stream->lexer = _YJSON_LEX_NONE;
+				_yjson_stream_scalar(json);
+			} else {
+				ys_addc(&stream->token, *ptr);
+				++ptr;
+			}
+			break;
+		case _YJSON_LEX_SLASH:
+			if (*ptr == SLASH)
+				stream->lexer = _YJSON_LEX_LINE_COMMENT;
+			else if (*ptr == ASTERISK)
+				stream->lexer = _YJSON_LEX_BLOCK_COMMENT;
+			else
+				json->status = YESYNTAX;
+			++ptr;
+			break;
+		case _YJSON_LEX_LINE_COMMENT:
+			// the linefeed will be processed as a regular character
+			ptr = memchr(ptr, LF, end - ptr);
+			if (!ptr)
+				ptr = end;
+			else
+				stream->lexer = _YJSON_LEX_NONE;
+			break;
+		case _YJSON_LEX_BLOCK_COMMENT:
+		case _YJSON_LEX_BLOCK_COMMENT_STAR:
+			if (*ptr == SLASH && stream->lexer == _YJSON_LEX_BLOCK_COMMENT_STAR)
+				stream->lexer = _YJSON_LEX_NONE;
+			else if (*ptr == ASTERISK)
+				stream->lexer = _YJSON_LEX_BLOCK_COMMENT_STAR;
+			else
+				stream->lexer = _YJSON_LEX_BLOCK_COMMENT;
+			if (*ptr == LF)
+				++json->line;
+			++ptr;
+			break;
+		case _YJSON_LEX_NONE:
+			_yjson_stream_char(json, *ptr);
+			++ptr;
+			break;
+		}
+	}
+	return (json->status);
+}
+/* End an incremental parsing and return the parsed value. */
+yres_var_t yjson_finish(yjson_parser_t *json) {
+	yres_var_t res;
+
+	// check parameters
+	if (!json)
+		return (YRESULT_ERR(yres_var_t, YEPARAM));
+	_yjson_stream_t *stream = json->stream;
+	if (!stream) {
+		// nothing was given to the parser
+		if (json->status != YENOERR)
+			return (YRESULT_ERR(yres_var_t, json->status));
+		yvar_init_undef(&res.value);
+		res.status = YENOERR;
+		return (res);
+	}
+	// process the last token
+	if (json->status == YENOERR) {
+		if (stream->lexer == _YJSON_LEX_SCALAR) {
+			stream->lexer = _YJSON_LEX_NONE;
+			_yjson_stream_scalar(json);
+		} else if (stream->lexer == _YJSON_LEX_LINE_COMMENT) {
+			stream->lexer = _YJSON_LEX_NONE;
+		}
+		if (json->status == YENOERR && (stream->lexer != _YJSON_LEX_NONE || stream->depth))
+			json->status = YESYNTAX;
+	}
+	// get the root value
+	if (stream->has_root && json->status == YENOERR) {
+		res.value = stream->root;
+		stream->has_root = false;
+	} else {
+		yvar_init_undef(&res.value);
+	}
+	_yjson_stream_free(stream);
+	json->stream = NULL;
 	// check status
 	if (json->status != YENOERR)
 		return (YRESULT_ERR(yres_var_t, json->status));
-	if (json->status == YENOERR && *json->ptr != '\0') {
-		printf("OUPS\n");
-		yvar_delete(&res.value);
-		yvar_init_undef(&res.value);
-		return (YRESULT_ERR(yres_var_t, (json->status = YESYNTAX)));
-	}
-	// no error
 	res.status = YENOERR;
 	return (res);
 }
 
-/* Prints a JSON value node and its subnodes. */
-static ystatus_t _yjson_table_print_elem(uint64_t index, char *key, void *data, void *user_data) {
-	yvar_t *val = data;
-	int *p = user_data;
-	uint32_t depth = p[0], len = p[1], is_array = p[2], linefeed = p[3];
-	if (linefeed)
-		YJSON_INDENT(depth + 1);
-	if (!is_array) {
-		if (key)
-			printf("\"%s\": ", key);
-		else
-			printf("\"%lu\": ", index);
-	}
-	_yjson_value_print(val, depth + 1, linefeed);
-	if (len > 1 && linefeed)
-		printf(",\n");
-	else if (len > 1)
-		printf(",");
-	else if (len <= 1 && linefeed)
-		printf("\n");
-	((uint32_t*)user_data)[1]--;
-	return (YENOERR);
+/* Create an event-based JSON parser. */
+yjson_sax_t *yjson_sax_new(void *parse_data) {
+	yjson_sax_t *sax = malloc0(sizeof(yjson_sax_t));
+	if (!sax)
+		return (NULL);
+	sax->parse_data = parse_data;
+	return (sax);
+}
+/* Destroy an event-based JSON parser. */
+void yjson_sax_free(yjson_sax_t *sax) {
+	if (!sax)
+		return;
+	_yjson_stream_free(sax->parser.stream);
+	free0(sax);
+}
+/* Set the handlers called at the start and at the end of objects. */
+void yjson_sax_set_object_hdlr(yjson_sax_t *sax, void (*start_hdlr)(yjson_sax_t*),
+                               void (*end_hdlr)(yjson_sax_t*)) {
+	if (sax) {
+		sax->start_object_hdlr = start_hdlr;
+		sax->end_object_hdlr = end_hdlr;
+	}
+}
+/* Set the handlers called at the start and at the end of arrays. */
+void yjson_sax_set_array_hdlr(yjson_sax_t *sax, void (*start_hdlr)(yjson_sax_t*),
+                              void (*end_hdlr)(yjson_sax_t*)) {
+	if (sax) {
+		sax->start_array_hdlr = start_hdlr;
+		sax->end_array_hdlr = end_hdlr;
+	}
 }
+/* Set the handler called for each object key. */
+void yjson_sax_set_key_hdlr(yjson_sax_t *sax, void (*hdlr)(yjson_sax_t*, ystr_t)) {
+	if (sax)
+		sax->key_hdlr = hdlr;
+}
+/* Set the handler called for each scalar value. */
+void yjson_sax_set_value_hdlr(yjson_sax_t *sax, void (*hdlr)(yjson_sax_t*, yvar_t*)) {
+	if (sax)
+		sax->value_hdlr = hdlr;
+}
+/* Give a chunk of JSON data to an event-based parser. */
+ystatus_t yjson_sax_feed(yjson_sax_t *sax, const char *chunk, size_t len) {
+	if (!sax)
+		return (YEPARAM);
+	if (!sax->parser.stream && _yjson_stream_init(&sax->parser, sax) != YENOERR)
+		return (sax->parser.status);
+	return (yjson_feed(&sax->parser, chunk, len));
+}
+/* End an event-based parsing. */
+ystatus_t yjson_sax_finish(yjson_sax_t *sax) {
+	if (!sax)
+		return (YEPARAM);
+	return (yjson_finish(&sax->parser).status);
+}
+/* Parse a JSON string with an event-based parser. */
+ystatus_t yjson_sax_read_memory(yjson_sax_t *sax, const char *mem) {
+	if (!sax || !mem)
+		return (YEPARAM);
+	yjson_sax_feed(sax, mem, strlen(mem));
+	return (yjson_sax_finish(sax));
+}
+/* Parse a JSON stream with an event-based parser. */
+ystatus_t yjson_sax_read_stream(yjson_sax_t *sax, FILE *stream) {
+	char buffer[64 * KB];
+	size_t len;
+
+	if (!sax || !stream)
+		return (YEPARAM);
+	while ((len = fread(buffer, 1, sizeof(buffer), stream)) > 0) {
+		if (yjson_sax_feed(sax, buffer, len) != YENOERR)
+			break;
+	}
+	if (ferror(stream) && sax->parser.status == YENOERR)
+		sax->parser.status = YEIO;
+	return (yjson_sax_finish(sax));
+}
+/* Parse a JSON file with an event-based parser. */
+ystatus_t yjson_sax_read_file(yjson_sax_t *sax, const char *filename) {
+	FILE *stream;
+
+	if (!sax || !filename)
+		return (YEPARAM);
+	if (!(stream = fopen(filename, "r")))
+		return (YEACCES);
+	ystatus_t status = yjson_sax_read_stream(sax, stream);
+	fclose(stream);
+	return (status);
+}
+/* Stop an event-based parser. */
+void yjson_sax_stop(yjson_sax_t *sax) {
+	if (sax)
+		sax->parser.status = YEL2HLT;
+}
+
+/* Serialize a JSON value at the end of a ystring. */
+ystatus_t yjson_write_string(yvar_t *value, ystr_t *dest, bool pretty) {
+	if (!dest)
+		return (YEPARAM);
+	if (!*dest && !(*dest = ys_new("")))
+		return (YENOMEM);
+	_yjson_writer_t writer = {
+		.str = dest,
+		.pretty = pretty,
+		.status = YENOERR,
+	};
+	return (_yjson_write(value, &writer));
+}
+/* Serialize a JSON value at the end of a ybin. */
+ystatus_t yjson_write_binary(yvar_t *value, ybin_t *dest, bool pretty) {
+	if (!dest)
+		return (YEPARAM);
+	_yjson_writer_t writer = {
+		.bin = dest,
+		.pretty = pretty,
+		.status = YENOERR,
+	};
+	return (_yjson_write(value, &writer));
+}
+/* Serialize a JSON value to a file descriptor. */
+ystatus_t yjson_write_fd(yvar_t *value, int fd, bool pretty) {
+	if (fd < 0)
+		return (YEPARAM);
+	_yjson_writer_t writer = {
+		.fd = fd,
+		.pretty = pretty,
+		.status = YENOERR,
+	};
+	return (_yjson_write(value, &writer));
+}
+
+/* Prints a JSON value node and its subnodes. */
 static void _yjson_value_print(yvar_t *value, uint32_t depth, bool linefeed) {
 	if (!value) {
 		printf("(unset)");
@@ -119,13 +616,25 @@ static void _yjson_value_print(yvar_t *value, uint32_t depth, bool linefeed) {
 		ytable_t *table = yvar_get_table(value);
 		bool is_array = ytable_is_array(table);
 		printf(is_array ? (linefeed ? "[\n" : "[") : (linefeed ? "{\n" : "{"));
-		uint32_t params[4] = {
-			depth,
-			ytable_length(table),
-			(is_array ? 1 : 0),
-			(linefeed ? 1 : 0),
-		};
-		ytable_foreach(table, _yjson_table_print_elem, params);
+		uint32_t remaining = ytable_length(table);
+		ytable_iterator_t it = ytable_iterator(table);
+		while (ytable_iterator_next(&it)) {
+			if (linefeed)
+				YJSON_INDENT(depth + 1);
+			if (!is_array) {
+				if (it.key)
+					printf("\"%s\": ", it.key);
+				else
+					printf("\"%lu\": ", it.hash);
+			}
+			_yjson_value_print(it.data, depth + 1, linefeed);
+			if (--remaining && linefeed)
+				printf(",\n");
+			else if (remaining)
+				printf(",");
+			else if (linefeed)
+				printf("\n");
+		}
 		if (linefeed)
 			YJSON_INDENT(depth);
 		printf(is_array ? "]" : "}");
@@ -181,6 +690,27 @@ static ystatus_t _yjson_remove_space(yjson_parser_t *json) {
 	// remove remaining spaces
 	return (_yjson_remove_space(json));
 }
+/*
+ * Parse a JSON string using the recursive parser (see yjson_parse()).
+ * @param	json	Pointer to the initialized parser.
+ * @return	The root node value.
+ */
+static yres_var_t _yjson_parse_tree(yjson_parser_t *json) {
+	yres_var_t res;
+
+	// parser execution
+	res.value = _yjson_parse_chunk(json);
+	// check status
+	if (json->status != YENOERR)
+		return (YRESULT_ERR(yres_var_t, json->status));
+	if (json->status == YENOERR && *json->ptr != '\0') {
+		_yjson_value_discard(json, &res.value);
+		return (YRESULT_ERR(yres_var_t, (json->status = YESYNTAX)));
+	}
+	// no error
+	res.status = YENOERR;
+	return (res);
+}
 /* Parse a chunk of JSON. */
 static yvar_t _yjson_parse_chunk(yjson_parser_t *json) {
 	char c;
@@ -239,8 +769,14 @@ end:
  */
 static void _yjson_parse_string(yjson_parser_t *json, yvar_t *value) {
 	//char *ptr = json->ptr;
-	// allocate a buffered string
-	ystr_t str = ys_new("");
+	// allocate a buffered string (the parser's buffer is reused when using an arena)
+	ystr_t str;
+	if (!json->arena)
+		str = ys_new("");
+	else if ((str = json->buffer))
+		ys_trunc(str);
+	else
+		str = json->buffer = ys_new("");
 	if (!str) {
 		yvar_init_undef(value);
 		json->status = YENOMEM;
@@ -248,6 +784,16 @@ static void _yjson_parse_string(yjson_parser_t *json, yvar_t *value) {
 	}
 	// loop on characters
 	while (*json->ptr != '\0') {
+		// copy all characters until the next one that must be processed
+		const char *clean_end = _yjson_scan_string(json->ptr, json->end);
+		if (clean_end != json->ptr) {
+			if (ys_nappend(&str, json->ptr, clean_end - json->ptr) != YENOERR) {
+				json->status = YENOMEM;
+				goto error;
+			}
+			json->ptr = (char*)clean_end;
+			continue;
+		}
 		unsigned char next_c = *(json->ptr + 1);
 		// end of string
 		if (*json->ptr == '"')
@@ -315,6 +861,7 @@ static void _yjson_parse_string(yjson_parser_t *json, yvar_t *value) {
 					};
 					ys_append(&str, (char*)s);
 				}
+				json->ptr += 6;
 			} else {
 				// syntax error
 				goto syntax_error;
@@ -328,11 +875,112 @@ static void _yjson_parse_string(yjson_parser_t *json, yvar_t *value) {
 		goto syntax_error;
 	*json->ptr = '\0';
 	++json->ptr;
+	if (json->arena) {
+		// copy the decoded string in the arena
+		json->buffer = str;
+		if (!(str = ys_arena_ncopy(json->arena, str, ys_bytesize(str)))) {
+			yvar_init_undef(value);
+			json->status = YENOMEM;
+			return;
+		}
+	}
 	yvar_init_string(value, str);
 	return;
 syntax_error:
-	yvar_init_undef(value);
 	json->status = YESYNTAX;
+error:
+	if (json->arena)
+		json->buffer = str;
+	else
+		ys_free(str);
+	yvar_init_undef(value);
+}
+/*
+ * Find the next character of a string that can't be copied as is (double quote,
+ * backslash, or control character - including the terminating NUL character).
+ * Scalar version.
+ * @param	ptr	Pointer to the current position in the string.
+ * @param	end	Pointer to the terminating NUL character of the string. No character
+ *			is read after it.
+ * @return	A pointer to the found character.
+ */
+static const char *_yjson_scan_string_scalar(const char *ptr, const char *end) {
+	(void)end;
+	while ((unsigned char)*ptr >= 0x20 && *ptr != '"' && *ptr != '\\')
+		++ptr;
+	return (ptr);
+}
+#if defined(__x86_64__) || defined(__i386__)
+/*
+ * SSE2 version of the string scanner. The first 16 bytes are read with an unaligned
+ * load, the next ones by aligned blocks; the last bytes before the end of the string,
+ * which don't fill a block, are read by the scalar version. So no byte is read after
+ * the terminating NUL character (it could belong to another buffer, or be written by
+ * another thread, like the next line for yjson_parse_lines()).
+ */
+__attribute__((target("sse2")))
+static const char *_yjson_scan_string_sse2(const char *ptr, const char *end) {
+	const __m128i quote = _mm_set1_epi8('"');
+	const __m128i backslash = _mm_set1_epi8('\\');
+	const __m128i control = _mm_set1_epi8(0x1F);
+#define _YJSON_SCAN(chunk)	((uint32_t)_mm_movemask_epi8(_mm_or_si128( \
+		_mm_or_si128(_mm_cmpeq_epi8(chunk, quote), _mm_cmpeq_epi8(chunk, backslash)), \
+		_mm_cmpeq_epi8(_mm_min_epu8(chunk, control), chunk))))
+	uint32_t mask;
+
+	if (end - ptr < 15)
+		return (_yjson_scan_string_scalar(ptr, end));
+	if ((mask = _YJSON_SCAN(_mm_loadu_si128((const __m128i*)ptr))))
+		return (ptr + __builtin_ctz(mask));
+	const char *block = (const char*)(((uintptr_t)ptr + 16) & ~(uintptr_t)15);
+	for (; end - block >= 15; block += 16) {
+		if ((mask = _YJSON_SCAN(_mm_load_si128((const __m128i*)block))))
+			return (block + __builtin_ctz(mask));
+	}
+#undef _YJSON_SCAN
+	return (_yjson_scan_string_scalar(block, end));
+}
+/* AVX2 version of the string scanner, working on 32 bytes blocks. */
+__attribute__((target("avx2")))
+static const char *_yjson_scan_string_avx2(const char *ptr, const char *end) {
+	const __m256i quote = _mm256_set1_epi8('"');
+	const __m256i backslash = _mm256_set1_epi8('\\');
+	const __m256i control = _mm256_set1_epi8(0x1F);
+#define _YJSON_SCAN(chunk)	((uint32_t)_mm256_movemask_epi8(_mm256_or_si256( \
+		_mm256_or_si256(_mm256_cmpeq_epi8(chunk, quote), \
+		                _mm256_cmpeq_epi8(chunk, backslash)), \
+		_mm256_cmpeq_epi8(_mm256_min_epu8(chunk, control), chunk))))
+	uint32_t mask;
+
+	if (end - ptr < 31)
+		return (_yjson_scan_string_scalar(ptr, end));
+	if ((mask = _YJSON_SCAN(_mm256_loadu_si256((const __m256i*)ptr))))
+		return (ptr + __builtin_ctz(mask));
+	const char *block = (const char*)(((uintptr_t)ptr + 32) & ~(uintptr_t)31);
+	for (; end - block >= 31; block += 32) {
+		if ((mask = _YJSON_SCAN(_mm256_load_si256((const __m256i*)block))))
+			return (block + __builtin_ctz(mask));
+	}
+#undef _YJSON_SCAN
+	return (_yjson_scan_string_scalar(block, end));
+}
+#endif /* __x86_64__ || __i386__ */
+/*
+ * Choose the best functions for the current CPU. Called once (see pthread_once(3)) by
+ * yjson_init(), so the function pointers are never written while other threads use
+ * them.
+ */
+static void _yjson_simd_init(void) {
+#if defined(__x86_64__) || defined(__i386__)
+	__builtin_cpu_init();
+	if (__builtin_cpu_supports("avx2")) {
+		_yjson_scan_string = _yjson_scan_string_avx2;
+		_yjson_index_classify = _yjson_index_classify_avx2;
+	} else if (__builtin_cpu_supports("sse2")) {
+		_yjson_scan_string = _yjson_scan_string_sse2;
+		_yjson_index_classify = _yjson_index_classify_sse2;
+	}
+#endif /* __x86_64__ || __i386__ */
 }
 /* Parse a number. */
 static void _yjson_parse_number(yjson_parser_t *json, yvar_t *value) {
@@ -344,42 +992,153 @@ static void _yjson_parse_number(yjson_parser_t *json, yvar_t *value) {
 	 * exponential part (optional)
 	 *	"e|e+|e-|E|E+|E-" followed by one or more digits
 	 */
-	char *end;
-	char *ptr = json->ptr;
-	bool dot = false;
+	const char *ptr = json->ptr;
+	bool negative = false;
+	bool is_float = false;
+	bool truncated = false;
+	uint64_t mantissa = 0;
+	int digits = 0;
+	int64_t exp10 = 0;
 
-	// check syntax
-	if (*ptr == '-')
+	// sign
+	if (*ptr == '-') {
+		negative = true;
 		++ptr;
+	}
 	if (!isdigit(*ptr)) {
 		json->status = YESYNTAX;
 		return;
 	}
-	while (isdigit(*ptr))
+	// integer part (only the first 19 significant digits are kept in the mantissa)
+	while (*ptr == '0')
 		++ptr;
+	for (; isdigit(*ptr); ++ptr) {
+		if (digits < 19) {
+			mantissa = (mantissa * 10) + (uint64_t)(*ptr - '0');
+			++digits;
+		} else {
+			++exp10;
+			if (*ptr != '0')
+				truncated = true;
+		}
+	}
+	// decimal part
 	if (*ptr == '.') {
-		dot = true;
+		is_float = true;
 		++ptr;
 		if (!isdigit(*ptr)) {
 			json->status = YESYNTAX;
 			return;
 		}
+		for (; isdigit(*ptr); ++ptr) {
+			if (!mantissa && *ptr == '0') {
+				// leading zeros are not significant
+				--exp10;
+			} else if (digits < 19) {
+				mantissa = (mantissa * 10) + (uint64_t)(*ptr - '0');
+				++digits;
+				--exp10;
+			} else if (*ptr != '0') {
+				truncated = true;
+			}
+		}
 	}
-	// conversion
-	if (dot) {
-		double float_value = strtold(json->ptr, &end);
-		yvar_init_float(value, float_value);
+	// exponential part
+	if (*ptr == 'e' || *ptr == 'E') {
+		const char *pt = ptr + 1;
+		bool exp_negative = false;
+		if (*pt == '+' || *pt == '-')
+			exp_negative = (*pt++ == '-');
+		if (isdigit(*pt)) {
+			int64_t exp = 0;
+			for (; isdigit(*pt); ++pt) {
+				if (exp < 100000)
+					exp = (exp * 10) + (*pt - '0');
+			}
+			exp10 += exp_negative ? -exp : exp;
+			is_float = true;
+			ptr = pt;
+		}
+	}
+	// integer value (converted to float on overflow)
+	if (!is_float && !truncated && exp10 == 0) {
+		if (!negative && mantissa <= (uint64_t)INT64_MAX) {
+			yvar_init_int(value, (int64_t)mantissa);
+			json->ptr = (char*)ptr;
+			return;
+		}
+		if (negative && mantissa <= (uint64_t)INT64_MAX + 1) {
+			yvar_init_int(value, (int64_t)(0 - mantissa));
+			json->ptr = (char*)ptr;
+			return;
+		}
+	}
+	// floating-point value
+	double float_value;
+	if (!truncated && _yjson_number_fast_float(mantissa, exp10, &float_value)) {
+		yvar_init_float(value, negative ? -float_value : float_value);
 	} else {
-		int64_t int_value = (int64_t)strtoll(json->ptr, &end, 10);
-		yvar_init_int(value, int_value);
+		// slow path: correctly rounded conversion, independent of the current locale
+		pthread_once(&_yjson_c_locale_once, _yjson_c_locale_init);
+		if (_yjson_c_locale)
+			float_value = strtod_l(json->ptr, NULL, _yjson_c_locale);
+		else
+			float_value = strtod(json->ptr, NULL);
+		yvar_init_float(value, float_value);
 	}
-	json->ptr = end;
+	json->ptr = (char*)ptr;
+}
+/*
+ * Exact conversion of mantissa * 10^exp10 to a double (Clinger's fast path): when the
+ * mantissa and the power of ten are both exactly representable, the result of one
+ * IEEE multiplication or division is correctly rounded.
+ * @param	mantissa	Decimal mantissa.
+ * @param	exp10		Decimal exponent.
+ * @param	result		Pointer to the result.
+ * @return	True if the conversion was done.
+ */
+static bool _yjson_number_fast_float(uint64_t mantissa, int64_t exp10, double *result) {
+	static const double pow10[] = {
+		1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+		1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+	};
+	const uint64_t max_mantissa = (uint64_t)1 << 53;
+
+	if (!mantissa) {
+		*result = 0.0;
+		return (true);
+	}
+	if (mantissa > max_mantissa)
+		return (false);
+	if (exp10 >= -22 && exp10 < 0) {
+		*result = (double)mantissa / pow10[-exp10];
+		return (true);
+	}
+	if (exp10 >= 0 && exp10 <= 22) {
+		*result = (double)mantissa * pow10[exp10];
+		return (true);
+	}
+	// big exponent with a small mantissa: move a part of the exponent to the mantissa
+	if (exp10 > 22 && exp10 <= 22 + 15) {
+		uint64_t factor = (uint64_t)pow10[exp10 - 22];
+		if (mantissa > max_mantissa / factor)
+			return (false);
+		*result = (double)(mantissa * factor) * pow10[22];
+		return (true);
+	}
+	return (false);
+}
+/* Create the "C" locale used to convert numbers. */
+static void _yjson_c_locale_init(void) {
+	_yjson_c_locale = newlocale(LC_ALL_MASK, "C", (locale_t)0);
 }
 /* Parse an array. */
 static void _yjson_parse_array(yjson_parser_t *json, yvar_t *value) {
 	if (_yjson_remove_space(json) != YENOERR)
 		return;
-	ytable_t *table = ytable_new();
+	ytable_t *table = _yjson_table_new(json, false, 0);
+	if (!table)
+		return;
 	while (*json->ptr != '\0') {
 		// search for end of list
 		if (*json->ptr == RBRACKET) {
@@ -391,9 +1150,9 @@ static void _yjson_parse_array(yjson_parser_t *json, yvar_t *value) {
 		yvar_t val = _yjson_parse_chunk(json);
 		if (json->status != YENOERR)
 			goto error;
-		yvar_t *pval = yvar_clone(&val);
+		yvar_t *pval = _yjson_value_alloc(json, &val);
 		if (!pval) {
-			json->status = YENOMEM;
+			_yjson_value_discard(json, &val);
 			goto error;
 		}
 		// add the value to the array
@@ -415,14 +1174,17 @@ static void _yjson_parse_array(yjson_parser_t *json, yvar_t *value) {
 	// end of string
 	json->status = YESYNTAX;
 error:
-	ytable_free(table);
+	yvar_init_table(value, table);
+	_yjson_value_discard(json, value);
 }
 /* Parse an object. */
 static void _yjson_parse_object(yjson_parser_t *json, yvar_t *value) {
 	ystr_t key = NULL;
 	if (_yjson_remove_space(json) != YENOERR)
 		return;
-	ytable_t *table = ytable_create(8, NULL, json);
+	ytable_t *table = _yjson_table_new(json, true, 0);
+	if (!table)
+		return;
 	while (*json->ptr != '\0') {
 		// search for end of object
 		if (*json->ptr == RBRACE) {
@@ -435,6 +1197,7 @@ static void _yjson_parse_object(yjson_parser_t *json, yvar_t *value) {
 		if (json->status != YENOERR)
 			goto error;
 		if (!yvar_is_string(&val_key)) {
+			_yjson_value_discard(json, &val_key);
 			json->status = YESYNTAX;
 			goto error;
 		}
@@ -451,13 +1214,14 @@ static void _yjson_parse_object(yjson_parser_t *json, yvar_t *value) {
 		yvar_t val = _yjson_parse_chunk(json);
 		if (json->status != YENOERR)
 			goto error;
-		yvar_t *pval = yvar_clone(&val);
+		yvar_t *pval = _yjson_value_alloc(json, &val);
 		if (!pval) {
-			json->status = YENOMEM;
+			_yjson_value_discard(json, &val);
 			goto error;
 		}
 		// add to hashmap
 		ytable_set_key(table, key, pval);
+		key = NULL;
 		// process the rest
 		if (*json->ptr == RBRACE) {
 			continue;
@@ -469,8 +1233,1065 @@ static void _yjson_parse_object(yjson_parser_t *json, yvar_t *value) {
 		if (_yjson_remove_space(json) != YENOERR)
 			goto error;
 	}
+	// end of string
+	json->status = YESYNTAX;
 error:
-	ys_free(key);
-	ytable_free(table);
+	if (!json->arena)
+		ys_free(key);
+	yvar_init_table(value, table);
+	_yjson_value_discard(json, value);
+}
+
+/* ********** STRUCTURAL INDEX ********** */
+/*
+ * Build the structural index of a JSON string.
+ * The input is read by blocks of 64 bytes. For each block, the characters are
+ * classified (using SIMD instructions if available), then escaped characters and
+ * strings are computed using bitwise operations on 64 bits masks.
+ * @param	index	Pointer to the index.
+ * @param	input	Pointer to the input string.
+ * @param	len	Length of the input string.
+ * @return	YENOERR if OK.
+ */
+static ystatus_t _yjson_index_build(_yjson_index_t *index, const char *input, size_t len) {
+	// escaped: 1 if the first character of the next block is escaped
+	// in_string: all bits set if the previous block ended inside a string
+	// after_separator: 1 if the last character of the previous block was a
+	//                  whitespace or a structural character
+	uint64_t escaped_carry = 0, in_string_carry = 0, separator_carry = 1;
+	_yjson_block_t masks;
+	char tail[64];
+
+	if (len >= UINT32_MAX)
+		return (YE2BIG);
+	*index = (_yjson_index_t){
+		.input = input,
+		.size = (len / 8) + 64,
+	};
+	index->positions = malloc(index->size * sizeof(uint32_t));
+	if (!index->positions)
+		return (YENOMEM);
+	for (size_t offset = 0; offset < len; offset += 64) {
+		// classify characters (the last block is copied in a padded buffer)
+		if (len - offset >= 64) {
+			_yjson_index_classify(input + offset, &masks);
+		} else {
+			memset(tail, ' ', sizeof(tail));
+			memcpy(tail, input + offset, len - offset);
+			_yjson_index_classify(tail, &masks);
+		}
+		// compute escaped characters (backslashes are rare, so they are processed one by one)
+		uint64_t escaped = escaped_carry;
+		escaped_carry = 0;
+		uint64_t backslash = masks.backslash & ~escaped;
+		while (backslash) {
+			int pos = __builtin_ctzll(backslash);
+			if (pos == 63) {
+				escaped_carry = 1;
+				break;
+			}
+			escaped |= (uint64_t)1 << (pos + 1);
+			backslash &= ~((uint64_t)3 << pos);
+		}
+		// compute strings: a bit is set from an opening quote (included)
+		// to the closing quote (excluded), using a prefix XOR
+		uint64_t quote = masks.quote & ~escaped;
+		uint64_t in_string = quote;
+		in_string ^= in_string << 1;
+		in_string ^= in_string << 2;
+		in_string ^= in_string << 4;
+		in_string ^= in_string << 8;
+		in_string ^= in_string << 16;
+		in_string ^= in_string << 32;
+		in_string ^= in_string_carry;
+		in_string_carry = (uint64_t)((int64_t)in_string >> 63);
+		// structural characters outside of strings
+		uint64_t structural = masks.structural & ~in_string;
+		uint64_t separator = structural | (masks.space & ~in_string);
+		// first characters of numbers and literals
+		uint64_t other = ~(separator | masks.quote | in_string);
+		uint64_t atom_start = other & ((separator << 1) | separator_carry);
+		separator_carry = separator >> 63;
+		if (masks.slash & ~in_string)
+			index->has_comments = true;
+		// add positions to the index
+		uint64_t found = structural | (quote & in_string) | atom_start;
+		if (index->count + 64 + 1 > index->size) {
+			size_t new_size = index->size * 2;
+			uint32_t *positions = realloc0(index->positions, new_size * sizeof(uint32_t));
+			if (!positions)
+				return (YENOMEM);
+			index->positions = positions;
+			index->size = new_size;
+		}
+		while (found) {
+			size_t pos = offset + __builtin_ctzll(found);
+			if (pos >= len)
+				break;
+			index->positions[index->count++] = (uint32_t)pos;
+			found &= found - 1;
+		}
+	}
+	// terminating position
+	index->positions[index->count] = (uint32_t)len;
+	return (YENOERR);
+}
+/*
+ * Count the elements of the arrays and objects of an indexed document, so that their
+ * tables could be allocated at once by the tree construction.
+ * @param	index	Pointer to the structural index.
+ * @return	YENOERR if OK.
+ */
+static ystatus_t _yjson_index_count_elements(_yjson_index_t *index) {
+	// stack of the arrays and objects being counted (offsets in the lengths array)
+	uint32_t *stack = NULL;
+	size_t nb_lengths = 0, size = 0, depth = 0;
+	char previous = '\0';
+
+	for (size_t i = 0; i < index->count; ++i) {
+		char c = index->input[index->positions[i]];
+		if (c == LBRACE || c == LBRACKET) {
+			// new array or object (the stack is never deeper than the number of
+			// arrays and objects, so both arrays have the same size)
+			if (nb_lengths == size) {
+				size = size ? (size * 2) : 64;
+				uint32_t *lengths = realloc0(index->lengths, size * sizeof(uint32_t));
+				if (!lengths) {
+					free0(stack);
+					return (YENOMEM);
+				}
+				index->lengths = lengths;
+				uint32_t *new_stack = realloc0(stack, size * sizeof(uint32_t));
+				if (!new_stack) {
+					free0(stack);
+					return (YENOMEM);
+				}
+				stack = new_stack;
+			}
+			index->lengths[nb_lengths] = 0;
+			stack[depth++] = (uint32_t)nb_lengths++;
+		} else if (!depth) {
+			// syntax error, detected by the tree construction
+		} else if (c == COMMA) {
+			++index->lengths[stack[depth - 1]];
+		} else if (c == RBRACE || c == RBRACKET) {
+			// the last element is not followed by a comma
+			if (previous != LBRACE && previous != LBRACKET)
+				++index->lengths[stack[depth - 1]];
+			--depth;
+		}
+		previous = c;
+	}
+	free0(stack);
+	return (YENOERR);
+}
+/* Classify the characters of a 64 bytes block. Scalar version. */
+static void _yjson_index_classify_scalar(const char *block, _yjson_block_t *masks) {
+	*masks = (_yjson_block_t){0};
+	for (int i = 0; i < 64; ++i) {
+		uint64_t bit = (uint64_t)1 << i;
+		switch (block[i]) {
+		case '"':
+			masks->quote |= bit;
+			break;
+		case '\\':
+			masks->backslash |= bit;
+			break;
+		case '{': case '}': case '[': case ']': case ':': case ',':
+			masks->structural |= bit;
+			break;
+		case ' ': case '\t': case '\n': case '\v': case '\f': case '\r':
+			masks->space |= bit;
+			break;
+		case '/':
+			masks->slash |= bit;
+			break;
+		}
+	}
+}
+#if defined(__x86_64__) || defined(__i386__)
+/* SSE2 version of the classification, 4 x 16 bytes. */
+__attribute__((target("sse2")))
+static void _yjson_index_classify_sse2(const char *block, _yjson_block_t *masks) {
+	*masks = (_yjson_block_t){0};
+	for (int i = 0; i < 4; ++i) {
+		__m128i c = _mm_loadu_si128((const __m128i*)(block + (i * 16)));
+		int shift = i * 16;
+#define _YJSON_EQ(ch)	_mm_cmpeq_epi8(c, _mm_set1_epi8(ch))
+#define _YJSON_BITS(v)	((uint64_t)(uint16_t)_mm_movemask_epi8(v) << shift)
+		masks->quote |= _YJSON_BITS(_YJSON_EQ('"'));
+		masks->backslash |= _YJSON_BITS(_YJSON_EQ('\\'));
+		masks->slash |= _YJSON_BITS(_YJSON_EQ('/'));
+		masks->structural |= _YJSON_BITS(_mm_or_si128(
+			_mm_or_si128(_mm_or_si128(_YJSON_EQ('{'), _YJSON_EQ('}')),
+			             _mm_or_si128(_YJSON_EQ('['), _YJSON_EQ(']'))),
+			_mm_or_si128(_YJSON_EQ(':'), _YJSON_EQ(','))));
+		// tab, LF, VT, FF and CR are the characters from 9 to 13
+		__m128i ctrl = _mm_sub_epi8(c, _mm_set1_epi8('\t'));
+		masks->space |= _YJSON_BITS(_mm_or_si128(_YJSON_EQ(' '),
+			_mm_cmpeq_epi8(_mm_min_epu8(ctrl, _mm_set1_epi8(4)), ctrl)));
+#undef _YJSON_EQ
+#undef _YJSON_BITS
+	}
 }
+/* AVX2 version of the classification, 2 x 32 bytes. */
+__attribute__((target("avx2")))
+static void _yjson_index_classify_avx2(const char *block, _yjson_block_t *masks) {
+	*masks = (_yjson_block_t){0};
+	for (int i = 0; i < 2; ++i) {
+		__m256i c = _mm256_loadu_si256((const __m256i*)(block + (i * 32)));
+		int shift = i * 32;
+#define _YJSON_EQ(ch)	_mm256_cmpeq_epi8(c, _mm256_set1_epi8(ch))
+#define _YJSON_BITS(v)	((uint64_t)(uint32_t)_mm256_movemask_epi8(v) << shift)
+		masks->quote |= _YJSON_BITS(_YJSON_EQ('"'));
+		masks->backslash |= _YJSON_BITS(_YJSON_EQ('\\'));
+		masks->slash |= _YJSON_BITS(_YJSON_EQ('/'));
+		masks->structural |= _YJSON_BITS(_mm256_or_si256(
+			_mm256_or_si256(_mm256_or_si256(_YJSON_EQ('{'), _YJSON_EQ('}')),
+			                _mm256_or_si256(_YJSON_EQ('['), _YJSON_EQ(']'))),
+			_mm256_or_si256(_YJSON_EQ(':'), _YJSON_EQ(','))));
+		// tab, LF, VT, FF and CR are the characters from 9 to 13
+		__m256i ctrl = _mm256_sub_epi8(c, _mm256_set1_epi8('\t'));
+		masks->space |= _YJSON_BITS(_mm256_or_si256(_YJSON_EQ(' '),
+			_mm256_cmpeq_epi8(_mm256_min_epu8(ctrl, _mm256_set1_epi8(4)), ctrl)));
+#undef _YJSON_EQ
+#undef _YJSON_BITS
+	}
+}
+#endif /* __x86_64__ || __i386__ */
+
+/* ********** TREE CONSTRUCTION FROM THE STRUCTURAL INDEX ********** */
+/*
+ * Parse a JSON string using a structural index (see yjson_parse_fast()).
+ * @param	json	Pointer to the initialized parser.
+ * @return	The root node value.
+ */
+static yres_var_t _yjson_parse_indexed(yjson_parser_t *json) {
+	_yjson_index_t index = {0};
+	char *input = json->input;
+	yres_var_t res;
 
+	// first stage: build the structural index
+	json->end = input + strlen(input);
+	ystatus_t st = _yjson_index_build(&index, input, json->end - input);
+	if (st != YENOERR) {
+		free0(index.positions);
+		return (YRESULT_ERR(yres_var_t, (json->status = st)));
+	}
+	// comments are not managed by the index, use the regular parser
+	if (index.has_comments) {
+		free0(index.positions);
+		return (_yjson_parse_tree(json));
+	}
+	if ((st = _yjson_index_count_elements(&index)) != YENOERR) {
+		free0(index.positions);
+		free0(index.lengths);
+		return (YRESULT_ERR(yres_var_t, (json->status = st)));
+	}
+	// second stage: build the value tree
+	if (!index.count) {
+		yvar_init_undef(&res.value);
+	} else {
+		res.value = _yjson_fast_value(json, &index);
+		if (json->status == YENOERR && index.current != index.count) {
+			_yjson_value_discard(json, &res.value);
+			json->ptr = input + index.positions[index.current];
+			json->status = YESYNTAX;
+		}
+	}
+	char *end = input + index.positions[index.count];
+	free0(index.positions);
+	free0(index.lengths);
+	// check status
+	if (json->status != YENOERR) {
+		// compute the line number of the error
+		json->line = 0;
+		for (const char *pt = input; pt < json->ptr; ++pt)
+			if (*pt == LF)
+				++json->line;
+		return (YRESULT_ERR(yres_var_t, json->status));
+	}
+	// no error
+	json->ptr = end;
+	res.status = YENOERR;
+	return (res);
+}
+/*
+ * Parse the value placed at the current position of the index.
+ * @param	json	Pointer to the parser.
+ * @param	index	Pointer to the structural index.
+ * @return	The parsed value.
+ */
+static yvar_t _yjson_fast_value(yjson_parser_t *json, _yjson_index_t *index) {
+	yvar_t result;
+
+	yvar_init_undef(&result);
+	json->ptr = json->input + index->positions[index->current];
+	char c = *json->ptr;
+	if (c == '{') {
+		++index->current;
+		_yjson_fast_object(json, index, &result);
+		return (result);
+	} else if (c == '[') {
+		++index->current;
+		_yjson_fast_array(json, index, &result);
+		return (result);
+	} else if (c == '"') {
+		json->ptr++;
+		_yjson_parse_string(json, &result);
+	} else if (c == '-' || (c >= '0' && c <= '9')) {
+		_yjson_parse_number(json, &result);
+	} else if (!strncasecmp(json->ptr, "null", 4)) {
+		json->ptr += 4;
+		yvar_init_null(&result);
+	} else if (!strncasecmp(json->ptr, "false", 5)) {
+		json->ptr += 5;
+		yvar_init_bool(&result, false);
+	} else if (!strncasecmp(json->ptr, "true", 4)) {
+		json->ptr += 4;
+		yvar_init_bool(&result, true);
+	} else if (c == '}' || c == ']' || c == ':' || c == ',' || c == '\0') {
+		json->status = YESYNTAX;
+	} else {
+		_yjson_parse_number(json, &result);
+	}
+	++index->current;
+	if (json->status != YENOERR || !_yjson_fast_check_end(json, index))
+		_yjson_value_discard(json, &result);
+	return (result);
+}
+/*
+ * Check that a scalar value is followed by spaces and then by the next indexed character.
+ * @param	json	Pointer to the parser, pointing after the parsed value.
+ * @param	index	Pointer to the structural index.
+ * @return	True if OK.
+ */
+static bool _yjson_fast_check_end(yjson_parser_t *json, _yjson_index_t *index) {
+	const char *next = json->input + index->positions[index->current];
+	const char *pt = json->ptr;
+
+	while (pt < next && isspace(*pt))
+		++pt;
+	if (pt != next) {
+		json->ptr = (char*)pt;
+		json->status = YESYNTAX;
+		return (false);
+	}
+	return (true);
+}
+/* Parse an array from the structural index. The opening bracket was already read. */
+static void _yjson_fast_array(yjson_parser_t *json, _yjson_index_t *index, yvar_t *value) {
+	ytable_t *table = _yjson_table_new(json, false, index->lengths[index->current_length++]);
+	if (!table)
+		return;
+	json->ptr = json->input + index->positions[index->current];
+	if (*json->ptr == RBRACKET) {
+		++index->current;
+		yvar_init_table(value, table);
+		return;
+	}
+	for (; ; ) {
+		// get value
+		yvar_t val = _yjson_fast_value(json, index);
+		if (json->status != YENOERR)
+			goto error;
+		yvar_t *pval = _yjson_value_alloc(json, &val);
+		if (!pval) {
+			_yjson_value_discard(json, &val);
+			goto error;
+		}
+		ytable_add(table, pval);
+		// process the rest
+		json->ptr = json->input + index->positions[index->current];
+		++index->current;
+		if (*json->ptr == RBRACKET) {
+			yvar_init_table(value, table);
+			return;
+		} else if (*json->ptr != COMMA) {
+			json->status = YESYNTAX;
+			goto error;
+		}
+		// trailing comma
+		if (json->input[index->positions[index->current]] == RBRACKET) {
+			++index->current;
+			yvar_init_table(value, table);
+			return;
+		}
+	}
+error:
+	yvar_init_table(value, table);
+	_yjson_value_discard(json, value);
+}
+/* Parse an object from the structural index. The opening brace was already read. */
+static void _yjson_fast_object(yjson_parser_t *json, _yjson_index_t *index, yvar_t *value) {
+	ytable_t *table = _yjson_table_new(json, true, index->lengths[index->current_length++]);
+	if (!table)
+		return;
+	json->ptr = json->input + index->positions[index->current];
+	if (*json->ptr == RBRACE) {
+		++index->current;
+		yvar_init_table(value, table);
+		return;
+	}
+	for (; ; ) {
+		// get key
+		json->ptr = json->input + index->positions[index->current];
+		if (*json->ptr != DQUOTE) {
+			json->status = YESYNTAX;
+			goto error;
+		}
+		yvar_t val_key = _yjson_fast_value(json, index);
+		if (json->status != YENOERR)
+			goto error;
+		ystr_t key = yvar_get_string(&val_key);
+		// search colon character
+		json->ptr = json->input + index->positions[index->current];
+		if (*json->ptr != COLON) {
+			_yjson_value_discard(json, &val_key);
+			json->status = YESYNTAX;
+			goto error;
+		}
+		++index->current;
+		// get value
+		yvar_t val = _yjson_fast_value(json, index);
+		yvar_t *pval = (json->status == YENOERR) ? _yjson_value_alloc(json, &val) : NULL;
+		if (!pval) {
+			_yjson_value_discard(json, &val);
+			_yjson_value_discard(json, &val_key);
+			goto error;
+		}
+		ytable_set_key(table, key, pval);
+		// process the rest
+		json->ptr = json->input + index->positions[index->current];
+		++index->current;
+		if (*json->ptr == RBRACE) {
+			yvar_init_table(value, table);
+			return;
+		} else if (*json->ptr != COMMA) {
+			json->status = YESYNTAX;
+			goto error;
+		}
+		// trailing comma
+		if (json->input[index->positions[index->current]] == RBRACE) {
+			++index->current;
+			yvar_init_table(value, table);
+			return;
+		}
+	}
+error:
+	yvar_init_table(value, table);
+	_yjson_value_discard(json, value);
+}
+/*
+ * Create the table of a parsed array or object.
+ * @param	json		Pointer to the parser.
+ * @param	is_object	True for an object.
+ * @param	size		Expected number of elements (0 if unknown).
+ * @return	A pointer to the allocated table, or NULL if an error occurred.
+ */
+static ytable_t *_yjson_table_new(yjson_parser_t *json, bool is_object, size_t size) {
+	ytable_t *table;
+	if (json->arena)
+		table = ytable_create_arena(size, json->arena);
+	else if (size > _YJSON_TABLE_MAX_PRESIZE)
+		table = ytable_create(0, NULL, (is_object ? json : NULL));
+	else
+		table = ytable_create(size, NULL, (is_object ? json : NULL));
+	if (!table)
+		json->status = YENOMEM;
+	return (table);
+}
+/*
+ * Move a value to an allocated yvar (allocated from the parser's arena, if any).
+ * @param	json	Pointer to the parser.
+ * @param	value	Pointer to the value.
+ * @return	A pointer to the allocated yvar, or NULL if an error occurred.
+ */
+static yvar_t *_yjson_value_alloc(yjson_parser_t *json, yvar_t *value) {
+	yvar_t *result = json->arena ? yarena_alloc(json->arena, sizeof(yvar_t)) :
+	                 malloc0(sizeof(yvar_t));
+	if (!result) {
+		json->status = YENOMEM;
+		return (NULL);
+	}
+	*result = *value;
+	return (result);
+}
+/*
+ * Free the content of a value created by a parser, and set it as undefined.
+ * Nothing is freed if the value was allocated from an arena.
+ * @param	json	Pointer to the parser.
+ * @param	value	Pointer to the value.
+ */
+static void _yjson_value_discard(yjson_parser_t *json, yvar_t *value) {
+	if (json->arena)
+		yvar_init_undef(value);
+	else
+		_yjson_value_release(value);
+}
+/*
+ * Free the content of a parsed value (but not the yvar itself), and set it as undefined.
+ * Sub-values and keys of tables are freed recursively, unless they are still shared with
+ * clones of the table.
+ * @param	value	Pointer to the value.
+ */
+static void _yjson_value_release(yvar_t *value) {
+	if (value->type == YVAR_STRING) {
+		ys_free(value->string_value);
+	} else if (value->type == YVAR_TABLE && ytable_is_shared(value->table_value)) {
+		ytable_free(value->table_value);
+	} else if (value->type == YVAR_TABLE) {
+		ytable_iterator_t it = ytable_iterator(value->table_value);
+		while (ytable_iterator_next(&it)) {
+			_yjson_value_release(it.data);
+			free0(it.data);
+			ys_free((char*)it.key);
+		}
+		ytable_free(value->table_value);
+	}
+	yvar_init_undef(value);
+}
+
+/* ********** INCREMENTAL PARSING ********** */
+/*
+ * Start a new incremental parsing.
+ * @param	json	Pointer to the parser.
+ * @param	sax	Pointer to the event-based parser, or NULL to build a value tree.
+ * @return	YENOERR if OK.
+ */
+static ystatus_t _yjson_stream_init(yjson_parser_t *json, yjson_sax_t *sax) {
+	yjson_init();
+	*json = (yjson_parser_t){
+		.status = YENOERR,
+		.stream = malloc0(sizeof(_yjson_stream_t)),
+	};
+	if (!json->stream || !(json->stream->token = ys_new(""))) {
+		_yjson_stream_free(json->stream);
+		json->stream = NULL;
+		return ((json->status = YENOMEM));
+	}
+	json->stream->sax = sax;
+	return (YENOERR);
+}
+/* Free the state of an incremental parsing, with the values that were not returned. */
+static void _yjson_stream_free(_yjson_stream_t *stream) {
+	if (!stream)
+		return;
+	for (size_t i = 0; i < stream->depth; ++i) {
+		if (stream->frames[i].table) {
+			yvar_t value;
+			yvar_init_table(&value, stream->frames[i].table);
+			_yjson_value_release(&value);
+		}
+		ys_free(stream->frames[i].key);
+	}
+	if (stream->has_root)
+		_yjson_value_release(&stream->root);
+	free0(stream->frames);
+	ys_free(stream->token);
+	free0(stream);
+}
+/*
+ * Process a character found between two tokens.
+ * @param	json	Pointer to the parser.
+ * @param	c	The character.
+ */
+static void _yjson_stream_char(yjson_parser_t *json, char c) {
+	_yjson_stream_t *stream = json->stream;
+	_yjson_frame_t *frame = stream->depth ? &stream->frames[stream->depth - 1] : NULL;
+
+	if (isspace(c)) {
+		if (c == LF)
+			++json->line;
+	} else if (c == SLASH) {
+		stream->lexer = _YJSON_LEX_SLASH;
+	} else if (c == LBRACE || c == LBRACKET) {
+		if (_yjson_stream_can_start(json, false))
+			_yjson_stream_open(json, (c == LBRACE));
+	} else if (c == RBRACE || c == RBRACKET) {
+		_yjson_stream_close(json, (c == RBRACE));
+	} else if (c == COMMA) {
+		if (!frame || frame->expect != _YJSON_EXPECT_NEXT)
+			json->status = YESYNTAX;
+		else
+			frame->expect = frame->is_object ? _YJSON_EXPECT_KEY : _YJSON_EXPECT_VALUE;
+	} else if (c == COLON) {
+		if (!frame || frame->expect != _YJSON_EXPECT_COLON)
+			json->status = YESYNTAX;
+		else
+			frame->expect = _YJSON_EXPECT_VALUE;
+	} else if (c == DQUOTE) {
+		if (_yjson_stream_can_start(json, true)) {
+			ys_trunc(stream->token);
+			stream->lexer = _YJSON_LEX_STRING;
+		}
+	} else if (_yjson_stream_can_start(json, false)) {
+		ys_trunc(stream->token);
+		ys_addc(&stream->token, c);
+		stream->lexer = _YJSON_LEX_SCALAR;
+	}
+}
+/*
+ * Check if a value could start at the current position. Set a syntax error if not.
+ * @param	json		Pointer to the parser.
+ * @param	is_string	True if the value is a string (that could be an object key).
+ * @return	True if the value could start.
+ */
+static bool _yjson_stream_can_start(yjson_parser_t *json, bool is_string) {
+	_yjson_stream_t *stream = json->stream;
+
+	if (!stream->depth) {
+		if (!stream->has_root)
+			return (true);
+	} else {
+		_yjson_frame_t *frame = &stream->frames[stream->depth - 1];
+		if (frame->expect == _YJSON_EXPECT_VALUE ||
+		    (frame->expect == _YJSON_EXPECT_KEY && is_string))
+			return (true);
+	}
+	json->status = YESYNTAX;
+	return (false);
+}
+/* Open an array or an object. */
+static void _yjson_stream_open(yjson_parser_t *json, bool is_object) {
+	_yjson_stream_t *stream = json->stream;
+
+	if (stream->depth == stream->size) {
+		size_t new_size = stream->size ? (stream->size * 2) : 16;
+		_yjson_frame_t *frames = realloc0(stream->frames, new_size * sizeof(_yjson_frame_t));
+		if (!frames) {
+			json->status = YENOMEM;
+			return;
+		}
+		stream->frames = frames;
+		stream->size = new_size;
+	}
+	// event-based parsing: call the handler, no table is created
+	ytable_t *table = NULL;
+	yjson_sax_t *sax = stream->sax;
+	if (sax) {
+		if (is_object && sax->start_object_hdlr)
+			sax->start_object_hdlr(sax);
+		else if (!is_object && sax->start_array_hdlr)
+			sax->start_array_hdlr(sax);
+	} else if (!(table = _yjson_table_new(json, is_object, 0))) {
+		return;
+	}
+	stream->frames[stream->depth++] = (_yjson_frame_t){
+		.table = table,
+		.is_object = is_object,
+		.expect = is_object ? _YJSON_EXPECT_KEY : _YJSON_EXPECT_VALUE,
+	};
+}
+/* Close an array or an object. */
+static void _yjson_stream_close(yjson_parser_t *json, bool is_object) {
+	_yjson_stream_t *stream = json->stream;
+	_yjson_frame_t *frame = stream->depth ? &stream->frames[stream->depth - 1] : NULL;
+	yvar_t value;
+
+	// trailing commas are accepted, like with yjson_parse()
+	if (!frame || frame->is_object != is_object ||
+	    (frame->expect != _YJSON_EXPECT_NEXT &&
+	     frame->expect != (is_object ? _YJSON_EXPECT_KEY : _YJSON_EXPECT_VALUE))) {
+		json->status = YESYNTAX;
+		return;
+	}
+	--stream->depth;
+	// event-based parsing: call the handler
+	yjson_sax_t *sax = stream->sax;
+	if (sax) {
+		if (is_object && sax->end_object_hdlr)
+			sax->end_object_hdlr(sax);
+		else if (!is_object && sax->end_array_hdlr)
+			sax->end_array_hdlr(sax);
+		_yjson_stream_value(json, NULL);
+		return;
+	}
+	yvar_init_table(&value, frame->table);
+	_yjson_stream_value(json, &value);
+}
+/* Decode the string stored in the current token (without its double quotes). */
+static void _yjson_stream_string(yjson_parser_t *json) {
+	_yjson_stream_t *stream = json->stream;
+	yvar_t value;
+
+	// the closing double quote is needed by the string parser
+	ys_addc(&stream->token, DQUOTE);
+	yjson_parser_t sub = {
+		.input = stream->token,
+		.ptr = stream->token,
+		.end = stream->token + ys_bytesize(stream->token),
+		.status = YENOERR,
+	};
+	_yjson_parse_string(&sub, &value);
+	json->line += sub.line;
+	if ((json->status = sub.status) != YENOERR)
+		return;
+	_yjson_stream_value(json, &value);
+}
+/* Decode the number or literal stored in the current token. */
+static void _yjson_stream_scalar(yjson_parser_t *json) {
+	_yjson_stream_t *stream = json->stream;
+	char *token = stream->token;
+	yvar_t value;
+
+	if (!strcasecmp(token, "null")) {
+		yvar_init_null(&value);
+	} else if (!strcasecmp(token, "false")) {
+		yvar_init_bool(&value, false);
+	} else if (!strcasecmp(token, "true")) {
+		yvar_init_bool(&value, true);
+	} else {
+		yjson_parser_t sub = {
+			.input = token,
+			.ptr = token,
+			.status = YENOERR,
+		};
+		_yjson_parse_number(&sub, &value);
+		if (sub.status != YENOERR || *sub.ptr != '\0') {
+			json->status = YESYNTAX;
+			return;
+		}
+	}
+	_yjson_stream_value(json, &value);
+}
+/*
+ * Add a complete value to the current array or object, or set it as the root value.
+ * With an event-based parsing, the value is given to the handler and then released.
+ * The value is released if an error occurs.
+ * @param	json	Pointer to the parser.
+ * @param	value	Pointer to the value, or NULL for an array or object
+ *			read by an event-based parsing.
+ */
+static void _yjson_stream_value(yjson_parser_t *json, yvar_t *value) {
+	_yjson_stream_t *stream = json->stream;
+	_yjson_frame_t *frame = stream->depth ? &stream->frames[stream->depth - 1] : NULL;
+	yjson_sax_t *sax = stream->sax;
+
+	// event-based parsing
+	if (sax) {
+		if (frame && frame->expect == _YJSON_EXPECT_KEY) {
+			if (sax->key_hdlr)
+				sax->key_hdlr(sax, value->string_value);
+			frame->expect = _YJSON_EXPECT_COLON;
+		} else {
+			if (value && sax->value_hdlr)
+				sax->value_hdlr(sax, value);
+			if (frame)
+				frame->expect = _YJSON_EXPECT_NEXT;
+			else
+				stream->has_root = true;
+		}
+		if (value)
+			_yjson_value_release(value);
+		return;
+	}
+	// root value
+	if (!frame) {
+		stream->root = *value;
+		stream->has_root = true;
+		return;
+	}
+	// object key
+	if (frame->expect == _YJSON_EXPECT_KEY) {
+		frame->key = yvar_get_string(value);
+		frame->expect = _YJSON_EXPECT_COLON;
+		return;
+	}
+	// array or object value
+	yvar_t *pval = _yjson_value_alloc(json, value);
+	if (!pval) {
+		_yjson_value_release(value);
+		return;
+	}
+	if (frame->is_object) {
+		ytable_set_key(frame->table, frame->key, pval);
+		frame->key = NULL;
+	} else {
+		ytable_add(frame->table, pval);
+	}
+	frame->expect = _YJSON_EXPECT_NEXT;
+}
+
+/* ********** SERIALIZATION ********** */
+/* Pairs of decimal digits, used to convert integers. */
+static const char _yjson_digits[] =
+	"00010203040506070809101112131415161718192021222324252627282930313233343536373839"
+	"40414243444546474849505152535455565758596061626364656667686970717273747576777879"
+	"8081828384858687888990919293949596979899";
+/* Powers of ten that are exactly representable as doubles. */
+static const double _yjson_pow10[] = {
+	1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9
+};
+
+/*
+ * Serialize a value using a writer, and flush the writer.
+ * @param	value	Pointer to the value.
+ * @param	writer	Pointer to the writer.
+ * @return	The writer status.
+ */
+static ystatus_t _yjson_write(yvar_t *value, _yjson_writer_t *writer) {
+	yjson_init();
+	_yjson_write_value(writer, value, 0);
+	if (writer->pretty)
+		_yjson_writer_append(writer, "\n", 1);
+	_yjson_writer_flush(writer);
+	return (writer->status);
+}
+/* Send data to the destination of a writer. */
+static void _yjson_writer_send(_yjson_writer_t *writer, const char *data, size_t len) {
+	if (!len || writer->status != YENOERR)
+		return;
+	if (writer->str) {
+		writer->status = ys_nappend(writer->str, data, len);
+	} else if (writer->bin) {
+		writer->status = ybin_append(writer->bin, (void*)data, len);
+	} else {
+		while (len) {
+			ssize_t n = write(writer->fd, data, len);
+			if (n < 0 && errno == EINTR)
+				continue;
+			if (n <= 0) {
+				writer->status = YEIO;
+				return;
+			}
+			data += n;
+			len -= (size_t)n;
+		}
+	}
+}
+/* Send the content of the buffer to the destination. */
+static void _yjson_writer_flush(_yjson_writer_t *writer) {
+	_yjson_writer_send(writer, writer->buffer, writer->len);
+	writer->len = 0;
+}
+/* Add data to the buffer of a writer. */
+static void _yjson_writer_append(_yjson_writer_t *writer, const char *data, size_t len) {
+	if (writer->len + len > sizeof(writer->buffer)) {
+		_yjson_writer_flush(writer);
+		// big chunks are not copied in the buffer
+		if (len > sizeof(writer->buffer)) {
+			_yjson_writer_send(writer, data, len);
+			return;
+		}
+	}
+	memcpy(writer->buffer + writer->len, data, len);
+	writer->len += len;
+}
+/* Write a value and its subvalues. */
+static void _yjson_write_value(_yjson_writer_t *writer, yvar_t *value, uint32_t depth) {
+	if (writer->status != YENOERR)
+		return;
+	if (!value) {
+		_yjson_writer_append(writer, "null", 4);
+		return;
+	}
+	switch (value->type) {
+	case YVAR_BOOL:
+		if (value->bool_value)
+			_yjson_writer_append(writer, "true", 4);
+		else
+			_yjson_writer_append(writer, "false", 5);
+		break;
+	case YVAR_INT:
+		_yjson_write_int(writer, value->int_value);
+		break;
+	case YVAR_FLOAT:
+		_yjson_write_float(writer, value->float_value);
+		break;
+	case YVAR_STRING:
+		_yjson_write_string(writer, value->string_value);
+		break;
+	case YVAR_TABLE:
+		_yjson_write_table(writer, value->table_value, depth);
+		break;
+	default:
+		_yjson_writer_append(writer, "null", 4);
+		break;
+	}
+}
+/* Write a table and its elements. */
+static void _yjson_write_table(_yjson_writer_t *writer, ytable_t *table, uint32_t depth) {
+	bool is_array = ytable_is_array(table);
+	size_t count = 0;
+
+	_yjson_writer_append(writer, (is_array ? "[" : "{"), 1);
+	ytable_iterator_t it = ytable_iterator(table);
+	while (writer->status == YENOERR && ytable_iterator_next(&it)) {
+		if (count++)
+			_yjson_writer_append(writer, ",", 1);
+		if (writer->pretty) {
+			_yjson_writer_append(writer, "\n", 1);
+			_yjson_write_indent(writer, depth + 1);
+		}
+		if (!is_array) {
+			if (it.key) {
+				_yjson_write_string(writer, it.key);
+			} else {
+				_yjson_writer_append(writer, "\"", 1);
+				_yjson_write_uint(writer, it.hash);
+				_yjson_writer_append(writer, "\"", 1);
+			}
+			if (writer->pretty)
+				_yjson_writer_append(writer, ": ", 2);
+			else
+				_yjson_writer_append(writer, ":", 1);
+		}
+		_yjson_write_value(writer, it.data, depth + 1);
+	}
+	if (count && writer->pretty) {
+		_yjson_writer_append(writer, "\n", 1);
+		_yjson_write_indent(writer, depth);
+	}
+	_yjson_writer_append(writer, (is_array ? "]" : "}"), 1);
+}
+/* Write tabulations. */
+static void _yjson_write_indent(_yjson_writer_t *writer, uint32_t depth) {
+	static const char tabs[] = "\t\t\t\t\t\t\t\t\t\t\t\t\t\t\t\t";
+
+	while (depth) {
+		uint32_t n = (depth < sizeof(tabs) - 1) ? depth : (sizeof(tabs) - 1);
+		_yjson_writer_append(writer, tabs, n);
+		depth -= n;
+	}
+}
+/* Write an escaped string, with its double quotes. */
+static void _yjson_write_string(_yjson_writer_t *writer, const char *str) {
+	static const char hex[] = "0123456789abcdef";
+	const char *str_end = str + strlen(str);
+
+	_yjson_writer_append(writer, "\"", 1);
+	for (; ; ) {
+		// copy all characters until the next one that must be escaped
+		const char *end = _yjson_scan_string(str, str_end);
+		if (end != str)
+			_yjson_writer_append(writer, str, end - str);
+		str = end;
+		unsigned char c = *str;
+		if (c == '\0')
+			break;
+		char escaped[6] = {'\\', c, '\0', '\0', '\0', '\0'};
+		size_t len = 2;
+		switch (c) {
+		case '"':
+		case '\\':
+			break;
+		case '\b':
+			escaped[1] = 'b';
+			break;
+		case '\f':
+			escaped[1] = 'f';
+			break;
+		case '\n':
+			escaped[1] = 'n';
+			break;
+		case '\r':
+			escaped[1] = 'r';
+			break;
+		case '\t':
+			escaped[1] = 't';
+			break;
+		default:
+			escaped[1] = 'u';
+			escaped[2] = '0';
+			escaped[3] = '0';
+			escaped[4] = hex[c >> 4];
+			escaped[5] = hex[c & 0xF];
+			len = 6;
+			break;
+		}
+		_yjson_writer_append(writer, escaped, len);
+		++str;
+	}
+	_yjson_writer_append(writer, "\"", 1);
+}
+/* Write an unsigned integer, two digits at a time. */
+static void _yjson_write_uint(_yjson_writer_t *writer, uint64_t value) {
+	char buf[20];
+	char *pt = buf + sizeof(buf);
+
+	while (value >= 100) {
+		unsigned int i = (unsigned int)(value % 100) * 2;
+		value /= 100;
+		*--pt = _yjson_digits[i + 1];
+		*--pt = _yjson_digits[i];
+	}
+	if (value >= 10) {
+		unsigned int i = (unsigned int)value * 2;
+		*--pt = _yjson_digits[i + 1];
+		*--pt = _yjson_digits[i];
+	} else {
+		*--pt = (char)('0' + value);
+	}
+	_yjson_writer_append(writer, pt, buf + sizeof(buf) - pt);
+}
+/* Write a signed integer. */
+static void _yjson_write_int(_yjson_writer_t *writer, int64_t value) {
+	if (value < 0) {
+		_yjson_writer_append(writer, "-", 1);
+		_yjson_write_uint(writer, (uint64_t)0 - (uint64_t)value);
+	} else {
+		_yjson_write_uint(writer, (uint64_t)value);
+	}
+}
+/*
+ * Write a floating-point number, with the shortest representation that gives back
+ * the same number when parsed. Numbers with up to 9 decimals are converted without
+ * printf(); the others use "%.15g" or "%.17g". The written number always contains a
+ * dot, to be read back as a floating-point number.
+ */
+static void _yjson_write_float(_yjson_writer_t *writer, double value) {
+	char buf[40];
+
+	if (!isfinite(value)) {
+		_yjson_writer_append(writer, "null", 4);
+		return;
+	}
+	if (signbit(value)) {
+		_yjson_writer_append(writer, "-", 1);
+		value = -value;
+	}
+	// fast path: value == m / 10^k, with m < 2^53
+	for (int k = 0; k < (int)(sizeof(_yjson_pow10) / sizeof(double)); ++k) {
+		double scaled = value * _yjson_pow10[k];
+		if (scaled >= 9007199254740992.0)
+			break;
+		uint64_t m = (uint64_t)scaled;
+		if ((double)m != scaled || (double)m / _yjson_pow10[k] != value)
+			continue;
+		uint64_t divisor = (uint64_t)_yjson_pow10[k];
+		_yjson_write_uint(writer, m / divisor);
+		_yjson_writer_append(writer, ".", 1);
+		if (!k) {
+			_yjson_writer_append(writer, "0", 1);
+			return;
+		}
+		// decimals, with leading zeros
+		uint64_t decimals = m % divisor;
+		for (int i = k - 1; i >= 0; --i) {
+			buf[i] = (char)('0' + (decimals % 10));
+			decimals /= 10;
+		}
+		_yjson_writer_append(writer, buf, k);
+		return;
+	}
+	// slow path, in the "C" locale whatever the current locale is
+	pthread_once(&_yjson_c_locale_once, _yjson_c_locale_init);
+	locale_t previous = _yjson_c_locale ? uselocale(_yjson_c_locale) : (locale_t)0;
+	int len = snprintf(buf, sizeof(buf) - 2, "%.15g", value);
+	double parsed = _yjson_c_locale ? strtod_l(buf, NULL, _yjson_c_locale) : strtod(buf, NULL);
+	if (parsed != value)
+		len = snprintf(buf, sizeof(buf) - 2, "%.17g", value);
+	if (previous)
+		uselocale(previous);
+	char *exp = strchr(buf, 'e');
+	if (!strchr(buf, '.')) {
+		// add ".0" before the exponent
+		size_t pos = exp ? (size_t)(exp - buf) : (size_t)len;
+		memmove(buf + pos + 2, buf + pos, len - pos + 1);
+		buf[pos] = '.';
+		buf[pos + 1] = '0';
+		len += 2;
+	}
+	_yjson_writer_append(writer, buf, len);
+}
@@ -11,26 +11,95 @@ extern "C" {
 #endif /* __cplusplus || c_plusplus */
 
 #include "ystatus.h"
+#include "yarena.h"
+#include "ystr.h"
 
 /**
  * @typedef	yjson_parser_t
  * 		JSON parser structure.
  * @field	input	Pointer to the input string.
  * @field	ptr	Pointer to the currently parsed character.
+ * @field	end	Pointer to the terminating NUL character of the input.
  * @field	line	Number of the currently parsed line.
  * @field	status	Parsing status.
+ * @field	stream	Pointer to the state of an incremental parsing (see yjson_feed()).
+ * @field	arena	Pointer to the arena used to allocate the parsed values (see
+ *			yjson_parse_arena()), or NULL to use the heap.
+ * @field	buffer	String buffer used to decode strings when using an arena.
  */
 typedef struct {
 	char *input;
 	char *ptr;
+	char *end;
 	unsigned int line;
 	ystatus_t status;
+	struct yjson_stream_s *stream;
+	yarena_t *arena;
+	ystr_t buffer;
 } yjson_parser_t;
 
+#include <stdio.h>
 #include <stdbool.h>
 #include "yvar.h"
 #include "y.h"
 
+/** @define YJSON_SAX_DATA Provide direct access to JSON SAX parsing data. */
+#define YJSON_SAX_DATA(x)	(((yjson_sax_t*)x)->parse_data)
+
+/**
+ * @typedef	yjson_sax_t
+ *		Event-based (SAX-like) JSON parser. No value tree is created; handlers
+ *		are called for each event found in the JSON stream:
+ *		<ul>
+ *		<li>Start and end of objects and arrays:
+ *		<pre>void func(yjson_sax_t *sax);</pre></li>
+ *		<li>Object keys:
+ *		<pre>void func(yjson_sax_t *sax, ystr_t key);</pre></li>
+ *		<li>Scalar values (null, booleans, numbers, strings), including the
+ *		values of arrays and objects:
+ *		<pre>void func(yjson_sax_t *sax, yvar_t *value);</pre></li>
+ *		</ul>
+ *		Keys and values given to handlers are freed by the parser when the
+ *		handler returns; they must be copied to be kept.
+ *		A handler may call yjson_sax_stop() to end the parsing.
+ * @field	parser			JSON parser used to read the data.
+ * @field	parse_data		Pointer to some data (for handlers using).
+ * @field	start_object_hdlr	Function pointer called when an object starts.
+ * @field	end_object_hdlr		Function pointer called when an object ends.
+ * @field	start_array_hdlr	Function pointer called when an array starts.
+ * @field	end_array_hdlr		Function pointer called when an array ends.
+ * @field	key_hdlr		Function pointer called for object keys.
+ * @field	value_hdlr		Function pointer called for scalar values.
+ */
+typedef struct yjson_sax_s {
+	yjson_parser_t parser;
+	void *parse_data;
+	void (*start_object_hdlr)(struct yjson_sax_s*);
+	void (*end_object_hdlr)(struct yjson_sax_s*);
+	void (*start_array_hdlr)(struct yjson_sax_s*);
+	void (*end_array_hdlr)(struct yjson_sax_s*);
+	void (*key_hdlr)(struct yjson_sax_s*, ystr_t);
+	void (*value_hdlr)(struct yjson_sax_s*, yvar_t*);
+} yjson_sax_t;
+
+/**
+ * @typedef	yjson_line_function_t
+ *		Function called for each line parsed by yjson_parse_lines_callback().
+ * @param	line		Index of the line (starting at 0).
+ * @param	result		Pointer to the parsing result of the line. The function takes
+ *				the ownership of the parsed value.
+ * @param	user_data	Pointer to some user data.
+ * @return	YENOERR to continue the parsing, any other value to stop it.
+ */
+typedef ystatus_t (*yjson_line_function_t)(size_t line, yres_var_t *result, void *user_data);
+
+/**
+ * @function	yjson_init
+ *		Choose the parsing and serialization functions best suited to the current
+ *		CPU (SIMD instruction sets). Done only once; called by all the parsing and
+ *		serialization functions, so an explicit call is not needed. Thread-safe.
+ */
+void yjson_init(void);
 /**
  * @function	yjson_new
  *		Create a new JSON parser.
@@ -54,6 +123,241 @@ void yjson_free(yjson_parser_t *json);
  */
 yres_var_t yjson_parse(yjson_parser_t *json, char *input);
 
+/**
+ * @function	yjson_parse_fast
+ *		Starts a JSON parser which works in two stages: a structural index
+ *		of the whole input is built first (using SIMD instructions when
+ *		available), then the value tree is created from this index.
+ *		The index also gives the number of elements of each array and object,
+ *		so their tables are allocated at once. The result is the same as with
+ *		yjson_parse(). The gain is the highest on documents made of numbers
+ *		and big arrays; otherwise the allocation of the nodes dominates (see
+ *		yjson_parse_arena()). Inputs containing comments are handed over to
+ *		yjson_parse().
+ * @param	json	Pointer to the JSON parser object.
+ * @param	input	Pointer to the string to parse.
+ * @return	The root node value.
+ */
+yres_var_t yjson_parse_fast(yjson_parser_t *json, char *input);
+
+/**
+ * @function	yjson_parse_arena
+ *		Starts a JSON parser (the same way as yjson_parse_fast()) which allocates
+ *		the whole document from an arena: yvar nodes, strings and tables (with
+ *		their elements and hashmaps). No memory is allocated on the heap for the
+ *		document, which is released at once with yarena_free() or yarena_reset().
+ *		The returned values must not be freed (yvar_delete(), ys_free(),
+ *		ytable_free()...) nor extended individually.
+ *		<pre>
+ *		yarena_t *arena = yarena_new(0);
+ *		yres_var_t res = yjson_parse_arena(&json, input, arena);
+ *		...
+ *		yarena_free(arena);
+ *		</pre>
+ * @param	json	Pointer to the JSON parser object.
+ * @param	input	Pointer to the string to parse.
+ * @param	arena	Pointer to the arena.
+ * @return	The root node value.
+ */
+yres_var_t yjson_parse_arena(yjson_parser_t *json, char *input, yarena_t *arena);
+
+/**
+ * @function	yjson_parse_lines
+ *		Parse newline-delimited JSON (NDJSON, JSON Lines): each line of the input
+ *		is a separate JSON value. The input is split in chunks of lines, which are
+ *		parsed (with yjson_parse_fast()) by a pool of worker threads.
+ *		The input is modified (newline characters are replaced by NUL characters),
+ *		so a memory-mapped file must be mapped with write access (MAP_PRIVATE and
+ *		PROT_WRITE are enough). The input doesn't need to be NUL-terminated.
+ *		There is one result per line, including empty lines (their value is
+ *		undefined). A newline at the end of the input doesn't start a new line.
+ * @param	input		Pointer to the input.
+ * @param	len		Size of the input.
+ * @param	nb_threads	Number of worker threads. If set to zero, one thread per
+ *				online processor is used.
+ * @param	results		Pointer to the array of results, in input order. Each result
+ *				contains the parsing status and the value of a line. The
+ *				array must be freed with free0(); the parsed values belong
+ *				to the caller.
+ * @param	count		Pointer to the number of results.
+ * @return	YENOERR if OK (even if some lines couldn't be parsed), or an error code
+ *		if the parsing couldn't be done.
+ */
+ystatus_t yjson_parse_lines(char *input, size_t len, uint32_t nb_threads, yres_var_t **results,
+                            size_t *count);
+/**
+ * @function	yjson_parse_lines_callback
+ *		Parse newline-delimited JSON, like yjson_parse_lines(), but give the result
+ *		of each line to a callback function instead of returning an array.
+ *		The function is called from the worker threads, concurrently and not in
+ *		input order (the index of the line is given), so it must be thread-safe.
+ * @param	input		Pointer to the input.
+ * @param	len		Size of the input.
+ * @param	nb_threads	Number of worker threads. If set to zero, one thread per
+ *				online processor is used.
+ * @param	func		Function called for each line.
+ * @param	user_data	Pointer given to the function.
+ * @return	YENOERR if OK, the value returned by the function if it stopped the
+ *		parsing, or another error code if the parsing couldn't be done.
+ */
+ystatus_t yjson_parse_lines_callback(char *input, size_t len, uint32_t nb_threads,
+                                     yjson_line_function_t func, void *user_data);
+
+/**
+ * @function	yjson_feed
+ *		Give a chunk of data to an incremental JSON parser. The chunk doesn't
+ *		need to be NUL-terminated and may stop anywhere (inside a string, an
+ *		escape sequence, a number...); the parsing state is kept until the
+ *		next call. The chunk is not modified and may be freed after the call.
+ *		The first call after the creation of the parser (or after a call to
+ *		yjson_finish()) starts a new parsing.
+ * @param	json	Pointer to the JSON parser object.
+ * @param	chunk	Pointer to the data.
+ * @param	len	Size of the data.
+ * @return	YENOERR if OK, or the parsing error (which is also stored in the
+ *		parser and returned by subsequent calls).
+ */
+ystatus_t yjson_feed(yjson_parser_t *json, const char *chunk, size_t len);
+/**
+ * @function	yjson_finish
+ *		End an incremental parsing started with yjson_feed(), and return the
+ *		parsed value. The parser's state is freed, so it could be reused.
+ * @param	json	Pointer to the JSON parser object.
+ * @return	The root node value.
+ */
+yres_var_t yjson_finish(yjson_parser_t *json);
+
+/**
+ * @function	yjson_sax_new
+ *		Create an event-based JSON parser.
+ * @param	parse_data	Pointer to data that can be used by handlers.
+ * @return	A pointer to the created parser, or NULL if an error occurs.
+ */
+yjson_sax_t *yjson_sax_new(void *parse_data);
+/**
+ * @function	yjson_sax_free
+ *		Destroy an event-based JSON parser.
+ * @param	sax	A pointer to the parser.
+ */
+void yjson_sax_free(yjson_sax_t *sax);
+/**
+ * @function	yjson_sax_set_object_hdlr
+ *		Set the handlers called at the start and at the end of objects.
+ * @param	sax		A pointer to the parser.
+ * @param	start_hdlr	Function pointer to the handler called when an object starts.
+ * @param	end_hdlr	Function pointer to the handler called when an object ends.
+ */
+void yjson_sax_set_object_hdlr(yjson_sax_t *sax, void (*start_hdlr)(yjson_sax_t*),
+                               void (*end_hdlr)(yjson_sax_t*));
+/**
+ * @function	yjson_sax_set_array_hdlr
+ *		Set the handlers called at the start and at the end of arrays.
+ * @param	sax		A pointer to the parser.
+ * @param	start_hdlr	Function pointer to the handler called when an array starts.
+ * @param	end_hdlr	Function pointer to the handler called when an array ends.
+ */
+void yjson_sax_set_array_hdlr(yjson_sax_t *sax, void (*start_hdlr)(yjson_sax_t*),
+                              void (*end_hdlr)(yjson_sax_t*));
+/**
+ * @function	yjson_sax_set_key_hdlr
+ *		Set the handler called for each object key.
+ * @param	sax	A pointer to the parser.
+ * @param	hdlr	Function pointer to the handler.
+ */
+void yjson_sax_set_key_hdlr(yjson_sax_t *sax, void (*hdlr)(yjson_sax_t*, ystr_t));
+/**
+ * @function	yjson_sax_set_value_hdlr
+ *		Set the handler called for each scalar value.
+ * @param	sax	A pointer to the parser.
+ * @param	hdlr	Function pointer to the handler.
+ */
+void yjson_sax_set_value_hdlr(yjson_sax_t *sax, void (*hdlr)(yjson_sax_t*, yvar_t*));
+/**
+ * @function	yjson_sax_feed
+ *		Give a chunk of JSON data to an event-based parser. Handlers are
+ *		called for all the events found in the chunk. See yjson_feed().
+ * @param	sax	A pointer to the parser.
+ * @param	chunk	Pointer to the data.
+ * @param	len	Size of the data.
+ * @return	YENOERR if OK, YEL2HLT if a handler stopped the parsing, or the
+ *		parsing error.
+ */
+ystatus_t yjson_sax_feed(yjson_sax_t *sax, const char *chunk, size_t len);
+/**
+ * @function	yjson_sax_finish
+ *		End an event-based parsing started with yjson_sax_feed().
+ * @param	sax	A pointer to the parser.
+ * @return	YENOERR if the whole JSON stream was correct, YEL2HLT if a handler
+ *		stopped the parsing, or the parsing error.
+ */
+ystatus_t yjson_sax_finish(yjson_sax_t *sax);
+/**
+ * @function	yjson_sax_read_memory
+ *		Parse a JSON string with an event-based parser.
+ * @param	sax	A pointer to the parser.
+ * @param	mem	A pointer to the NUL-terminated string to parse.
+ * @return	An error code that shows the return status of the parsing.
+ */
+ystatus_t yjson_sax_read_memory(yjson_sax_t *sax, const char *mem);
+/**
+ * @function	yjson_sax_read_stream
+ *		Parse a JSON stream with an event-based parser. The stream is read by
+ *		chunks, so the memory usage doesn't depend on the size of the data.
+ * @param	sax	A pointer to the parser.
+ * @param	stream	A pointer to an opened stream.
+ * @return	An error code that shows the return status of the parsing.
+ */
+ystatus_t yjson_sax_read_stream(yjson_sax_t *sax, FILE *stream);
+/**
+ * @function	yjson_sax_read_file
+ *		Parse a JSON file with an event-based parser.
+ * @param	sax		A pointer to the parser.
+ * @param	filename	Path to the file to parse.
+ * @return	An error code that shows the return status of the parsing.
+ */
+ystatus_t yjson_sax_read_file(yjson_sax_t *sax, const char *filename);
+/**
+ * @function	yjson_sax_stop
+ *		Stop an event-based parser. Use this function from a handler, if
+ *		the rest of the data is not needed or if an error was detected.
+ *		The parser will return an YEL2HLT error (Level 2 halted).
+ * @param	sax	A pointer to the parser.
+ */
+void yjson_sax_stop(yjson_sax_t *sax);
+
+/**
+ * @function	yjson_write_string
+ *		Serialize a JSON value node and its subnodes at the end of a ystring.
+ *		Strings and keys are escaped. Values that can't be represented in
+ *		JSON (undefined values, pointers, objects, binary data, NaN and
+ *		infinite numbers) are written as null.
+ * @param	value	Pointer to the value node.
+ * @param	dest	Pointer to the ystring (created if it points to NULL).
+ * @param	pretty	True to add newlines and tabulations.
+ * @return	YENOERR if OK.
+ */
+ystatus_t yjson_write_string(yvar_t *value, ystr_t *dest, bool pretty);
+/**
+ * @function	yjson_write_binary
+ *		Serialize a JSON value node and its subnodes at the end of a ybin.
+ *		See yjson_write_string().
+ * @param	value	Pointer to the value node.
+ * @param	dest	Pointer to the ybin.
+ * @param	pretty	True to add newlines and tabulations.
+ * @return	YENOERR if OK.
+ */
+ystatus_t yjson_write_binary(yvar_t *value, ybin_t *dest, bool pretty);
+/**
+ * @function	yjson_write_fd
+ *		Serialize a JSON value node and its subnodes to a file descriptor.
+ *		Data is written by large blocks. See yjson_write_string().
+ * @param	value	Pointer to the value node.
+ * @param	fd	File descriptor.
+ * @param	pretty	True to add newlines and tabulations.
+ * @return	YENOERR if OK, YEIO if a write error occurred.
+ */
+ystatus_t yjson_write_fd(yvar_t *value, int fd, bool pretty);
+
 /**
  * @function	yjson_print
  *		Prints a JSON value node and its subnodes, with newlines and tabulations.
@@ -0,0 +1,250 @@
+#include <pthread.h>
+#include <stdatomic.h>
+#include <unistd.h>
+#include "y.h"
+
+/* ************ PRIVATE DEFINITIONS AND MACROS ************ */
+/** @define _YJSON_LINES_MIN_CHUNK_SIZE Minimum size of the chunks given to worker threads. */
+#define _YJSON_LINES_MIN_CHUNK_SIZE	(64 * KB)
+/** @define _YJSON_LINES_CHUNKS_PER_THREAD Number of chunks per thread (for load balancing). */
+#define _YJSON_LINES_CHUNKS_PER_THREAD	16
+
+/* ************ PRIVATE STRUCTURES AND TYPES ************** */
+/**
+ * @typedef	_yjson_lines_chunk_t
+ *		Part of the input, made of complete lines.
+ * @field	start		Pointer to the first character of the chunk.
+ * @field	end		Pointer after the last character of the chunk.
+ * @field	first_line	Index of the first line of the chunk.
+ */
+typedef struct {
+	char *start;
+	char *end;
+	size_t first_line;
+} _yjson_lines_chunk_t;
+/**
+ * @typedef	_yjson_lines_t
+ *		State shared by the worker threads.
+ * @field	chunks		Array of chunks.
+ * @field	nb_chunks	Number of chunks.
+ * @field	next_chunk	Index of the next chunk to process.
+ * @field	counting	True during the first pass (lines counting).
+ * @field	results		Array of results (if results are returned in input order).
+ * @field	func		Function called for each line (if results are not returned).
+ * @field	user_data	Pointer given to the function.
+ * @field	status		Status of the processing.
+ */
+typedef struct {
+	_yjson_lines_chunk_t *chunks;
+	size_t nb_chunks;
+	atomic_size_t next_chunk;
+	bool counting;
+	yres_var_t *results;
+	yjson_line_function_t func;
+	void *user_data;
+	atomic_int status;
+} _yjson_lines_t;
+
+/* ********** DECLARATION OF PRIVATE FUNCTIONS ********** */
+static ystatus_t _yjson_lines_process(char *input, size_t len, uint32_t nb_threads,
+                                      _yjson_lines_t *lines, size_t *count);
+static ystatus_t _yjson_lines_run(_yjson_lines_t *lines, uint32_t nb_threads);
+static void *_yjson_lines_worker(void *param);
+static void _yjson_lines_count(_yjson_lines_chunk_t *chunk);
+static void _yjson_lines_parse(_yjson_lines_t *lines, _yjson_lines_chunk_t *chunk);
+
+/* ********** PUBLIC FUNCTIONS ********** */
+/* Parse newline-delimited JSON, results in input order. */
+ystatus_t yjson_parse_lines(char *input, size_t len, uint32_t nb_threads, yres_var_t **results,
+                            size_t *count) {
+	if (!results || !count)
+		return (YEPARAM);
+	*results = NULL;
+	*count = 0;
+	_yjson_lines_t lines = {0};
+	ystatus_t st = _yjson_lines_process(input, len, nb_threads, &lines, count);
+	if (st != YENOERR) {
+		// only allocation errors could happen, before any parsing
+		free0(lines.results);
+		*count = 0;
+		return (st);
+	}
+	*results = lines.results;
+	return (YENOERR);
+}
+/* Parse newline-delimited JSON, results given to a callback function. */
+ystatus_t yjson_parse_lines_callback(char *input, size_t len, uint32_t nb_threads,
+                                     yjson_line_function_t func, void *user_data) {
+	if (!func)
+		return (YEPARAM);
+	size_t count;
+	_yjson_lines_t lines = {
+		.func = func,
+		.user_data = user_data,
+	};
+	return (_yjson_lines_process(input, len, nb_threads, &lines, &count));
+}
+
+/* ********** PRIVATE FUNCTIONS ********** */
+/*
+ * Split the input in chunks, count the lines and parse them.
+ * @param	input		Pointer to the input.
+ * @param	len		Size of the input.
+ * @param	nb_threads	Number of worker threads (0 to use one thread per processor).
+ * @param	lines		Pointer to the processing state, initialized with the function
+ *				(or with nothing if the results must be returned).
+ * @param	count		Pointer to the number of lines.
+ * @return	YENOERR if OK.
+ */
+static ystatus_t _yjson_lines_process(char *input, size_t len, uint32_t nb_threads,
+                                      _yjson_lines_t *lines, size_t *count) {
+	if (!input && len)
+		return (YEPARAM);
+	// the functions used by the parser are chosen before any worker thread starts
+	yjson_init();
+	if (!nb_threads) {
+		long nb_cpus = sysconf(_SC_NPROCESSORS_ONLN);
+		nb_threads = (nb_cpus > 0) ? (uint32_t)nb_cpus : 1;
+	}
+	// split the input in chunks of complete lines
+	size_t chunk_size = MAX(len / ((size_t)nb_threads * _YJSON_LINES_CHUNKS_PER_THREAD),
+	                        _YJSON_LINES_MIN_CHUNK_SIZE);
+	size_t max_chunks = (len / chunk_size) + 1;
+	lines->chunks = malloc0(max_chunks * sizeof(_yjson_lines_chunk_t));
+	if (!lines->chunks)
+		return (YENOMEM);
+	for (char *pt = input, *end = input + len; pt < end; ) {
+		char *chunk_end = pt + MIN(chunk_size, (size_t)(end - pt));
+		if (chunk_end < end && chunk_end[-1] != LF) {
+			char *lf = memchr(chunk_end, LF, end - chunk_end);
+			chunk_end = lf ? (lf + 1) : end;
+		}
+		lines->chunks[lines->nb_chunks++] = (_yjson_lines_chunk_t){
+			.start = pt,
+			.end = chunk_end,
+		};
+		pt = chunk_end;
+	}
+	// first pass: count the lines of each chunk
+	lines->counting = true;
+	ystatus_t st = _yjson_lines_run(lines, nb_threads);
+	if (st != YENOERR)
+		goto end;
+	*count = 0;
+	for (size_t i = 0; i < lines->nb_chunks; ++i) {
+		size_t nb_lines = lines->chunks[i].first_line;
+		lines->chunks[i].first_line = *count;
+		*count += nb_lines;
+	}
+	if (!lines->func && *count &&
+	    !(lines->results = calloc0(*count, sizeof(yres_var_t)))) {
+		st = YENOMEM;
+		goto end;
+	}
+	// second pass: parse the lines
+	lines->counting = false;
+	atomic_store(&lines->next_chunk, 0);
+	st = _yjson_lines_run(lines, nb_threads);
+end:
+	free0(lines->chunks);
+	return (st);
+}
+/*
+ * Process all the chunks, using worker threads.
+ * @param	lines		Pointer to the processing state.
+ * @param	nb_threads	Number of threads.
+ * @return	YENOERR if OK.
+ */
+static ystatus_t _yjson_lines_run(_yjson_lines_t *lines, uint32_t nb_threads) {
+	atomic_store(&lines->status, YENOERR);
+	nb_threads = MIN(nb_threads, lines->nb_chunks);
+	// no need to create threads
+	if (nb_threads <= 1) {
+		_yjson_lines_worker(lines);
+		return (atomic_load(&lines->status));
+	}
+	pthread_t *threads = malloc0(nb_threads * sizeof(pthread_t));
+	if (!threads)
+		return (YENOMEM);
+	uint32_t nb_created = 0;
+	for (; nb_created < nb_threads; ++nb_created) {
+		if (pthread_create(&threads[nb_created], NULL, _yjson_lines_worker, lines))
+			break;
+	}
+	// the current thread works too if some threads couldn't be created
+	if (!nb_created)
+		_yjson_lines_worker(lines);
+	for (uint32_t i = 0; i < nb_created; ++i)
+		pthread_join(threads[i], NULL);
+	free0(threads);
+	return (atomic_load(&lines->status));
+}
+/*
+ * Main function of worker threads: process chunks until there is no more to process.
+ * @param	param	Pointer to the processing state.
+ * @return	NULL.
+ */
+static void *_yjson_lines_worker(void *param) {
+	_yjson_lines_t *lines = param;
+	size_t i;
+
+	while (atomic_load(&lines->status) == YENOERR &&
+	       (i = atomic_fetch_add(&lines->next_chunk, 1)) < lines->nb_chunks) {
+		if (lines->counting)
+			_yjson_lines_count(&lines->chunks[i]);
+		else
+			_yjson_lines_parse(lines, &lines->chunks[i]);
+	}
+	return (NULL);
+}
+/*
+ * Count the lines of a chunk. The result is stored in its first_line field.
+ * @param	chunk	Pointer to the chunk.
+ */
+static void _yjson_lines_count(_yjson_lines_chunk_t *chunk) {
+	size_t nb_lines = 0;
+	for (char *pt = chunk->start; pt < chunk->end; ++nb_lines) {
+		char *lf = memchr(pt, LF, chunk->end - pt);
+		pt = lf ? (lf + 1) : chunk->end;
+	}
+	chunk->first_line = nb_lines;
+}
+/*
+ * Parse the lines of a chunk.
+ * @param	lines	Pointer to the processing state.
+ * @param	chunk	Pointer to the chunk.
+ */
+static void _yjson_lines_parse(_yjson_lines_t *lines, _yjson_lines_chunk_t *chunk) {
+	yjson_parser_t json;
+	size_t line = chunk->first_line;
+
+	for (char *pt = chunk->start; pt < chunk->end; ++line) {
+		char *lf = memchr(pt, LF, chunk->end - pt);
+		char *copy = NULL;
+		yres_var_t res;
+		if (lf) {
+			// the parser reads nothing after the NUL character, so the next lines
+			// (maybe modified by other threads) are not read
+			*lf = '\0';
+			res = yjson_parse_fast(&json, pt);
+		} else if ((copy = malloc0(chunk->end - pt + 1))) {
+			// last line, without ending newline: the input may not be NUL-terminated
+			memcpy(copy, pt, chunk->end - pt);
+			res = yjson_parse_fast(&json, copy);
+		} else
+			res = YRESULT_ERR(yres_var_t, YENOMEM);
+		pt = lf ? (lf + 1) : chunk->end;
+		if (!lines->func) {
+			lines->results[line] = res;
+		} else {
+			ystatus_t st = lines->func(line, &res, lines->user_data);
+			if (st != YENOERR) {
+				int expected = YENOERR;
+				atomic_compare_exchange_strong(&lines->status, &expected, st);
+			}
+		}
+		free0(copy);
+		if (atomic_load(&lines->status) != YENOERR)
+			return;
+	}
+}
@@ -27,4 +27,11 @@ void *calloc0(size_t nmemb, size_t size) {
 	}
 	return (p);
 }
-
+/* Reallocate memory. */
+void *realloc0(void *ptr, size_t size) {
+#ifdef USE_BOEHM_GC
+	return (GC_REALLOC(ptr, size));
+#else
+	return (realloc(ptr, size));
+#endif
+}
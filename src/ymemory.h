@@ -36,6 +36,16 @@ void *malloc0(size_t size);
  * @throws	YEXCEPT_NOMEM if the allocation failed.
  */
 void *calloc0(size_t nmemb, size_t size);
+/**
+ * @function	realloc0
+ *		Memory reallocation. Unlike malloc0() and calloc0(), the added
+ *		memory is not zeroed.
+ * @param	ptr	Pointer to the memory area to resize. Could be NULL.
+ * @param	size	New number of bytes.
+ * @return	A pointer to the reallocated data, or NULL if the reallocation
+ *		failed (the original memory area is left untouched).
+ */
+void *realloc0(void *ptr, size_t size);
 
 #if defined(__cplusplus) || defined(c_plusplus)
 }
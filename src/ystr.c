@@ -8,6 +8,13 @@
 #define YSTR_MINIMAL_SIZE	8
 /** @define _YARRAY_HEAD Get a pointer to a yarray's header. */
 #define _YSTR_HEAD(p)  ((ystr_head_t*)((void*)(p) - sizeof(ystr_head_t)))
+/** @define YSTR_GROWTH_FACTOR Multiplier applied to the allocated size of a ystring when it must grow. */
+#define YSTR_GROWTH_FACTOR	2
+
+/* Private functions. */
+static size_t _ys_grow_size(size_t total, size_t needed);
+static ystatus_t _ys_realloc(ystr_t *s, size_t totalsz);
+static ystatus_t _ys_grow(ystr_t *s, size_t n);
 
 /* Create a new ystring.  */
 ystr_t ys_new(const char *s) {
@@ -53,6 +60,20 @@ ystr_t ys_copy(const char *s) {
 		memcpy(res, s, strsz + 1);
 	return ((ystr_t)res);
 }
+/* Create a minimal ystring allocated from an arena. */
+ystr_t ys_arena_ncopy(yarena_t *arena, const char *s, size_t n) {
+	char *res = yarena_alloc(arena, sizeof(ystr_head_t) + n + 1);
+	if (!res)
+		return (NULL);
+	ystr_head_t *y = (ystr_head_t*)res;
+	res += sizeof(ystr_head_t);
+	y->total = n + 1;
+	y->used = n;
+	if (n)
+		memcpy(res, s, n);
+	res[n] = '\0';
+	return ((ystr_t)res);
+}
 /* Delete an existing ystring. */
 void ys_delete(ystr_t *s) {
 	ystr_head_t *y;
@@ -84,27 +105,38 @@ void ys_trunc(ystr_t s) {
 }
 /* Set the minimum size of a ystring. */
 ystatus_t ys_resize(ystr_t *s, size_t sz) {
-	ystr_head_t *y, *ny;
-	size_t totalsz;
-	char *ns;
+	ystr_head_t *y;
 
 	if (!s || !*s)
 		return (YENOERR);
 	y = _YSTR_HEAD(*s);
 	if (sz <= y->total)
 		return (YENOERR);
-	totalsz = (((sz / YSTR_MINIMAL_SIZE) + 1) * YSTR_MINIMAL_SIZE) + 1;
-	ns = (char*)malloc0(totalsz + sizeof(ystr_head_t));
-	if (!ns)
+	return (_ys_realloc(s, _ys_grow_size(y->total, sz)));
+}
+/* Make sure a ystring could receive a given number of bytes without reallocation. */
+ystatus_t ys_reserve(ystr_t *s, size_t n) {
+	ystr_head_t *y;
+
+	if (!s)
+		return (YEINVAL);
+	if (!*s && !(*s = ys_new("")))
 		return (YENOMEM);
-	ny = (ystr_head_t*)ns;
-	ns += sizeof(ystr_head_t);
-	ny->total = totalsz;
-	ny->used = y->used;
-	memcpy(ns, s, y->used + 1);
-	free0(y);
-	*s = ns;
-	return (YENOERR);
+	y = _YSTR_HEAD(*s);
+	if ((y->used + 1 + n) <= y->total)
+		return (YENOERR);
+	return (_ys_realloc(s, y->used + 1 + n));
+}
+/* Release the unused memory of a ystring. */
+ystatus_t ys_shrink_to_fit(ystr_t *s) {
+	ystr_head_t *y;
+
+	if (!s || !*s)
+		return (YENOERR);
+	y = _YSTR_HEAD(*s);
+	if (y->total == (y->used + 1))
+		return (YENOERR);
+	return (_ys_realloc(s, y->used + 1));
 }
 /* Return true if a ystring is empty or NULL. */
 bool ys_empty(const ystr_t s) {
@@ -124,165 +156,48 @@ size_t ys_bytesize(const ystr_t s) {
 }
 /* Concatenate a character string at the end of an ystring. */
 ystatus_t ys_append(ystr_t *dest, const char *src) {
-	size_t srcsz, strsz, totalsz;
-	ystr_head_t *y, *ny;
-	char *ns;
-
-	if (!src || !(srcsz = strlen(src)))
-		return (YENOERR);
-	if (!dest)
-		return (YEINVAL);
-	if (!*dest) {
-		if (!(*dest = ys_new(src)))
-			return (YENOMEM);
-		return (YENOERR);
-	}
-	y = _YSTR_HEAD(*dest);
-	if ((y->used + 1 + srcsz) <= y->total) {
-		memcpy(*dest + y->used, src, srcsz + 1);
-		y->used += srcsz;
+	if (!src || !*src)
 		return (YENOERR);
-	}
-	strsz = y->used + srcsz;
-	totalsz = (y->total > YSTR_MINIMAL_SIZE) ? y->total : YSTR_MINIMAL_SIZE;
-	while (totalsz < (strsz + 1))
-		totalsz *= 2;
-	ns = (char*)malloc0(totalsz + sizeof(ystr_head_t));
-	if (!ns)
-		return (YENOMEM);
-	ny = (ystr_head_t*)ns;
-	ns += sizeof(ystr_head_t);
-	ny->total = totalsz;
-	ny->used = strsz;
-	memcpy(ns, *dest, y->used);
-	memcpy(ns + y->used, src, srcsz + 1);
-	free0(y);
-	*dest = ns;
-	return (YENOERR);
+	return (ys_nappend(dest, src, strlen(src)));
 }
 /* Concatenate a character string at the begining of an ystring. */
 ystatus_t ys_prepend(ystr_t *dest, const char *src) {
-	size_t srcsz, strsz, totalsz;
-	ystr_head_t *y, *ny;
-	char *ns;
-
-	if (!src || !(srcsz = strlen(src)))
-		return (YENOERR);
-	if (!dest)
-		return (YEINVAL);
-	if (!*dest) {
-		if (!(*dest = ys_new(src)))
-			return (YENOMEM);
-		return (YENOERR);
-	}
-	y = _YSTR_HEAD(*dest);
-	if ((y->used + 1 + srcsz) <= y->total) {
-		char *pt1, *pt2;
-		for (pt1 = *dest + y->used, pt2 = pt1 + srcsz;
-		     pt1 >= *dest; --pt1, --pt2)
-			*pt2 = *pt1;
-		memcpy(*dest, src, srcsz);
-		y->used += srcsz;
+	if (!src || !*src)
 		return (YENOERR);
-	}
-	strsz = y->used + srcsz;
-	totalsz = (y->total > YSTR_MINIMAL_SIZE) ? y->total : YSTR_MINIMAL_SIZE;
-	while (totalsz < (strsz + 1))
-		totalsz *= 2;
-	ns = (char*)malloc0(totalsz + sizeof(ystr_head_t));
-	if (!ns)
-		return (YENOMEM);
-	ny = (ystr_head_t*)ns;
-	ns += sizeof(ystr_head_t);
-	ny->total = totalsz;
-	ny->used = strsz;
-	memcpy(ns, src, srcsz);
-	memcpy(ns + srcsz, *dest, y->used + 1);
-	free0(y);
-	*dest = ns;
-	return (YENOERR);
+	return (ys_nprepend(dest, src, strlen(src)));
 }
 /* See strncat(). */
 ystatus_t ys_nappend(ystr_t *dest, const char *src, size_t n) {
-	size_t strsz, totalsz;
-	ystr_head_t *y, *ny;
-	char *ns;
+	ystr_head_t *y;
 
-	if (!src || !n)
+	if (!src || !n || !(n = strnlen(src, n)))
 		return (YENOERR);
 	if (!dest)
 		return (YEINVAL);
-	if (!*dest) {
-		if (!(*dest = ys_new(src)))
-			return (YENOMEM);
-		return (YENOERR);
-	}
-	y = _YSTR_HEAD(*dest);
-	if ((y->used + 1 + n) <= y->total) {
-		strncpy(*dest + y->used, src, n);
-		y->used += n;
-		(*dest)[y->used] = '\0';
-		return (YENOERR);
-	}
-	strsz = y->used + n;
-	totalsz = (y->total > YSTR_MINIMAL_SIZE) ? y->total : YSTR_MINIMAL_SIZE;
-	while (totalsz < (strsz + 1))
-		totalsz *= 2;
-	ns = (char*)malloc0(totalsz + sizeof(ystr_head_t));
-	if (!ns)
+	if (!*dest && !(*dest = ys_new("")))
 		return (YENOMEM);
-	ny = (ystr_head_t*)ns;
-	ns += sizeof(ystr_head_t);
-	ny->total = totalsz;
-	ny->used = strsz;
-	strcpy(ns, *dest);
-	strncpy(ns + y->used, src, n);
-	ns[ny->used] = '\0';
-	free0(y);
-	*dest = ns;
+	RETURN_IF_ERR(_ys_grow(dest, n));
+	y = _YSTR_HEAD(*dest);
+	memcpy(*dest + y->used, src, n);
+	y->used += n;
+	(*dest)[y->used] = '\0';
 	return (YENOERR);
 }
 /* Same as ystr_prepend() but at the begining of a ystring. */
 ystatus_t ys_nprepend(ystr_t *dest, const char *src, size_t n) {
-	size_t strsz, totalsz;
-	ystr_head_t *y, *ny;
-	char *ns;
+	ystr_head_t *y;
 
-	if (!src || !*src || !n)
+	if (!src || !n || !(n = strnlen(src, n)))
 		return (YENOERR);
 	if (!dest)
 		return (YEINVAL);
-	if (!*dest) {
-		if (!(*dest = ys_new(src)))
-			return (YENOMEM);
-		return (YENOERR);
-	}
-	n = (strlen(src) < n) ? strlen(src) : n;
-	y = _YSTR_HEAD(*dest);
-	if ((y->used + 1 + n) <= y->total) {
-		char *pt1, *pt2;
-		for (pt1 = *dest + y->used, pt2 = pt1 + n;
-		     pt1 >= *dest; --pt1, --pt2)
-			*pt2 = *pt1;
-		memcpy(*dest, src, n);
-		y->used += n;
-		return (YENOERR);
-	}
-	strsz = y->used + n;
-	totalsz = (y->total > YSTR_MINIMAL_SIZE) ? y->total : YSTR_MINIMAL_SIZE;
-	while (totalsz < (strsz + 1))
-		totalsz *= 2;
-	ns = (char*)malloc0(totalsz + sizeof(ystr_head_t));
-	if (!ns)
+	if (!*dest && !(*dest = ys_new("")))
 		return (YENOMEM);
-	ny = (ystr_head_t*)ns;
-	ns += sizeof(ystr_head_t);
-	ny->total = totalsz;
-	ny->used = strsz;
-	memcpy(ns, src, n);
-	memcpy(ns + n, *dest, y->used + 1);
-	free0(y);
-	*dest = ns;
+	RETURN_IF_ERR(_ys_grow(dest, n));
+	y = _YSTR_HEAD(*dest);
+	memmove(*dest + n, *dest, y->used + 1);
+	memcpy(*dest, src, n);
+	y->used += n;
 	return (YENOERR);
 }
 /* Duplicate an ystring. */
@@ -402,43 +317,17 @@ char ys_rshift(ystr_t s) {
 }
 /* Add a character at the beginning of a ystring. */
 void ys_putc(ystr_t *s, char c) {
-	ystr_head_t *y, *ny;
-	char *pt1, *pt2, *ns;
-	size_t totalsz;
+	char tc[2] = {'\0', '\0'};
 
-	if (c == '\0')
-		return;
-	if (!*s) {
-		char tc[2] = {'\0', '\0'};
-		tc[0] = c;
-		*s = ys_new(tc);
-		return;
-	}
-	y = (ystr_head_t*)(*s - sizeof(ystr_head_t));
-	if (y->total >= (y->used + 2)) {
-		for (pt1 = *s + y->used, pt2 = pt1 + 1; pt1 >= *s; --pt1, --pt2)
-			*pt2 = *pt1;
-		**s = c;
-		y->used++;
-		return;
-	}
-	totalsz = (y->used * 2) + 1;
-	ns = (char*)malloc0(totalsz + sizeof(ystr_head_t));
-	ny = (ystr_head_t*)ns;
-	ns += sizeof(ystr_head_t);
-	ny->total = totalsz;
-	ny->used = y->used + 1;
-	*ns = c;
-	memcpy(ns + 1, *s, y->used + 1);
-	free0(y);
-	*s = ns;
+	tc[0] = c;
+	ys_nprepend(s, tc, 1);
 }
-/* Add a character at the end of a ystring. */
-void ys_addc(ystr_t *s, char c) {
+/* Add a character at the end of a ystring, when the fast path of ys_addc() can't be used. */
+void ys_addc_grow(ystr_t *s, char c) {
 	char tc[2] = {'\0', '\0'};
 
 	tc[0] = c;
-	ys_append(s, tc);
+	ys_nappend(s, tc, 1);
 }
 /* Convert all characters of a character string to upper case. */
 void ys_upcase(char *s) {
@@ -701,3 +590,47 @@ int strncmp0(const char *s1, const char *s2, size_t n) {
 	return (strncmp(s1, s2, n));
 }
 
+/* ********** PRIVATE FUNCTIONS ********** */
+/*
+ * Compute the new allocated size of a ystring. The size grows geometrically,
+ * so appending N bytes one by one costs O(N) copies instead of O(N^2).
+ * @param	total	Current allocated size.
+ * @param	needed	Minimal size needed.
+ * @return	The new size.
+ */
+static size_t _ys_grow_size(size_t total, size_t needed) {
+	size_t totalsz = (total > YSTR_MINIMAL_SIZE) ? total : YSTR_MINIMAL_SIZE;
+
+	while (totalsz < needed)
+		totalsz *= YSTR_GROWTH_FACTOR;
+	return (totalsz);
+}
+/*
+ * Change the allocated size of a ystring. The content is preserved.
+ * @param	s	A pointer to the ystring.
+ * @param	totalsz	New allocated size (must be greater than the used size).
+ * @return	YENOERR if OK, YENOMEM if the reallocation failed.
+ */
+static ystatus_t _ys_realloc(ystr_t *s, size_t totalsz) {
+	ystr_head_t *y;
+
+	y = (ystr_head_t*)realloc0(_YSTR_HEAD(*s), totalsz + sizeof(ystr_head_t));
+	if (!y)
+		return (YENOMEM);
+	y->total = totalsz;
+	*s = (ystr_t)((void*)y + sizeof(ystr_head_t));
+	return (YENOERR);
+}
+/*
+ * Make sure a ystring has room for some more bytes, growing it geometrically if needed.
+ * @param	s	A pointer to the ystring.
+ * @param	n	Number of bytes that will be added.
+ * @return	YENOERR if OK, YENOMEM if the reallocation failed.
+ */
+static ystatus_t _ys_grow(ystr_t *s, size_t n) {
+	ystr_head_t *y = _YSTR_HEAD(*s);
+
+	if ((y->used + 1 + n) <= y->total)
+		return (YENOERR);
+	return (_ys_realloc(s, _ys_grow_size(y->total, y->used + 1 + n)));
+}
@@ -26,6 +26,7 @@ extern "C" {
 #include <stdio.h>
 #include <stdbool.h>
 #include "ystatus.h"
+#include "yarena.h"
 
 /**
  * @typedef	ystr_head_s
@@ -59,6 +60,17 @@ ystr_t ys_new(const char *s);
  * @return	A pointer to the created ystring.
  */
 ystr_t ys_copy(const char *s);
+/**
+ * @function	ys_arena_ncopy
+ *		Create a minimal ystring, allocated from an arena, that contains a copy of
+ *		the given data. The ystring must not be freed nor extended; its memory is
+ *		released with the arena.
+ * @param	arena	Pointer to the arena.
+ * @param	s	Pointer to the data that will be copied in the ystring.
+ * @param	n	Size of the data.
+ * @return	A pointer to the created ystring.
+ */
+ystr_t ys_arena_ncopy(yarena_t *arena, const char *s, size_t n);
 /**
  * @function	ys_delete
  *		Delete an existing ystring.
@@ -80,12 +92,31 @@ void ys_free(ystr_t s);
 void ys_trunc(ystr_t s);
 /**
  * @function	ys_resize
- *		Set the minimum size of a ystring.
+ *		Set the minimum size of a ystring. The allocated size grows
+ *		geometrically, so it could be greater than the requested size.
  * @param	s	A pointer to the ystring.
  * @param	sz	The minimum size for this ystring.
  * @return	YENOERR if OK.
  */
 ystatus_t ys_resize(ystr_t *s, size_t sz);
+/**
+ * @function	ys_reserve
+ *		Make sure a ystring could receive a given number of additional
+ *		bytes without any reallocation. Unlike ys_resize(), the exact
+ *		needed size is allocated.
+ * @param	s	A pointer to the ystring. If it points to NULL, a new
+ *			ystring is created.
+ * @param	n	Number of bytes that will be added to the ystring.
+ * @return	YENOERR if OK.
+ */
+ystatus_t ys_reserve(ystr_t *s, size_t n);
+/**
+ * @function	ys_shrink_to_fit
+ *		Release the unused memory of a ystring.
+ * @param	s	A pointer to the ystring.
+ * @return	YENOERR if OK.
+ */
+ystatus_t ys_shrink_to_fit(ystr_t *s);
 /**
  * @function	ys_empty
  *		Return true if a ystring is empty or NULL.
@@ -198,13 +229,34 @@ char ys_rshift(ystr_t s);
  * @param	c	The character to add.
  */
 void ys_putc(ystr_t *s, char c);
+/**
+ * @function	ys_addc_grow
+ *		Add a character at the end of a ystring, reallocating it if
+ *		needed. Use ys_addc() instead.
+ * @param	s	A pointer to the ystring.
+ * @param	c	The character to add.
+ */
+void ys_addc_grow(ystr_t *s, char c);
 /**
  * @function	ys_addc
- *		Add a character at the end of a ystring.
+ *		Add a character at the end of a ystring. The character is
+ *		written in place when there is enough free space.
  * @param	s	A pointer to the ystring.
  * @param	c	The character to add.
  */
-void ys_addc(ystr_t *s, char c);
+static inline void ys_addc(ystr_t *s, char c) {
+	ystr_head_t *y;
+
+	if (s && *s && c != '\0') {
+		y = (ystr_head_t*)(*s - sizeof(ystr_head_t));
+		if ((y->used + 2) <= y->total) {
+			(*s)[y->used++] = c;
+			(*s)[y->used] = '\0';
+			return;
+		}
+	}
+	ys_addc_grow(s, c);
+}
 /**
  * @function	ys_upcase
  *		Convert all characters of a character string to upper
@@ -1,3 +1,7 @@
+#if defined(__SSE2__)
+# include <emmintrin.h>
+#endif /* __SSE2__ */
+#include <stdatomic.h>
 #include "ytable.h"
 #include "y.h"
 
@@ -6,52 +10,88 @@
 #define _YTABLE_DEFAULT_SIZE		8
 /** @define _YTABLE_SIZE Compute the size of a new yarray's buffer. */
 #define _YARRAY_SIZE(s)			COMPUTE_SIZE((s), _YTABLE_DEFAULT_SIZE)
-/** @define _YTABLE_MAX_LOAD_FACTOR Maximum load factor of a hash table before increasing it. */
-#define _YTABLE_MAX_LOAD_FACTOR		0.7
-/** @define _YTABLE_MIN_LOAD_FACTOR Minimum load factor of a hash table before reducing it. */
-#define _YTABLE_MIN_LOAD_FACTOR		0.25
-/** @define _YTABLE_DEFAULT_BUCKET_SIZE Default size for buckets. */
-#define _YTABLE_DEFAULT_BUCKET_SIZE	4
-/** @define _YTABLE_HAS_NUMERIC_KEY	Returns 1 if an element has a numeric key. */
-#define _YTABLE_HAS_NUMERIC_KEY(h)	((h) & ((uint64_t)1 << 63)) // 0b10...00 (64 bits)
-/** @define _YTABLE_HAS_STRING_KEY	Returns 1 if an element has a string key. */
-#define _YTABLE_HAS_STRING_KEY(h)	((h) & ((uint64_t)1 << 62)) // 0b01...00 (64 bits)
-/** @define _YTABLE_HAS_NO_KEY		Returns 1 if an element has no defined key. */
-#define _YTABLE_HAS_NO_KEY(h)		(!((h) & ((uint64_t)3 << 62))) // 0b11...00 (64 bits)
-/** @define _YTABLE_HASH_VALUE		Extract the real hash value from a hash field. */
-#define _YTABLE_HASH_VALUE(h)		((h) & 0x3FFFFFFFFFFFFFFF) // 0b0011...11 (64 bits)
-/** @define _YTABLE_SET_NUMERIC_KEY	Set the numeric key bit to a hash value. */
-#define _YTABLE_SET_NUMERIC_KEY(h)	(_YTABLE_HASH_VALUE(h) | ((uint64_t)1 << 63)) // 0b10..00
-/** @define _YTABLE_SET_STRING_KEY	Set the string key bit to a hash value. */
-#define _YTABLE_SET_STRING_KEY(h)	(_YTABLE_HASH_VALUE(h) | ((uint64_t)1 << 62)) // 0b01..00
-/** @define _YTABLE_SET_NO_KEY		Set no key bit to a hash value. */
-#define _YTABLE_SET_NO_KEY		(_YTABLE_HASH_VALUE(h))
+/** @define _YTABLE_LINEAR_MAX_LENGTH Maximum length of a table whose keyed elements are searched without hash index. */
+#define _YTABLE_LINEAR_MAX_LENGTH	8
+/** @define _YTABLE_GROUP_SIZE Number of slots of the hash index probed at once. */
+#define _YTABLE_GROUP_SIZE		16
+/** @define _YTABLE_INDEX_MIN_SIZE Minimal number of slots of the hash index. */
+#define _YTABLE_INDEX_MIN_SIZE		16
+/** @define _YTABLE_INDEX_CAPACITY Maximum number of used slots of a hash index (7/8 of its size). */
+#define _YTABLE_INDEX_CAPACITY(s)	((s) - ((s) / 8))
+/** @define _YTABLE_CTRL_EMPTY Control byte of an empty slot. */
+#define _YTABLE_CTRL_EMPTY		0x80
+/** @define _YTABLE_CTRL_DELETED Control byte of a slot whose element was removed. */
+#define _YTABLE_CTRL_DELETED		0xFE
+/** @define _YTABLE_INDEX_MIN_LENGTH Minimum number of elements of a hash index (1/4 of its capacity). */
+#define _YTABLE_INDEX_MIN_LENGTH(s)	(_YTABLE_INDEX_CAPACITY(s) / 4)
+/** @define _YTABLE_REHASH_GROUPS Number of groups of slots moved at each modification during a resize. */
+#define _YTABLE_REHASH_GROUPS		8
+/** @define _YTABLE_BATCH_SIZE Number of lookups whose memory accesses are overlapped by the batch functions. */
+#define _YTABLE_BATCH_SIZE		16
+/** @define _YTABLE_NOT_FOUND Value returned when an element is not in the hash index. */
+#define _YTABLE_NOT_FOUND		UINT32_MAX
+/** @define _YTABLE_FREE	Free some memory of a ytable (nothing is freed for arena-backed tables). */
+#define _YTABLE_FREE(t, p)		((t)->arena ? ((p) = NULL) : free0(p))
+/** @define _YTABLE_COUNT Update a statistics counter of a ytable (even a constant one). */
+#define _YTABLE_COUNT(t, field, n)	YHASH_COUNT(((ytable_t*)(t))->stats, field, n)
 
 /* ************ PRIVATE STRUCTURES AND TYPES ************** */
 /**
- * @typedef	_ytable_element_t
- *		Storage structure of an element.
- * @field	data		Pointer to the stored data.
- * @field	key		String key.
- * @field	hash_value	- 64th bit: 1 if numeric key (0 if keyless array-like)
- *				- 63rd bit: 1 if string key (0 if keyless array-like)
- *				- 62 bits: numéric key or computed hash from the string key
+ * @typedef	_ytable_share_t
+ *		Reference counter of the array and hash indexes shared by cloned ytables.
+ * @field	refcount	Number of tables using them.
  */
-typedef struct _ytable_element_s {
-	void *data;
-	const char *key;
-	uint64_t hash_value;
-} _ytable_element_t;
+typedef struct _ytable_share_s {
+	atomic_uint refcount;
+} _ytable_share_t;
 
 /* ********** DECLARATION OF PRIVATE FUNCTIONS ********** */
+static inline uint32_t _ytable_offset(const ytable_t *t, uint32_t position);
+static inline uint32_t _ytable_position(const ytable_t *t, uint32_t element_offset);
 static ystatus_t _ytable_free_element_data(ytable_t *t, uint32_t element_offset);
+static _ytable_share_t *_ytable_share(ytable_t *t);
+static bool _ytable_unshare(ytable_t *t);
+static ystatus_t _ytable_copy_storage(ytable_t *t, const ytable_t *src);
+static ystatus_t _ytable_copy_elements(ytable_t *t);
+static void *_ytable_calloc(ytable_t *t, size_t nmemb, size_t size);
 static ystatus_t _ytable_instanciate(ytable_t *t);
 static ystatus_t _ytable_instanciate_hashmap(ytable_t *t);
-static ystatus_t _ytable_expand(ytable_t *t, uint16_t size, bool array_only);
+static void _ytable_check_linear_mode(ytable_t *t);
+static uint32_t _ytable_linear_find(const ytable_t *t, uint64_t hash_value, const char *key);
+static ystatus_t _ytable_expand(ytable_t *t, uint32_t size);
+static void _ytable_remove_position(ytable_t *t, uint32_t position);
+static void _ytable_check_numeric_keys(ytable_t *t, uint32_t position);
 static ystatus_t _ytable_add_element_to_hashmap(ytable_t *t, _ytable_element_t *element,
                                                 uint32_t element_offset);
 static yres_int_t _ytable_extract_element_from_hashmap(ytable_t *t, _ytable_element_t *element,
                                                        const char *key, uint64_t index);
+static inline uint32_t _ytable_index_match(const uint8_t *group, uint8_t ctrl);
+static inline uint32_t _ytable_index_match_free(const uint8_t *group);
+static uint32_t _ytable_index_probe(const ytable_t *t, const uint8_t *index_ctrl,
+                                    const uint32_t *index_slots, uint32_t index_size,
+                                    uint64_t hash_value, const char *key);
+static uint32_t _ytable_index_find(const ytable_t *t, uint64_t hash_value, const char *key);
+static void _ytable_index_find_batch(const ytable_t *t, uint32_t count,
+                                     const uint64_t *hash_values, const char **keys,
+                                     uint32_t *offsets);
+static void _ytable_index_put(ytable_t *t, uint64_t hash_value, uint32_t element_offset);
+static void _ytable_index_remove(ytable_t *t, uint32_t slot);
+static uint32_t _ytable_index_probe_offset(const uint8_t *index_ctrl, const uint32_t *index_slots,
+                                           uint32_t index_size, uint64_t hash_value,
+                                           uint32_t element_offset);
+static void _ytable_index_relocate(ytable_t *t, uint32_t old_offset, uint32_t new_offset);
+static uint32_t _ytable_index_compute_size(uint32_t length);
+static ystatus_t _ytable_index_resize(ytable_t *t, uint32_t size);
+static void _ytable_index_migrate(ytable_t *t, uint32_t nb_groups);
+static void _ytable_index_free_rehash(ytable_t *t);
+static void _ytable_index_move_offsets(uint8_t *index_ctrl, uint32_t *index_slots,
+                                       uint32_t index_size, uint32_t end, uint32_t delta);
+static ystatus_t _ytable_index_rebuild(ytable_t *t, uint32_t size);
+#ifdef USE_HASH_STATS
+static void _ytable_index_histogram(const ytable_t *t, const uint8_t *index_ctrl,
+                                    const uint32_t *index_slots, uint32_t index_size,
+                                    size_t *histogram);
+#endif /* USE_HASH_STATS */
 
 /* ************ CREATION/DELETION FUNCTIONS ************* */
 /* Create a new simple ytable. */
@@ -74,6 +114,19 @@ ytable_t *ytable_create(size_t size, ytable_function_t delete_function, void *de
 	};
 	return (t);
 }
+/* Create a new ytable allocated from an arena. */
+ytable_t *ytable_create_arena(size_t size, yarena_t *arena) {
+	if (!arena)
+		return (NULL);
+	ytable_t *t = yarena_alloc(arena, sizeof(ytable_t));
+	if (!t)
+		return (NULL);
+	*t = (ytable_t){
+		.array_size = COMPUTE_SIZE(size, _YTABLE_DEFAULT_SIZE),
+		.arena = arena,
+	};
+	return (t);
+}
 /* Initialize a ytable. */
 ytable_t *ytable_init(ytable_t *table, ytable_function_t delete_function, void *delete_data) {
 	if (!table)
@@ -94,23 +147,57 @@ ytable_t *ytable_set_delete_function(ytable_t *table, ytable_function_t delete_f
 	table->delete_data = delete_data;
 	return (table);
 }
+/* Define the copy function. */
+ytable_t *ytable_set_copy_function(ytable_t *table, ytable_copy_function_t copy_function,
+                                   void *copy_data) {
+	if (!table)
+		return (NULL);
+	table->copy_function = copy_function;
+	table->copy_data = copy_data;
+	return (table);
+}
+/* Define the hash function. */
+ystatus_t ytable_set_hash_function(ytable_t *table, yhash_function_t hash_function, uint64_t seed) {
+	if (!table)
+		return (YEINVAL);
+	RETURN_IF_ERR(ytable_detach(table));
+	table->hash_function = hash_function;
+	table->hash_seed = seed;
+	if (!table->index_length)
+		return (YENOERR);
+	// rehash the string keys
+	for (uint32_t position = 0; position < table->length; ++position) {
+		_ytable_element_t *elem = &table->elements[_ytable_offset(table, position)];
+		if (_YTABLE_HAS_STRING_KEY(elem->hash_value))
+			elem->hash_value = _YTABLE_SET_STRING_KEY(ytable_hash_key(table, elem->key));
+	}
+	if (!table->index_ctrl)
+		return (YENOERR);
+	return (_ytable_index_rebuild(table, table->index_size));
+}
 /* Destroy a ytable. */
 void ytable_free(ytable_t *table) {
 	if (!table)
 		return;
-	if (table->buckets) {
-		for (uint32_t offset = 0; offset < table->array_size; ++offset) {
-			free0(table->buckets[offset]);
-		}
-		free0(table->buckets);
+	// the elements are still used by some clones
+	if (table->share && !_ytable_unshare(table)) {
+		free0(table);
+		return;
 	}
 	if (table->elements && table->delete_function) {
-		for (size_t offset = 0; offset < table->length; ++offset) {
-			_ytable_element_t *e = &table->elements[offset];
+		for (uint32_t position = 0; position < table->length; ++position) {
+			_ytable_element_t *e = &table->elements[_ytable_offset(table, position)];
 			table->delete_function(e->hash_value, (char*)e->key, e->data,
 			                       table->delete_data);
 		}
 	}
+	// memory of arena-backed tables is released with the arena
+	if (table->arena)
+		return;
+	free0(table->index_ctrl);
+	free0(table->index_slots);
+	free0(table->rehash_ctrl);
+	free0(table->rehash_slots);
 	free0(table->elements);
 	free0(table);
 }
@@ -118,69 +205,89 @@ void ytable_free(ytable_t *table) {
 ytable_t *ytable_clone(ytable_t *table) {
 	if (!table)
 		return (NULL);
-	// create new table
 	ytable_t *t = malloc0(sizeof(ytable_t));
 	if (!t)
 		return (NULL);
-	*t = (ytable_t){
-		.length = table->length,
-		.array_size = table->array_size,
-		.next_index = table->next_index,
-		.delete_function = table->delete_function,
-		.delete_data = table->delete_data,
-	};
-	if (!table->elements)
+#ifdef USE_HASH_STATS
+	// the counters, updated by the readers of a yctable, are not read (they stay zeroed)
+	memcpy(t, table, offsetof(ytable_t, stats));
+#else
+	*t = *table;
+#endif /* USE_HASH_STATS */
+	t->arena = NULL;
+	// the memory of arena-backed tables is copied at once
+	if (table->arena) {
+		t->share = NULL;
+		if (_ytable_copy_storage(t, table) != YENOERR) {
+			free0(t);
+			return (NULL);
+		}
+		if (_ytable_copy_elements(t) != YENOERR) {
+			free0(t->elements);
+			free0(t->index_ctrl);
+			free0(t->index_slots);
+			free0(t);
+			return (NULL);
+		}
 		return (t);
-	// create array
-	t->elements = calloc0(t->array_size, sizeof(_ytable_element_t));
-	if (!t->elements) {
-		free0(t);
-		return (NULL);
 	}
-	// copy the array
-	memcpy(t->elements, table->elements, (table->length * sizeof(_ytable_element_t)));
-	// create buckets
-	if (!table->buckets)
-		return (t);
-	t->buckets = calloc0(t->array_size, sizeof(uint32_t*));
-	if (!t->buckets) {
-		free0(t->elements);
+	// the array and the hash indexes are shared
+	if (!(t->share = _ytable_share(table))) {
 		free0(t);
 		return (NULL);
 	}
-	// copy buckets
-	for (uint32_t offset = 0; offset < t->array_size; ++offset) {
-		uint32_t *bucket = table->buckets[offset];
-		if (!bucket)
-			continue;
-		uint32_t bucket_size = bucket[0];
-		uint32_t bucket_length = bucket[1];
-		uint32_t *new_bucket = calloc0(bucket_size + 2, sizeof(uint32_t));
-		if (!new_bucket)
-			return (t);
-		memcpy(new_bucket, bucket, ((bucket_length + 2) * sizeof(uint32_t)));
-		t->buckets[offset] = new_bucket;
-	}
 	return (t);
 }
+/* Give its own array and hash index to a ytable which shares them with its clones. */
+ystatus_t ytable_detach(ytable_t *table) {
+	if (!table)
+		return (YEINVAL);
+	if (!table->share)
+		return (YENOERR);
+	// the other tables were freed
+	if (atomic_load(&table->share->refcount) == 1) {
+		_ytable_unshare(table);
+		return (YENOERR);
+	}
+	ytable_t copy = *table;
+	RETURN_IF_ERR(_ytable_copy_storage(&copy, table));
+	if (_ytable_unshare(table)) {
+		// the other tables were freed in the meantime, the copy is useless
+		free0(copy.elements);
+		free0(copy.index_ctrl);
+		free0(copy.index_slots);
+		return (YENOERR);
+	}
+	copy.share = NULL;
+	*table = copy;
+	return (_ytable_copy_elements(table));
+}
+/* Tell if a ytable shares its elements with some of its clones. */
+bool ytable_is_shared(const ytable_t *table) {
+	if (!table || !table->share || atomic_load(&table->share->refcount) == 1)
+		return (false);
+	return (true);
+}
 
 /* ********** ARRAY-LIKE FUNCTIONS ********** */
 /* Add an element at the end of a ytable (used as an array). */
 ystatus_t ytable_add(ytable_t *table, void *data) {
 	if (!table)
 		return (YEINVAL);
+	RETURN_IF_ERR(ytable_detach(table));
 	// instanciate the array if needed
 	RETURN_IF_ERR(_ytable_instanciate(table));
 	// expand the array if needed
-	RETURN_IF_ERR(_ytable_expand(table, 1, false));
+	RETURN_IF_ERR(_ytable_expand(table, 1));
 	// add the element at the end of the array
-	_ytable_element_t *element = &table->elements[table->length];
+	_ytable_element_t *element = &table->elements[_ytable_offset(table, table->length)];
 	*element = (_ytable_element_t){
 		.data = data,
 	};
 	// increment counters
 	++table->length;
 	++table->next_index;
+	_ytable_check_linear_mode(table);
 	return (YENOERR);
 }
 /* Add multiple elements at the end of a ytable (used as an array). */
@@ -189,147 +296,105 @@ ystatus_t ytable_madd(ytable_t *table, uint32_t count, ...) {
 		return (YEINVAL);
 	if (!count)
 		return (YENOERR);
+	RETURN_IF_ERR(ytable_detach(table));
 	// instanciate the array if needed
 	RETURN_IF_ERR(_ytable_instanciate(table));
 	// expand the array if needed
-	RETURN_IF_ERR(_ytable_expand(table, count, false));
+	RETURN_IF_ERR(_ytable_expand(table, count));
 	// loop on the elements to add
 	va_list p_list;
 	va_start(p_list, count);
 	for (uint32_t n = 0; n < count; ++n) {
 		// add the element at the end of the array
 		void *data = va_arg(p_list, void*);
-		table->elements[table->length] = (_ytable_element_t){
+		table->elements[_ytable_offset(table, table->length)] = (_ytable_element_t){
 			.data = data,
 		};
 		// increment length counter
 		++table->length;
 	}
+	va_end(p_list);
 	// increment next index
 	table->next_index += count;
+	_ytable_check_linear_mode(table);
 	return (YENOERR);
 }
 /* Add an element at the beginning of a ytable (used as an array). */
 ystatus_t ytable_push(ytable_t *table, void *data) {
 	if (!table)
 		return (YEINVAL);
-	_ytable_element_t *element;
+	RETURN_IF_ERR(ytable_detach(table));
 	// instanciate and expand the array if needed
 	RETURN_IF_ERR(_ytable_instanciate(table));
-	RETURN_IF_ERR(_ytable_expand(table, 1, false));
-	// check if existing elements must be moved in the array
-	if (!table->length)
-		goto empty_array;
-	// loop on array elements to move them, starting by the last one
-	for (uint32_t new_offset = table->length; new_offset; --new_offset) {
-		uint32_t old_offset = new_offset - 1;
-		// move the element in the array
-		table->elements[new_offset] = table->elements[old_offset];
-		// if the element has a numeric key and this key is equal to the element's
-		// new offset, remove it from the hashmap part of the table (the element
-		// becomes like it has a numeric key from the beginning)
-		_ytable_element_t *element = &table->elements[new_offset];
-		if (_YTABLE_HAS_NUMERIC_KEY(element->hash_value) &&
-		    _YTABLE_HASH_VALUE(element->hash_value) == new_offset) {
-			// remove the element from the hashmap
-			_ytable_extract_element_from_hashmap(table, element, NULL, 0);
-			// change the type of key => no type (not numeric, not a string)
-			element->hash_value = 0;
-		}
-	}
-empty_array:
-	// add the new element
-	element = &table->elements[0];
-	*element = (_ytable_element_t){
+	RETURN_IF_ERR(_ytable_expand(table, 1));
+	// add the new element before the first one; the other elements don't move, so the
+	// hash index stays valid
+	table->head = _ytable_offset(table, table->array_size - 1);
+	table->elements[table->head] = (_ytable_element_t){
 		.data = data,
 	};
 	++table->length;
 	++table->next_index;
+	_ytable_check_numeric_keys(table, 1);
+	_ytable_check_linear_mode(table);
 	return (YENOERR);
 }
 /* Add multiple elements at the beginning of a ytable (used as an array). */
 ystatus_t ytable_mpush(ytable_t *table, uint32_t count, ...) {
 	if (!table)
 		return (YEINVAL);
+	if (!count)
+		return (YENOERR);
+	RETURN_IF_ERR(ytable_detach(table));
 	// instanciate and expand the array if needed
 	RETURN_IF_ERR(_ytable_instanciate(table));
-	RETURN_IF_ERR(_ytable_expand(table, count, false));
-	// check if existing elements must be moved in the array
-	if (!table->length)
-		goto empty_array;
-	// loop on array elements to move them, starting by the last one
-	for (int64_t old_offset = (table->length - 1); old_offset >= 0; --old_offset) {
-		uint32_t new_offset = old_offset + count;
-		// move the element in the array
-		table->elements[new_offset] = table->elements[old_offset];
-		// if the element has a numeric key and this key is equal to the element's
-		// new offset, remove it from the hashmap part of the table (the element
-		// becomes like it has a numeric key from the beginning)
-		_ytable_element_t *elem = &table->elements[new_offset];
-		if (_YTABLE_HAS_NUMERIC_KEY(elem->hash_value) &&
-		    _YTABLE_HASH_VALUE(elem->hash_value) == new_offset) {
-			// remove the element from the hashmap
-			_ytable_extract_element_from_hashmap(table, elem, NULL, 0);
-			// change the type of key => no type (not numeric, not a string)
-			elem->hash_value = 0;
-		}
-	}
-empty_array: ;
-	// add the new elements
+	RETURN_IF_ERR(_ytable_expand(table, count));
+	// add the new elements before the first one
+	table->head = _ytable_offset(table, table->array_size - count);
 	va_list p_list;
 	va_start(p_list, count);
 	for (uint32_t n = 0; n < count; ++n) {
-		// add the element at the beginning of the array
 		void *data = va_arg(p_list, void*);
-		table->elements[n] = (_ytable_element_t){
+		table->elements[_ytable_offset(table, n)] = (_ytable_element_t){
 			.data = data,
 		};
 	}
+	va_end(p_list);
 	table->length += count;
 	table->next_index += count;
+	_ytable_check_numeric_keys(table, count);
+	_ytable_check_linear_mode(table);
 	return (YENOERR);
 }
 /* Remove the last element of a ytable and return it. */
 void *ytable_pop(ytable_t *table) {
-	if (!table || !table->length)
+	if (!table || !table->length || ytable_detach(table) != YENOERR)
 		return (NULL);
 	--table->length;
-	_ytable_element_t *element = &table->elements[table->length];
+	_ytable_element_t *element = &table->elements[_ytable_offset(table, table->length)];
 	// if the element is in the hashmap, remove it
 	if (element->hash_value) {
 		_ytable_extract_element_from_hashmap(table, element, NULL, 0);
 	}
+	if (!table->length)
+		table->head = 0;
 	return (element->data);
 }
 /* Remove the first element of a ytable and return it. */
 void *ytable_shift(ytable_t *table) {
-	if (!table || !table->length)
+	if (!table || !table->length || ytable_detach(table) != YENOERR)
 		return (NULL);
-	_ytable_element_t *element = &table->elements[0];
+	_ytable_element_t *element = &table->elements[table->head];
 	// if the element is in the hashmap, remove it
 	if (element->hash_value) {
 		_ytable_extract_element_from_hashmap(table, element, NULL, 0);
 	}
-	// loop on array elements to move them, starting by the second one
-	void *data = element->data;
-	for (uint32_t old_offset = 1; old_offset < table->length; ++old_offset) {
-		uint32_t new_offset = old_offset - 1;
-		// move the element in the array
-		table->elements[new_offset] = table->elements[old_offset];
-		element = &table->elements[new_offset];
-		// if the element has a numeric key and this key is equal to the element's
-		// new offset, remove it from the hashmap part of the table (the element
-		// becomes likes it has a numeric key from the beginning)
-		if (_YTABLE_HAS_NUMERIC_KEY(element->hash_value) &&
-		    _YTABLE_HASH_VALUE(element->hash_value) == new_offset) {
-			// remove the element from the hashmap
-			_ytable_extract_element_from_hashmap(table, element, NULL, 0);
-			// change the type of key => no type (not numeric, not a string)
-			element->hash_value = 0;
-		}
-	}
+	// the next element becomes the first one; the other elements don't move, so the
+	// hash index stays valid
 	--table->length;
-	return (data);
+	table->head = table->length ? _ytable_offset(table, 1) : 0;
+	_ytable_check_numeric_keys(table, 0);
+	return (element->data);
 }
 
 /* ********** INDEXED FUNCTIONS ********** */
@@ -356,29 +421,16 @@ yres_pointer_t ytable_get_index(ytable_t *table, uint64_t index) {
 	// search for a direct index
 	_ytable_element_t *elem;
 	if (index < table->length) {
-		elem = &table->elements[index];
+		elem = &table->elements[_ytable_offset(table, index)];
 		if (_YTABLE_HAS_NO_KEY(elem->hash_value))
 			return (YRESULT_VAL(yres_pointer_t, elem->data));
 	}
 	// search for an hashed index
-	if (!table->buckets)
-		return (YRESULT_ERR(yres_pointer_t, YEUNDEF));
-	uint32_t modulo_value = MODULO_POW2(index, table->array_size);
-	uint32_t *bucket = table->buckets[modulo_value];
-	if (!bucket)
+	uint32_t offset = _ytable_index_find(table, _YTABLE_SET_NUMERIC_KEY(index), NULL);
+	if (offset == _YTABLE_NOT_FOUND)
 		return (YRESULT_ERR(yres_pointer_t, YEUNDEF));
-	// loop on bucket elements
-	uint32_t bucket_length = bucket[1];
-	for (uint32_t bucket_offset = 0; bucket_offset < bucket_length; ++bucket_offset) {
-		uint32_t elem_offset = bucket[bucket_offset + 2];
-		elem = &table->elements[elem_offset];
-		// check if hash values are equal
-		if (_YTABLE_HAS_NUMERIC_KEY(elem->hash_value) &&
-		    _YTABLE_HASH_VALUE(elem->hash_value) == index)
-			return (YRESULT_VAL(yres_pointer_t, elem->data));
-	}
-	// not found
-	return (YRESULT_ERR(yres_pointer_t, YEUNDEF));
+	elem = &table->elements[offset];
+	return (YRESULT_VAL(yres_pointer_t, elem->data));
 }
 /* Return the data value associated to the given index. */
 void *ytable_get_index_data(ytable_t *table, uint64_t index) {
@@ -386,10 +438,62 @@ void *ytable_get_index_data(ytable_t *table, uint64_t index) {
 	RETURN_NULL_IF_ERR(YRES_STATUS(res));
 	return (YRES_VAL(res));
 }
+/* Return the data values associated to a list of indexes. */
+uint32_t ytable_get_indexes_batch(ytable_t *table, uint32_t count, const uint64_t *indexes,
+                                  void **results) {
+	if (!table || !indexes || !results)
+		return (0);
+	// short tables: no memory access to overlap
+	if (!table->index_ctrl) {
+		uint32_t found = 0;
+		for (uint32_t i = 0; i < count; ++i) {
+			yres_pointer_t res = ytable_get_index(table, indexes[i]);
+			results[i] = (YRES_STATUS(res) == YENOERR) ? YRES_VAL(res) : NULL;
+			found += (YRES_STATUS(res) == YENOERR);
+		}
+		return (found);
+	}
+	uint32_t found = 0;
+	for (uint32_t start = 0; start < count; start += _YTABLE_BATCH_SIZE) {
+		uint32_t n = MIN(count - start, _YTABLE_BATCH_SIZE);
+		uint64_t hash_values[_YTABLE_BATCH_SIZE];
+		uint32_t offsets[_YTABLE_BATCH_SIZE];
+		uint32_t batch[_YTABLE_BATCH_SIZE];
+		uint32_t nb_hashed = 0;
+		// fetch the elements which could be stored at the position of their index
+		for (uint32_t i = 0; i < n; ++i)
+			if (indexes[start + i] < table->length)
+				__builtin_prefetch(&table->elements[_ytable_offset(table,
+				                                                   indexes[start + i])]);
+		for (uint32_t i = 0; i < n; ++i) {
+			uint64_t index = indexes[start + i];
+			if (index < table->length) {
+				_ytable_element_t *elem = &table->elements[_ytable_offset(table, index)];
+				if (_YTABLE_HAS_NO_KEY(elem->hash_value)) {
+					results[start + i] = elem->data;
+					++found;
+					continue;
+				}
+			}
+			// the other ones are searched in the hash index
+			hash_values[nb_hashed] = _YTABLE_SET_NUMERIC_KEY(index);
+			batch[nb_hashed++] = start + i;
+		}
+		const char *keys[_YTABLE_BATCH_SIZE] = {NULL};
+		_ytable_index_find_batch(table, nb_hashed, hash_values, keys, offsets);
+		for (uint32_t i = 0; i < nb_hashed; ++i) {
+			bool exists = (offsets[i] != _YTABLE_NOT_FOUND);
+			results[batch[i]] = exists ? table->elements[offsets[i]].data : NULL;
+			found += exists;
+		}
+	}
+	return (found);
+}
 /* Add an element in a ytable using an index. */
 ystatus_t ytable_set_index(ytable_t *table, uint64_t index, void *data) {
 	if (!table)
 		return (YEINVAL);
+	RETURN_IF_ERR(ytable_detach(table));
 	// if the given index is the next in numeric order, manage the table as an array
 	if (index == table->next_index && index == table->length)
 		return (ytable_add(table, data));
@@ -401,50 +505,37 @@ ystatus_t ytable_set_index(ytable_t *table, uint64_t index, void *data) {
 	// check if the given index is corresponding to an array-like indexed element
 	if (index >= table->length)
 		goto not_array_element;
-	_ytable_element_t *element = &table->elements[index];
+	uint32_t offset = _ytable_offset(table, index);
+	_ytable_element_t *element = &table->elements[offset];
 	if (_YTABLE_HAS_NO_KEY(element->hash_value) ||
 	    (_YTABLE_HAS_NUMERIC_KEY(element->hash_value) &&
 	     _YTABLE_HASH_VALUE(element->hash_value) == index)) {
 		// a previous element was found => overwrite
 		// starts by removing the ancient element's data
-		RETURN_IF_ERR(_ytable_free_element_data(table, index));
+		RETURN_IF_ERR(_ytable_free_element_data(table, offset));
 		// then overwrite it
 		element->data = data;
 		return (YENOERR);
 	}
-not_array_element:
-	// search if an element already exists in the hashmap with the same hash value
-	if (!table->length || !table->buckets)
-		goto nobucket;
-	uint64_t hash_value = index;
-	uint32_t modulo_value = MODULO_POW2(hash_value, table->array_size);
-	uint32_t *bucket = table->buckets[modulo_value];
-	if (!bucket)
-		goto nobucket;
-	// loop on bucket elements
-	uint32_t bucket_length = bucket[1];
-	for (uint32_t bucket_offset = 0; bucket_offset < bucket_length; ++bucket_offset) {
-		uint32_t elem_offset = bucket[bucket_offset + 2];
-		element = &table->elements[elem_offset];
-		// check if hash values are equal
-		if (!_YTABLE_HAS_NUMERIC_KEY(element->hash_value) ||
-		    _YTABLE_HASH_VALUE(element->hash_value) != hash_value)
-			continue;
-		// same hash value => overwrite
+not_array_element: ;
+	// search if an element already exists in the hashmap with the same index
+	uint32_t elem_offset = _ytable_index_find(table, _YTABLE_SET_NUMERIC_KEY(index), NULL);
+	if (elem_offset != _YTABLE_NOT_FOUND) {
+		// same index => overwrite
 		// starts by removing the ancient element's data
 		RETURN_IF_ERR(_ytable_free_element_data(table, elem_offset));
 		// then overwrite it
-		element->data = data;
+		table->elements[elem_offset].data = data;
 		return (YENOERR);
 	}
-empty_array:
-nobucket: ;
+empty_array: ;
 	bool hashed_element = (index != table->next_index || index != table->length) ?
 	                      true : false;
 	// expand the array if needed
-	RETURN_IF_ERR(_ytable_expand(table, 1, hashed_element));
+	RETURN_IF_ERR(_ytable_expand(table, 1));
 	// add the element at the end of the array
-	element = &table->elements[table->length];
+	offset = _ytable_offset(table, table->length);
+	element = &table->elements[offset];
 	*element = (_ytable_element_t){
 		.data = data,
 	};
@@ -452,8 +543,8 @@ nobucket: ;
 	// add it to the hashmap part of the table
 	if (hashed_element) {
 		element->hash_value = _YTABLE_SET_NUMERIC_KEY(index);
-		RETURN_IF_ERR(_ytable_instanciate_hashmap(table));
-		RETURN_IF_ERR(_ytable_add_element_to_hashmap(table, element, table->length));
+		RETURN_IF_ERR(_ytable_add_element_to_hashmap(table, element, offset));
+		++table->numeric_length;
 	}
 	// increment counters
 	++table->length;
@@ -465,55 +556,26 @@ nobucket: ;
 yres_pointer_t ytable_extract_index(ytable_t *table, uint64_t index) {
 	if (!table)
 		return (YRESULT_ERR(yres_pointer_t, YEINVAL));
-	void *result_data;
 	if (!table->length)
 		return (YRESULT_ERR(yres_pointer_t, YEUNDEF));
+	ystatus_t st = ytable_detach(table);
+	if (st != YENOERR)
+		return (YRESULT_ERR(yres_pointer_t, st));
 	// search for a direct index
-	if (index >= table->length)
-		goto not_array;
-	_ytable_element_t *elem = &table->elements[index];
-	if (_YTABLE_HAS_NO_KEY(elem->hash_value)) {
-		// decrement array size
-		--table->length;
-		// check if it's the last element of the array
-		if (index == table->length)
-			return (YRESULT_VAL(yres_pointer_t, elem->data));
-		// not the last element, shift all other elements
-		result_data = elem->data;
-		goto shift_elements;
+	if (index < table->length) {
+		_ytable_element_t *elem = &table->elements[_ytable_offset(table, index)];
+		if (_YTABLE_HAS_NO_KEY(elem->hash_value)) {
+			void *result_data = elem->data;
+			_ytable_remove_position(table, index);
+			return (YRESULT_VAL(yres_pointer_t, result_data));
+		}
 	}
-not_array: ;
 	// extract the element from the hashmap
 	yres_int_t res = _ytable_extract_element_from_hashmap(table, NULL, NULL, index);
 	if (YRES_STATUS(res) != YENOERR)
 		return (YRESULT_ERR(yres_pointer_t, YRES_STATUS(res)));
-	index = YRES_VAL(res);
-	elem = &table->elements[index];
-	// decrement array size
-	--table->length;
-	// check if it's the last element of the array
-	if (index == table->length)
-		return (YRESULT_VAL(yres_pointer_t, elem->data));
-	// not the last element, shift all other elements
-	result_data = elem->data;
-shift_elements:
-	// shift elements in the array
-	for (uint32_t new_offset = index; new_offset < table->length; ++new_offset) {
-		uint32_t old_offset = new_offset + 1;
-		elem = &table->elements[old_offset];
-		// if the element has a numeric key and this key is equal to the element"s
-		// new offset, remove it from the hashmap part of the table (the element
-		// becomes likes it has a numeric key from the beginning)
-		if (_YTABLE_HAS_NUMERIC_KEY(elem->hash_value) &&
-		    _YTABLE_HASH_VALUE(elem->hash_value) == new_offset) {
-			// remove the element from the hashmap
-			_ytable_extract_element_from_hashmap(table, elem, NULL, 0);
-			// change the type of key => no type (not numeric, not a string)
-			elem->hash_value = 0;
-		}
-		// move the element in the array
-		table->elements[new_offset] = table->elements[old_offset];
-	}
+	void *result_data = table->elements[YRES_VAL(res)].data;
+	_ytable_remove_position(table, _ytable_position(table, YRES_VAL(res)));
 	return (YRESULT_VAL(yres_pointer_t, result_data));
 }
 /* Extract an element from its index and return its data. */
@@ -528,52 +590,24 @@ ystatus_t ytable_remove_index(ytable_t *table, uint64_t index) {
 		return (YEINVAL);
 	if (!table->length)
 		return (YEUNDEF);
+	RETURN_IF_ERR(ytable_detach(table));
 	// check if the given index is corresponding to an array-like indexed element
-	if (index >= table->length)
-		goto not_array;
-	_ytable_element_t *elem = &table->elements[index];
-	if (_YTABLE_HAS_NO_KEY(elem->hash_value)) {
-		// free the element's data
-		RETURN_IF_ERR(_ytable_free_element_data(table, index));
-		// decrement array size
-		--table->length;
-		// check if it's the last element of the array
-		if (index == table->length)
+	if (index < table->length) {
+		uint32_t offset = _ytable_offset(table, index);
+		if (_YTABLE_HAS_NO_KEY(table->elements[offset].hash_value)) {
+			// free the element's data
+			RETURN_IF_ERR(_ytable_free_element_data(table, offset));
+			_ytable_remove_position(table, index);
 			return (YENOERR);
-		// not the last element, shift all other elements
-		goto shift_elements;
+		}
 	}
-not_array: ;
 	// remove the element from the hashmap
 	yres_int_t res = _ytable_extract_element_from_hashmap(table, NULL, NULL, index);
 	if (YRES_STATUS(res) != YENOERR)
 		return (YRES_STATUS(res));
-	index = YRES_VAL(res);
 	// free the element's data
-	RETURN_IF_ERR(_ytable_free_element_data(table, index));
-	// decrement array size
-	--table->length;
-	// check if it's the last element of the array
-	if (index == table->length)
-		return (YENOERR);
-shift_elements:
-	// loop on the array
-	for (uint32_t new_offset = index; new_offset < table->length; ++new_offset) {
-		uint32_t old_offset = new_offset + 1;
-		elem = &table->elements[old_offset];
-		// if the element has a numeric key and this key is equal to the element"s
-		// new offset, remove it from the hashmap part of the table (the element
-		// becomes likes it has a numeric key from the beginning)
-		if (_YTABLE_HAS_NUMERIC_KEY(elem->hash_value) &&
-		    _YTABLE_HASH_VALUE(elem->hash_value) == new_offset) {
-			// remove the element from the hashmap
-			_ytable_extract_element_from_hashmap(table, elem, NULL, 0);
-			// change the type of key => no type (not numeric, not a string)
-			elem->hash_value = 0;
-		}
-		// move the element in the array
-		table->elements[new_offset] = table->elements[old_offset];
-	}
+	RETURN_IF_ERR(_ytable_free_element_data(table, YRES_VAL(res)));
+	_ytable_remove_position(table, _ytable_position(table, YRES_VAL(res)));
 	return (YENOERR);
 }
 
@@ -596,32 +630,40 @@ bool ytable_key_isset(ytable_t *table, const char *key) {
 yres_pointer_t ytable_get_key(ytable_t *table, const char *key) {
 	if (!table)
 		return (YRESULT_ERR(yres_pointer_t, YEINVAL));
-	if (!table->length || !table->buckets)
+	if (!table->length)
 		return (YRESULT_ERR(yres_pointer_t, YEUNDEF));
 	// if the key is a numeric string, manage it as a numeric insert
 	if (ys_is_numeric(key)) {
 		uint64_t index = (uint64_t)atol(key);
 		return (ytable_get_index(table, index));
 	}
-	// search for bucket
-	uint64_t hash_value = yhash_compute(key);
-	uint32_t modulo_value = MODULO_POW2(hash_value, table->array_size);
-	uint32_t *bucket = table->buckets[modulo_value];
-	if (!bucket)
+	// short tables: compare the keys without computing the hash value
+	if (!table->index_ctrl && key) {
+		for (uint32_t position = 0; position < table->length; ++position) {
+			_ytable_element_t *elem = &table->elements[_ytable_offset(table, position)];
+			if (_YTABLE_HAS_STRING_KEY(elem->hash_value) && !strcmp(elem->key, key))
+				return (YRESULT_VAL(yres_pointer_t, elem->data));
+		}
 		return (YRESULT_ERR(yres_pointer_t, YEUNDEF));
-	// loop on bucket elements
-	uint32_t bucket_length = bucket[1];
-	for (uint32_t bucket_offset = 0; bucket_offset < bucket_length; ++bucket_offset) {
-		uint32_t elem_offset = bucket[bucket_offset + 2];
-		_ytable_element_t *elem = &table->elements[elem_offset];
-		// check if hash values are equal
-		if (_YTABLE_HAS_STRING_KEY(elem->hash_value) &&
-		    _YTABLE_HASH_VALUE(elem->hash_value) == hash_value &&
-		    !strcmp0(elem->key, key))
-			return (YRESULT_VAL(yres_pointer_t, elem->data));
 	}
-	// not found
-	return (YRESULT_ERR(yres_pointer_t, YEUNDEF));
+	return (ytable_get_key_hashed(table, key, ytable_hash_key(table, key)));
+}
+/* Return the value associated to the given non-numeric string key and its hash value. */
+yres_pointer_t ytable_get_key_hashed(ytable_t *table, const char *key, uint64_t hash_value) {
+	if (!table)
+		return (YRESULT_ERR(yres_pointer_t, YEINVAL));
+	if (!key)
+		return (YRESULT_ERR(yres_pointer_t, YEINVAL));
+	uint32_t offset = _ytable_index_find(table, _YTABLE_SET_STRING_KEY(hash_value), key);
+	if (offset == _YTABLE_NOT_FOUND)
+		return (YRESULT_ERR(yres_pointer_t, YEUNDEF));
+	return (YRESULT_VAL(yres_pointer_t, table->elements[offset].data));
+}
+/* Compute the hash value of a string key. */
+uint64_t ytable_hash_key(const ytable_t *table, const char *key) {
+	if (table && table->hash_function)
+		return (table->hash_function(key, strlen(key), table->hash_seed));
+	return (yhash_string(key));
 }
 /* Return the data value associated to the given string key. */
 void *ytable_get_key_data(ytable_t *table, const char *key) {
@@ -629,10 +671,50 @@ void *ytable_get_key_data(ytable_t *table, const char *key) {
 	RETURN_NULL_IF_ERR(YRES_STATUS(res));
 	return (YRES_VAL(res));
 }
+/* Return the data values associated to a list of string keys. */
+uint32_t ytable_get_keys_batch(ytable_t *table, uint32_t count, const char **keys,
+                               void **results) {
+	if (!table || !keys || !results)
+		return (0);
+	uint32_t found = 0;
+	for (uint32_t start = 0; start < count; start += _YTABLE_BATCH_SIZE) {
+		uint32_t n = MIN(count - start, _YTABLE_BATCH_SIZE);
+		uint64_t hash_values[_YTABLE_BATCH_SIZE];
+		const char *batch_keys[_YTABLE_BATCH_SIZE];
+		uint32_t offsets[_YTABLE_BATCH_SIZE];
+		uint32_t batch[_YTABLE_BATCH_SIZE];
+		uint32_t nb_hashed = 0;
+		for (uint32_t i = 0; i < n; ++i) {
+			const char *key = keys[start + i];
+			if (!key) {
+				results[start + i] = NULL;
+				continue;
+			}
+			// numeric keys and short tables: no memory access to overlap
+			if (!table->index_ctrl || ys_is_numeric(key)) {
+				yres_pointer_t res = ytable_get_key(table, key);
+				results[start + i] = (YRES_STATUS(res) == YENOERR) ? YRES_VAL(res) : NULL;
+				found += (YRES_STATUS(res) == YENOERR);
+				continue;
+			}
+			hash_values[nb_hashed] = _YTABLE_SET_STRING_KEY(ytable_hash_key(table, key));
+			batch_keys[nb_hashed] = key;
+			batch[nb_hashed++] = start + i;
+		}
+		_ytable_index_find_batch(table, nb_hashed, hash_values, batch_keys, offsets);
+		for (uint32_t i = 0; i < nb_hashed; ++i) {
+			bool exists = (offsets[i] != _YTABLE_NOT_FOUND);
+			results[batch[i]] = exists ? table->elements[offsets[i]].data : NULL;
+			found += exists;
+		}
+	}
+	return (found);
+}
 /* Add an element in a ytable using a string key. */
 ystatus_t ytable_set_key(ytable_t *table, const char *key, void *data) {
 	if (!table || !key)
 		return (YEINVAL);
+	RETURN_IF_ERR(ytable_detach(table));
 	// if the key is a numeric string, manage it as a numeric insert
 	if (ys_is_numeric(key)) {
 		uint64_t index = (uint64_t)atol(key);
@@ -641,47 +723,29 @@ ystatus_t ytable_set_key(ytable_t *table, const char *key, void *data) {
 	// instanciate the array if needed
 	RETURN_IF_ERR(_ytable_instanciate(table));
 	// compute the hash value
-	uint64_t hash_value = yhash_compute(key);
-	// if the array is empty, no need to check if an element must be overwritten
-	if (!table->length || !table->buckets)
-		goto nobucket;
-	// search for bucket
-	uint32_t modulo_value = MODULO_POW2(hash_value, table->array_size);
-	uint32_t *bucket = table->buckets[modulo_value];
-	if (!bucket)
-		goto nobucket;
-	// loop on bucket elements
-	uint32_t bucket_length = bucket[1];
-	for (uint32_t bucket_offset = 0; bucket_offset < bucket_length; ++bucket_offset) {
-		uint32_t elem_offset = bucket[bucket_offset + 2];
-		_ytable_element_t *elem = &table->elements[elem_offset];
-		// check if keys are equal
-		if (!_YTABLE_HAS_STRING_KEY(elem->hash_value) ||
-		    _YTABLE_HASH_VALUE(elem->hash_value) != hash_value ||
-		    strcmp0(elem->key, key)) {
-			// keys are different
-			continue;
-		}
+	uint64_t hash_value = ytable_hash_key(table, key);
+	// search if an element already exists with the same key
+	uint32_t elem_offset = _ytable_index_find(table, _YTABLE_SET_STRING_KEY(hash_value), key);
+	if (elem_offset != _YTABLE_NOT_FOUND) {
 		// same keys => overwrite
 		// starts by removing the ancient element's data
 		RETURN_IF_ERR(_ytable_free_element_data(table, elem_offset));
 		// then overwrite it
-		elem->data = data;
+		table->elements[elem_offset].data = data;
 		return (YENOERR);
 	}
-nobucket:
 	// expand the array if needed
-	RETURN_IF_ERR(_ytable_expand(table, 1, true));
+	RETURN_IF_ERR(_ytable_expand(table, 1));
 	// add the element at the end of the array
-	_ytable_element_t *element = &table->elements[table->length];
+	uint32_t offset = _ytable_offset(table, table->length);
+	_ytable_element_t *element = &table->elements[offset];
 	*element = (_ytable_element_t){
 		.data = data,
 		.key = key,
 		.hash_value = _YTABLE_SET_STRING_KEY(hash_value)
 	};
 	// add the element in the hashmap part of the table
-	RETURN_IF_ERR(_ytable_instanciate_hashmap(table));
-	RETURN_IF_ERR(_ytable_add_element_to_hashmap(table, element, table->length));
+	RETURN_IF_ERR(_ytable_add_element_to_hashmap(table, element, offset));
 	// increment counter
 	++table->length;
 	return (YENOERR);
@@ -696,7 +760,7 @@ uint32_t ytable_length(ytable_t *table) {
 }
 /* Tell if a ytable is used as an array (continuous list of elememnts). */
 bool ytable_is_array(ytable_t *table) {
-	if (!table || !table->buckets)
+	if (!table || (!table->index_ctrl && !table->index_length))
 		return (true);
 	return (false);
 }
@@ -707,23 +771,194 @@ ystatus_t ytable_foreach(ytable_t *table, ytable_function_t func, void *user_dat
 	if (!table->length || !func)
 		return (YENOERR); 
 	// loop on all elements
-	for (uint32_t offset = 0; offset < table->length; ++offset) {
-		_ytable_element_t *elem = &table->elements[offset];
+	for (uint32_t position = 0; position < table->length; ++position) {
+		_ytable_element_t *elem = &table->elements[_ytable_offset(table, position)];
 		uint64_t hash = _YTABLE_HAS_NUMERIC_KEY(elem->hash_value) ?
-		                _YTABLE_HASH_VALUE(elem->hash_value) : offset;
+		                _YTABLE_HASH_VALUE(elem->hash_value) : position;
 
 		RETURN_IF_ERR(func(hash, (char*)elem->key, elem->data, user_data));
 	}
 	return (YENOERR);
 }
+#ifdef USE_HASH_STATS
+/* Compute the statistics of a ytable. */
+ystatus_t ytable_stats(const ytable_t *table, yhash_stats_t *stats) {
+	if (!table || !stats)
+		return (YEINVAL);
+	size_t size = table->index_ctrl ? (table->index_size + table->rehash_size) : 0;
+	*stats = (yhash_stats_t){
+		.length = table->length,
+		.size = size,
+		.load_factor = size ? ((double)table->index_length / size) : 0.0,
+		.bytes = sizeof(ytable_t) + (table->array_size * sizeof(_ytable_element_t)) +
+		         (size * (sizeof(uint8_t) + sizeof(uint32_t))),
+	};
+	yhash_stats_fill(stats, &table->stats);
+	if (!table->elements)
+		return (YENOERR);
+	if (!table->index_ctrl) {
+		// no hash index: the elements are compared until the searched one
+		for (uint32_t position = 0; position < table->length; ++position) {
+			if (table->elements[_ytable_offset(table, position)].hash_value)
+				++stats->histogram[MIN(position + 1, YHASH_STATS_HISTOGRAM_SIZE - 1)];
+		}
+		return (YENOERR);
+	}
+	_ytable_index_histogram(table, table->index_ctrl, table->index_slots, table->index_size,
+	                        stats->histogram);
+	if (table->rehash_ctrl)
+		_ytable_index_histogram(table, table->rehash_ctrl, table->rehash_slots,
+		                        table->rehash_size, stats->histogram);
+	return (YENOERR);
+}
+#endif /* USE_HASH_STATS */
+
+/* ********** ITERATORS ********** */
+/* Remove the current element of an iterator. */
+ystatus_t ytable_iterator_remove(ytable_iterator_t *it) {
+	if (!it || !it->table || !it->position || it->position > it->table->length)
+		return (YEINVAL);
+	ytable_t *table = it->table;
+	RETURN_IF_ERR(ytable_detach(table));
+	uint32_t position = it->position - 1;
+	uint32_t offset = _ytable_offset(table, position);
+	_ytable_element_t *elem = &table->elements[offset];
+	// remove the element from the hashmap
+	if (elem->hash_value) {
+		yres_int_t res = _ytable_extract_element_from_hashmap(table, elem, NULL, 0);
+		if (YRES_STATUS(res) != YENOERR)
+			return (YRES_STATUS(res));
+	}
+	// free the element's data
+	RETURN_IF_ERR(_ytable_free_element_data(table, offset));
+	// the next elements are moved one position backward
+	_ytable_remove_position(table, position);
+	it->position = position;
+	return (YENOERR);
+}
 
 /* ********** PRIVATE FUNCTIONS ********** */
-/* Delete the data pointed by an element. */
+/* Return the offset in the array of the element at the given position. */
+static inline uint32_t _ytable_offset(const ytable_t *t, uint32_t position) {
+	return (MODULO_POW2(t->head + position, t->array_size));
+}
+/* Return the position of the element stored at the given offset of the array. */
+static inline uint32_t _ytable_position(const ytable_t *t, uint32_t element_offset) {
+	return (MODULO_POW2(element_offset - t->head, t->array_size));
+}
+/* Delete the data pointed by an element (given its offset in the array). */
 static ystatus_t _ytable_free_element_data(ytable_t *t, uint32_t element_offset) {
 	if (!t->delete_function)
 		return (YENOERR);
 	_ytable_element_t *e = &t->elements[element_offset];
-	return (t->delete_function(element_offset, (char*)e->key, e->data, t->delete_data));
+	return (t->delete_function(_ytable_position(t, element_offset), (char*)e->key, e->data,
+	                           t->delete_data));
+}
+/*
+ * Share the array and the hash indexes of a ytable with a new clone.
+ * @param	t	Pointer to the table.
+ * @return	A pointer to the reference counter, or NULL if an error occurred.
+ */
+static _ytable_share_t *_ytable_share(ytable_t *t) {
+	_ytable_share_t *share = __atomic_load_n(&t->share, __ATOMIC_ACQUIRE);
+	if (share) {
+		atomic_fetch_add(&share->refcount, 1);
+		return (share);
+	}
+	// first clone: the counter is created (it could be done by several threads at once)
+	if (!(share = malloc0(sizeof(_ytable_share_t))))
+		return (NULL);
+	atomic_init(&share->refcount, 2);
+	_ytable_share_t *current = NULL;
+	if (__atomic_compare_exchange_n(&t->share, &current, share, false, __ATOMIC_ACQ_REL,
+	                                __ATOMIC_ACQUIRE))
+		return (share);
+	free0(share);
+	atomic_fetch_add(&current->refcount, 1);
+	return (current);
+}
+/*
+ * Release the reference of a ytable on its shared array and hash indexes.
+ * @param	t	Pointer to the table.
+ * @return	True if the table was the last one to use them (they are its own now).
+ */
+static bool _ytable_unshare(ytable_t *t) {
+	_ytable_share_t *share = t->share;
+	t->share = NULL;
+	if (atomic_fetch_sub(&share->refcount, 1) > 1)
+		return (false);
+	free0(share);
+	return (true);
+}
+/*
+ * Copy the array and the hash index of a ytable on the heap. The elements are kept at the
+ * same offsets; the hash index is rebuilt if it was being resized.
+ * @param	t	Pointer to the table which receives the copy (its other fields must be
+ *			the same as the copied table's ones, and it must not use an arena).
+ * @param	src	Pointer to the copied table.
+ * @return	YENOERR if OK.
+ */
+static ystatus_t _ytable_copy_storage(ytable_t *t, const ytable_t *src) {
+	t->elements = NULL;
+	t->index_ctrl = t->rehash_ctrl = NULL;
+	t->index_slots = t->rehash_slots = NULL;
+	t->rehash_size = t->rehash_offset = 0;
+	if (!src->elements)
+		return (YENOERR);
+	t->elements = calloc0(src->array_size, sizeof(_ytable_element_t));
+	if (!t->elements)
+		return (YENOMEM);
+	// the second part of the elements is at the beginning of the array if they wrap
+	// around its end
+	uint32_t first_part = MIN(src->length, src->array_size - src->head);
+	memcpy(&t->elements[src->head], &src->elements[src->head],
+	       (first_part * sizeof(_ytable_element_t)));
+	memcpy(t->elements, src->elements,
+	       ((src->length - first_part) * sizeof(_ytable_element_t)));
+	if (!src->index_ctrl)
+		return (YENOERR);
+	if (src->rehash_ctrl) {
+		if (_ytable_index_rebuild(t, src->index_size) != YENOERR) {
+			free0(t->elements);
+			return (YENOMEM);
+		}
+		return (YENOERR);
+	}
+	t->index_ctrl = malloc0(src->index_size);
+	t->index_slots = malloc0(src->index_size * sizeof(uint32_t));
+	if (!t->index_ctrl || !t->index_slots) {
+		free0(t->index_ctrl);
+		free0(t->index_slots);
+		free0(t->elements);
+		return (YENOMEM);
+	}
+	memcpy(t->index_ctrl, src->index_ctrl, src->index_size);
+	memcpy(t->index_slots, src->index_slots, src->index_size * sizeof(uint32_t));
+	return (YENOERR);
+}
+/*
+ * Call the copy function of a ytable on all its elements.
+ * @param	t	Pointer to the table.
+ * @return	YENOERR if OK.
+ */
+static ystatus_t _ytable_copy_elements(ytable_t *t) {
+	if (!t->copy_function)
+		return (YENOERR);
+	for (uint32_t position = 0; position < t->length; ++position) {
+		_ytable_element_t *elem = &t->elements[_ytable_offset(t, position)];
+		uint64_t hash = _YTABLE_HAS_NUMERIC_KEY(elem->hash_value) ?
+		                _YTABLE_HASH_VALUE(elem->hash_value) : position;
+		char *key = (char*)elem->key;
+		RETURN_IF_ERR(t->copy_function(hash, &key, &elem->data, t->copy_data));
+		elem->key = key;
+	}
+	return (YENOERR);
+}
+/* Allocate zeroed memory for a ytable, from its arena or from the heap. */
+static void *_ytable_calloc(ytable_t *t, size_t nmemb, size_t size) {
+	if (t->arena)
+		return (yarena_calloc(t->arena, nmemb, size));
+	return (calloc0(nmemb, size));
 }
 /* Instanciate the buffers of a new empty ytable, if needed. */
 static ystatus_t _ytable_instanciate(ytable_t *t) {
@@ -731,112 +966,152 @@ static ystatus_t _ytable_instanciate(ytable_t *t) {
 		return (YENOERR);
 	if (!t->array_size)
 		return (YEINVAL);
-	t->elements = calloc0(t->array_size, sizeof(_ytable_element_t));
+	t->elements = _ytable_calloc(t, t->array_size, sizeof(_ytable_element_t));
 	if (!t->elements)
 		return (YENOMEM);
 	return (YENOERR);
 }
-/* Instanciate the hashmap of a ytable, if needed. */
+/* Instanciate the hashmap of a ytable, if needed (its keyed elements were searched linearly). */
 static ystatus_t _ytable_instanciate_hashmap(ytable_t *t) {
-	if (t->buckets)
+	if (t->index_ctrl)
 		return (YENOERR);
-	t->buckets = calloc0(t->array_size, sizeof(uint32_t*));
-	if (!t->buckets)
-		return (YENOERR);
-	return (YENOERR);
+	return (_ytable_index_rebuild(t, _ytable_index_compute_size(t->index_length + 1)));
+}
+/*
+ * Instanciate the hashmap of a ytable whose keyed elements are searched linearly, if it
+ * became too long. If the memory can't be allocated, the table stays in linear mode.
+ * @param	t	Pointer to the table.
+ */
+static void _ytable_check_linear_mode(ytable_t *t) {
+	if (t->index_length && !t->index_ctrl && t->length > _YTABLE_LINEAR_MAX_LENGTH)
+		_ytable_instanciate_hashmap(t);
+}
+/*
+ * Search a keyed element by comparing the hash values of all the elements. Used for
+ * short tables, which don't have a hash index.
+ * @param	t		Pointer to the table.
+ * @param	hash_value	Hash value of the element (with its key type bits).
+ * @param	key		String key of the element, or NULL for numeric keys.
+ * @return	The offset of the element in the table's array, or _YTABLE_NOT_FOUND.
+ */
+static uint32_t _ytable_linear_find(const ytable_t *t, uint64_t hash_value, const char *key) {
+	_YTABLE_COUNT(t, lookups, 1);
+	for (uint32_t position = 0; position < t->length; ++position) {
+		_YTABLE_COUNT(t, probes, 1);
+		uint32_t offset = _ytable_offset(t, position);
+		const _ytable_element_t *elem = &t->elements[offset];
+		if (elem->hash_value == hash_value && (elem->key == key || !strcmp0(elem->key, key)))
+			return (offset);
+	}
+	return (_YTABLE_NOT_FOUND);
 }
 /*
  * @function	_ytable_expand
- *		Expand the buffers of a ytable if needed.
+ *		Expand the array of a ytable if needed.
  * @param	t		Pointer to the table.
  * @param	size		Number of elements to add.
- * @param	hash_expansion	True if the expansion is for a hashed element.
  * @return	YENOERR if OK.
  */
-static ystatus_t _ytable_expand(ytable_t *t, uint16_t size, bool hash_expansion) {
+static ystatus_t _ytable_expand(ytable_t *t, uint32_t size) {
 	uint32_t new_length = t->length + size;
-	uint32_t new_array_size;
-	// checkings
-	if (!hash_expansion) {
-		// expansion of the array, not of the hashmap
-		if (new_length <= t->array_size)
-			return (YENOERR);
-		new_array_size = COMPUTE_SIZE(new_length, _YTABLE_DEFAULT_SIZE);
-	} else {
-		// expansion of the hashmap
-		float load_factor = (float)new_length / MAX(t->array_size, _YTABLE_DEFAULT_SIZE);
-		if (load_factor <= _YTABLE_MAX_LOAD_FACTOR)
-			return (YENOERR);
-		// compute the new array_size
-		new_array_size = COMPUTE_SIZE(new_length * 2, _YTABLE_DEFAULT_SIZE);
-	}
-	// create the new list of elements
-	_ytable_element_t *elements = calloc0(new_array_size, sizeof(_ytable_element_t));
+	if (new_length <= t->array_size)
+		return (YENOERR);
+	uint32_t new_array_size = COMPUTE_SIZE(new_length, _YTABLE_DEFAULT_SIZE);
+	// resize the list of elements (big areas are remapped by the system instead of being
+	// copied)
+	_ytable_element_t *elements;
+	if (t->arena)
+		elements = yarena_realloc(t->arena, t->elements,
+		                          t->array_size * sizeof(_ytable_element_t),
+		                          new_array_size * sizeof(_ytable_element_t));
+	else
+		elements = realloc0(t->elements, new_array_size * sizeof(_ytable_element_t));
 	if (!elements)
 		return (YENOMEM);
-	memcpy(elements, t->elements, t->length * sizeof(_ytable_element_t));
-	free0(t->elements);
 	t->elements = elements;
-	// if there was some buckets, they are freed and they recreated
-	if (t->buckets) {
-		// free all buckets
-		for (uint32_t offset = 0; offset < t->array_size; ++offset) {
-			uint32_t *pt = t->buckets[offset];
-			free0(pt);
-		}
-		free0(t->buckets);
-		// create new bucket list
-		t->buckets = (uint32_t**)calloc0(new_array_size, sizeof(uint32_t*));
-		if (!t->buckets)
-			return (YENOMEM);
-		// loop on data to rehash them
-		for (uint32_t offset = 0; offset < t->length; ++offset) {
-			_ytable_element_t *element = &t->elements[offset];
-			if (!element)
-				continue;
-			// find the bucket
-			uint64_t hash_value = _YTABLE_HASH_VALUE(element->hash_value);
-			uint32_t modulo_value = MODULO_POW2(hash_value, new_array_size);
-			uint32_t *bucket = t->buckets[modulo_value];
-			// check if the bucket exists
-			if (!bucket) {
-				// it doesn't exist, create it
-				size_t bucket_size = _YTABLE_DEFAULT_BUCKET_SIZE + 2;
-				uint32_t *new_bucket = calloc0(bucket_size, sizeof(uint32_t));
-				if (!new_bucket)
-					return (YENOMEM);
-				new_bucket[0] = _YTABLE_DEFAULT_BUCKET_SIZE;
-				new_bucket[1] = 1;
-				new_bucket[2] = offset;
-				t->buckets[modulo_value] = new_bucket;
-				continue;
-			}
-			// the bucket exists, try to add the element to it
-			uint32_t bucket_size = bucket[0];
-			uint32_t bucket_length = bucket[1];
-			if (bucket_length < bucket_size) {
-				// there is still some free space in the bucket
-				bucket[bucket_length + 2] = offset;
-				++bucket[1];
-				continue;
-			}
-			// the bucket is full
-			uint32_t new_bucket_size = NEXT_POW2(bucket_size + 1);
-			uint32_t *new_bucket = calloc(new_bucket_size + 2, sizeof(uint32_t));
-			if (!new_bucket)
-				return (YENOMEM);
-			memcpy(new_bucket, bucket, (bucket_length + 2) * sizeof(uint32_t));
-			new_bucket[0] = new_bucket_size;
-			new_bucket[1] = bucket_length + 1;
-			new_bucket[bucket_length + 2] = offset;
-			free0(bucket);
-			t->buckets[modulo_value] = new_bucket;
-		}
+	// if the elements wrapped around the end of the array, the ones stored at its
+	// beginning are moved after the old end (the array is at least doubled, there is
+	// enough room), and their offsets are updated in the hash indexes
+	uint32_t wrapped = (t->head + t->length > t->array_size) ?
+	                   (t->head + t->length - t->array_size) : 0;
+	if (wrapped) {
+		memcpy(&t->elements[t->array_size], t->elements, wrapped * sizeof(_ytable_element_t));
+		if (t->index_ctrl)
+			_ytable_index_move_offsets(t->index_ctrl, t->index_slots, t->index_size,
+			                           wrapped, t->array_size);
+		if (t->rehash_ctrl)
+			_ytable_index_move_offsets(t->rehash_ctrl, t->rehash_slots, t->rehash_size,
+			                           wrapped, t->array_size);
 	}
 	// update array size
 	t->array_size = new_array_size;
 	return (YENOERR);
 }
+/*
+ * Remove an element from the array of a ytable. If it is the first or the last element,
+ * nothing is moved. Otherwise the next elements are moved to fill the gap, and the hash
+ * index entries of the moved keyed elements are updated. The element must have been
+ * removed from the hash index before.
+ * @param	t		Pointer to the table.
+ * @param	position	Position of the element.
+ */
+static void _ytable_remove_position(ytable_t *t, uint32_t position) {
+	--t->length;
+	if (position == t->length) {
+		// last element: nothing to move
+		if (!t->length)
+			t->head = 0;
+		return;
+	}
+	if (!position) {
+		// first element: the next one becomes the first
+		t->head = _ytable_offset(t, 1);
+		_ytable_check_numeric_keys(t, 0);
+		return;
+	}
+	// move the next elements one step backward
+	for (uint32_t pos = position; pos < t->length; ++pos) {
+		uint32_t old_offset = _ytable_offset(t, pos + 1);
+		uint32_t new_offset = _ytable_offset(t, pos);
+		_ytable_element_t *elem = &t->elements[old_offset];
+		if (elem->hash_value) {
+			// if the element has a numeric key and this key is equal to the element's
+			// new position, it is removed from the hashmap part of the table (the
+			// element becomes like it has a numeric key from the beginning)
+			if (_YTABLE_HAS_NUMERIC_KEY(elem->hash_value) &&
+			    _YTABLE_HASH_VALUE(elem->hash_value) == pos) {
+				_ytable_index_relocate(t, old_offset, _YTABLE_NOT_FOUND);
+				// change the type of key => no type (not numeric, not a string)
+				elem->hash_value = 0;
+				--t->index_length;
+				--t->numeric_length;
+			} else
+				_ytable_index_relocate(t, old_offset, new_offset);
+		}
+		t->elements[new_offset] = *elem;
+	}
+}
+/*
+ * Remove the numeric keys which became equal to the positions of their elements, after the
+ * positions changed without moving the elements (the elements become like they have a
+ * numeric key from the beginning). Nothing is done if no element has a numeric key.
+ * @param	t		Pointer to the table.
+ * @param	position	Position of the first element to check.
+ */
+static void _ytable_check_numeric_keys(ytable_t *t, uint32_t position) {
+	for (; t->numeric_length && position < t->length; ++position) {
+		uint32_t offset = _ytable_offset(t, position);
+		_ytable_element_t *elem = &t->elements[offset];
+		if (!_YTABLE_HAS_NUMERIC_KEY(elem->hash_value) ||
+		    _YTABLE_HASH_VALUE(elem->hash_value) != position)
+			continue;
+		_ytable_index_relocate(t, offset, _YTABLE_NOT_FOUND);
+		// change the type of key => no type (not numeric, not a string)
+		elem->hash_value = 0;
+		--t->index_length;
+		--t->numeric_length;
+	}
+}
 /*
  * Add an element to the hashmap part of the ytable.
  * Before calling this function, be sure that no element already exist with the same key.
@@ -847,49 +1122,20 @@ static ystatus_t _ytable_expand(ytable_t *t, uint16_t size, bool hash_expansion)
  */
 static ystatus_t _ytable_add_element_to_hashmap(ytable_t *t, _ytable_element_t *element,
                                                 uint32_t element_offset) {
-	// check if the ytable has a bucket list
-	if (!t->buckets) {
-		// no, create it
-		t->buckets = calloc(t->array_size, sizeof(uint32_t));
-		if (!t->buckets)
-			return (YENOMEM);
-	}
-	// check if the bucket exists
-	uint64_t hash_value = _YTABLE_HASH_VALUE(element->hash_value);
-	uint32_t modulo_value = MODULO_POW2(hash_value, t->array_size);
-	uint32_t *bucket = t->buckets[modulo_value];
-	if (!bucket) {
-		// it doesn't exist, create it
-		size_t bucket_size = _YTABLE_DEFAULT_BUCKET_SIZE + 2;
-		uint32_t *new_bucket = calloc0(bucket_size, sizeof(uint32_t));
-		if (!new_bucket)
-			return (YENOMEM);
-		new_bucket[0] = _YTABLE_DEFAULT_BUCKET_SIZE;
-		new_bucket[1] = 1;
-		new_bucket[2] = element_offset;
-		t->buckets[modulo_value] = new_bucket;
+	// short tables don't need a hash index
+	if (!t->index_ctrl && t->length < _YTABLE_LINEAR_MAX_LENGTH) {
+		++t->index_length;
 		return (YENOERR);
 	}
-	// check the bucket size
-	uint32_t bucket_size = bucket[0];
-	uint32_t bucket_length = bucket[1];
-	if (bucket_length < bucket_size) {
-		// there is still some free space in the bucket
-		bucket[bucket_length + 2] = element_offset;
-		++bucket[1];
-		return (YENOERR);
-	}
-	// the bucket is full
-	uint32_t new_bucket_size = NEXT_POW2(bucket_size + 1);
-	uint32_t *new_bucket = calloc(new_bucket_size + 2, sizeof(uint32_t));
-	if (!new_bucket)
-		return (YENOMEM);
-	memcpy(new_bucket, bucket, (bucket_length + 2) * sizeof(uint32_t));
-	free0(bucket);
-	new_bucket[0] = new_bucket_size;
-	new_bucket[1] = bucket_length + 1;
-	new_bucket[bucket_length + 2] = element_offset;
-	t->buckets[modulo_value] = new_bucket;
+	// check if the ytable has a hash index
+	RETURN_IF_ERR(_ytable_instanciate_hashmap(t));
+	// continue the resize in progress
+	_ytable_index_migrate(t, _YTABLE_REHASH_GROUPS);
+	// no more empty slot: grow the index (or just clean it up if there are many deleted slots)
+	if (!t->index_free)
+		RETURN_IF_ERR(_ytable_index_resize(t, _ytable_index_compute_size(t->index_length + 1)));
+	_ytable_index_put(t, element->hash_value, element_offset);
+	++t->index_length;
 	return (YENOERR);
 }
 /*
@@ -906,63 +1152,446 @@ static ystatus_t _ytable_add_element_to_hashmap(ytable_t *t, _ytable_element_t *
  */
 static yres_int_t _ytable_extract_element_from_hashmap(ytable_t *t, _ytable_element_t *element,
                                                        const char *key, uint64_t index) {
-	yres_int_t result_undef = YRESULT_ERR(yres_int_t, YEUNDEF);
-	// check if the ytable has a bucket list
-	if (!t->buckets)
-		return (result_undef);
-	// check if the bucket exists
-	uint64_t hash_value = element ? _YTABLE_HASH_VALUE(element->hash_value) :
-	                      (key ? yhash_compute(key) : index);
-	uint64_t element_hash_value = element ? element->hash_value :
-	                              (key ? _YTABLE_SET_STRING_KEY(hash_value) :
-	                               _YTABLE_SET_NUMERIC_KEY(hash_value));
-	const char *element_key = element ? element->key : (key ? key : NULL);
-	uint32_t modulo_value = MODULO_POW2(hash_value, t->array_size);
-	uint32_t *bucket = t->buckets[modulo_value];
-	if (!bucket)
-		return (result_undef);
-	// the bucket exists, loop on it
-	//TODO: shrink the size of the bucket if needed
-	//uint32_t bucket_size = bucket[0];
-	uint32_t bucket_length = bucket[1];
-	for (uint32_t bucket_offset = 0; bucket_offset < bucket_length; ++bucket_offset) {
-		uint32_t elem_offset = bucket[bucket_offset + 2];
-		_ytable_element_t *elem = &t->elements[elem_offset];
-		// check keys
-		if (elem->hash_value != element_hash_value || strcmp0(element_key, elem->key)) {
-			// hash values are different
-			// => not the same type of keys (one is numeric and the other is string)
-			// => or not the same index keys (for numeric keys)
-			// => or not the same string keys
-			continue;
+	if (!t->index_length)
+		return (YRESULT_ERR(yres_int_t, YEUNDEF));
+	uint64_t hash_value = element ? element->hash_value :
+	                      (key ? _YTABLE_SET_STRING_KEY(ytable_hash_key(t, key)) :
+	                       _YTABLE_SET_NUMERIC_KEY(index));
+	const char *element_key = element ? element->key : key;
+	uint32_t elem_offset = _YTABLE_NOT_FOUND;
+	uint32_t slot = _YTABLE_NOT_FOUND;
+	bool in_rehash = false;
+	if (!t->index_ctrl) {
+		// no hash index: search in the array (unless the element is given)
+		elem_offset = element ? (uint32_t)(element - t->elements) :
+		              _ytable_linear_find(t, hash_value, element_key);
+	} else {
+		// search in the current index, then in the previous one if it is being resized
+		slot = _ytable_index_probe(t, t->index_ctrl, t->index_slots, t->index_size,
+		                           hash_value, element_key);
+		if (slot == _YTABLE_NOT_FOUND && t->rehash_ctrl) {
+			in_rehash = true;
+			slot = _ytable_index_probe(t, t->rehash_ctrl, t->rehash_slots,
+			                           t->rehash_size, hash_value, element_key);
 		}
-		// free the string key if needed
-		if (_YTABLE_HAS_STRING_KEY(elem->hash_value) && t->delete_function) {
-			ystatus_t st = t->delete_function(0, (char*)elem->key, NULL,
-			                                  t->delete_data);
-			if (st != YENOERR)
-				return (YRESULT_ERR(yres_int_t, st));
+		if (slot != _YTABLE_NOT_FOUND)
+			elem_offset = in_rehash ? t->rehash_slots[slot] : t->index_slots[slot];
+	}
+	if (elem_offset == _YTABLE_NOT_FOUND)
+		return (YRESULT_ERR(yres_int_t, YEUNDEF));
+	_ytable_element_t *elem = &t->elements[elem_offset];
+	// free the string key if needed
+	if (_YTABLE_HAS_STRING_KEY(elem->hash_value) && t->delete_function) {
+		ystatus_t st = t->delete_function(0, (char*)elem->key, NULL, t->delete_data);
+		if (st != YENOERR)
+			return (YRESULT_ERR(yres_int_t, st));
+	}
+	if (_YTABLE_HAS_NUMERIC_KEY(elem->hash_value))
+		--t->numeric_length;
+	if (!t->index_ctrl) {
+		--t->index_length;
+		return (YRESULT_VAL(yres_int_t, elem_offset));
+	}
+	// no element is added to the previous index, its slots are just marked as deleted
+	if (in_rehash)
+		t->rehash_ctrl[slot] = _YTABLE_CTRL_DELETED;
+	else
+		_ytable_index_remove(t, slot);
+	--t->index_length;
+	// continue the resize in progress, or shrink the index if it is mostly empty
+	if (t->rehash_ctrl)
+		_ytable_index_migrate(t, _YTABLE_REHASH_GROUPS);
+	else if (t->index_size > _YTABLE_INDEX_MIN_SIZE &&
+	         t->index_length < _YTABLE_INDEX_MIN_LENGTH(t->index_size)) {
+		// the index is not divided by more than 8, so the move is over before it is full
+		uint32_t size = MAX(_ytable_index_compute_size(t->index_length), t->index_size / 8);
+		if (size < t->index_size)
+			_ytable_index_resize(t, size);
+	}
+	return (YRESULT_VAL(yres_int_t, elem_offset));
+}
+/*
+ * Compare a control byte with all the control bytes of a group of slots.
+ * @param	group	Pointer to the first control byte of the group.
+ * @param	ctrl	Control byte to search.
+ * @return	A bit mask, with one bit set for each slot of the group whose control byte matches.
+ */
+static inline uint32_t _ytable_index_match(const uint8_t *group, uint8_t ctrl) {
+#if defined(__SSE2__)
+	__m128i bytes = _mm_loadu_si128((const __m128i*)group);
+	return ((uint32_t)_mm_movemask_epi8(_mm_cmpeq_epi8(bytes, _mm_set1_epi8((char)ctrl))));
+#else
+	uint32_t mask = 0;
+	for (uint32_t i = 0; i < _YTABLE_GROUP_SIZE; ++i)
+		mask |= (uint32_t)(group[i] == ctrl) << i;
+	return (mask);
+#endif /* __SSE2__ */
+}
+/*
+ * Return the slots of a group which are empty or deleted (their control byte has its high bit set).
+ * @param	group	Pointer to the first control byte of the group.
+ * @return	A bit mask, with one bit set for each free slot of the group.
+ */
+static inline uint32_t _ytable_index_match_free(const uint8_t *group) {
+#if defined(__SSE2__)
+	return ((uint32_t)_mm_movemask_epi8(_mm_loadu_si128((const __m128i*)group)));
+#else
+	uint32_t mask = 0;
+	for (uint32_t i = 0; i < _YTABLE_GROUP_SIZE; ++i)
+		mask |= (uint32_t)(group[i] >> 7) << i;
+	return (mask);
+#endif /* __SSE2__ */
+}
+/*
+ * Search an element in a hash index. The groups of slots are visited using triangular
+ * probing, which goes through all the groups because their number is a power of 2.
+ * @param	t		Pointer to the table.
+ * @param	index_ctrl	Control bytes of the index.
+ * @param	index_slots	Element offsets of the index.
+ * @param	index_size	Number of slots of the index.
+ * @param	hash_value	Hash value of the element (with its key type bits).
+ * @param	key		String key of the element, or NULL for numeric keys.
+ * @return	The slot of the element, or _YTABLE_NOT_FOUND.
+ */
+static uint32_t _ytable_index_probe(const ytable_t *t, const uint8_t *index_ctrl,
+                                    const uint32_t *index_slots, uint32_t index_size,
+                                    uint64_t hash_value, const char *key) {
+	uint64_t h = yhash_mix64(hash_value);
+	uint8_t h2 = h >> 57;
+	uint32_t mask = (index_size / _YTABLE_GROUP_SIZE) - 1;
+	uint32_t group = h & mask;
+	_YTABLE_COUNT(t, lookups, 1);
+	for (uint32_t step = 1; step <= mask + 1; ++step) {
+		const uint8_t *ctrl = &index_ctrl[group * _YTABLE_GROUP_SIZE];
+		_YTABLE_COUNT(t, probes, 1);
+		// check the slots with the same 7 bits of hash
+		for (uint32_t bits = _ytable_index_match(ctrl, h2); bits; bits &= bits - 1) {
+			uint32_t slot = (group * _YTABLE_GROUP_SIZE) + __builtin_ctz(bits);
+			_ytable_element_t *elem = &t->elements[index_slots[slot]];
+			if (elem->hash_value == hash_value &&
+			    (elem->key == key || !strcmp0(elem->key, key)))
+				return (slot);
 		}
-		// prepare the result value
-		yres_int_t result = YRESULT_VAL(yres_int_t, elem_offset);
-		// same numeric or string key => remove it
-		// check if it was the only element in the bucket
-		if (bucket_length == 1) {
-			free0(bucket);
-			t->buckets[modulo_value] = NULL;
-			return (result);
+		// an empty slot in the group ends the search
+		if (_ytable_index_match(ctrl, _YTABLE_CTRL_EMPTY))
+			break;
+		group = (group + step) & mask;
+	}
+	return (_YTABLE_NOT_FOUND);
+}
+/*
+ * Search an element in the hash index, and in the previous one if it is being resized.
+ * @param	t		Pointer to the table.
+ * @param	hash_value	Hash value of the element (with its key type bits).
+ * @param	key		String key of the element, or NULL for numeric keys.
+ * @return	The offset of the element in the table's array, or _YTABLE_NOT_FOUND.
+ */
+static uint32_t _ytable_index_find(const ytable_t *t, uint64_t hash_value, const char *key) {
+	if (!t->index_length)
+		return (_YTABLE_NOT_FOUND);
+	if (!t->index_ctrl)
+		return (_ytable_linear_find(t, hash_value, key));
+	uint32_t slot = _ytable_index_probe(t, t->index_ctrl, t->index_slots, t->index_size,
+	                                    hash_value, key);
+	if (slot != _YTABLE_NOT_FOUND)
+		return (t->index_slots[slot]);
+	if (!t->rehash_ctrl)
+		return (_YTABLE_NOT_FOUND);
+	slot = _ytable_index_probe(t, t->rehash_ctrl, t->rehash_slots, t->rehash_size,
+	                           hash_value, key);
+	if (slot != _YTABLE_NOT_FOUND)
+		return (t->rehash_slots[slot]);
+	return (_YTABLE_NOT_FOUND);
+}
+/*
+ * Search several elements in the hash index. The memory accesses of the searches are
+ * overlapped: the first group of slots of each element is prefetched, then the first
+ * candidate element, then its key, before the elements are searched one by one.
+ * @param	t		Pointer to the table (with a hash index).
+ * @param	count		Number of elements (up to _YTABLE_BATCH_SIZE).
+ * @param	hash_values	Hash values of the elements (with their key type bits).
+ * @param	keys		String keys of the elements (NULL for numeric keys).
+ * @param	offsets		Array filled with the offsets of the elements in the table's
+ *				array, or _YTABLE_NOT_FOUND.
+ */
+static void _ytable_index_find_batch(const ytable_t *t, uint32_t count,
+                                     const uint64_t *hash_values, const char **keys,
+                                     uint32_t *offsets) {
+	uint32_t mask = (t->index_size / _YTABLE_GROUP_SIZE) - 1;
+	uint32_t groups[_YTABLE_BATCH_SIZE];
+	const _ytable_element_t *candidates[_YTABLE_BATCH_SIZE];
+	for (uint32_t i = 0; i < count; ++i) {
+		groups[i] = (yhash_mix64(hash_values[i]) & mask) * _YTABLE_GROUP_SIZE;
+		__builtin_prefetch(&t->index_ctrl[groups[i]]);
+		__builtin_prefetch(&t->index_slots[groups[i]]);
+	}
+	for (uint32_t i = 0; i < count; ++i) {
+		uint8_t h2 = yhash_mix64(hash_values[i]) >> 57;
+		uint32_t bits = _ytable_index_match(&t->index_ctrl[groups[i]], h2);
+		candidates[i] = bits ? &t->elements[t->index_slots[groups[i] + __builtin_ctz(bits)]] :
+		                NULL;
+		if (candidates[i])
+			__builtin_prefetch(candidates[i]);
+	}
+	for (uint32_t i = 0; i < count; ++i)
+		if (candidates[i] && keys[i])
+			__builtin_prefetch(candidates[i]->key);
+	for (uint32_t i = 0; i < count; ++i)
+		offsets[i] = _ytable_index_find(t, hash_values[i], keys[i]);
+}
+/*
+ * Put an element in the first available slot of the hash index.
+ * The index must have at least one empty slot. The index length is not updated.
+ * @param	t		Pointer to the table.
+ * @param	hash_value	Hash value of the element (with its key type bits).
+ * @param	element_offset	Offset of the element in the table's array.
+ */
+static void _ytable_index_put(ytable_t *t, uint64_t hash_value, uint32_t element_offset) {
+	uint64_t h = yhash_mix64(hash_value);
+	uint32_t mask = (t->index_size / _YTABLE_GROUP_SIZE) - 1;
+	uint32_t group = h & mask;
+	uint32_t bits;
+	for (uint32_t step = 1; !(bits = _ytable_index_match_free(&t->index_ctrl[group *
+	                                                           _YTABLE_GROUP_SIZE])); ++step)
+		group = (group + step) & mask;
+	uint32_t slot = (group * _YTABLE_GROUP_SIZE) + __builtin_ctz(bits);
+	if (t->index_ctrl[slot] == _YTABLE_CTRL_EMPTY)
+		--t->index_free;
+	t->index_ctrl[slot] = h >> 57;
+	t->index_slots[slot] = element_offset;
+}
+/*
+ * Remove a slot from the hash index. If there is an empty slot in the same group, no search
+ * could have gone through the group, so the slot could be emptied too. Otherwise it is
+ * marked as deleted, to keep the probing sequences unbroken.
+ * The index length is not updated.
+ * @param	t	Pointer to the table.
+ * @param	slot	Slot to remove.
+ */
+static void _ytable_index_remove(ytable_t *t, uint32_t slot) {
+	const uint8_t *group = &t->index_ctrl[slot & ~(_YTABLE_GROUP_SIZE - 1)];
+	if (_ytable_index_match(group, _YTABLE_CTRL_EMPTY)) {
+		t->index_ctrl[slot] = _YTABLE_CTRL_EMPTY;
+		++t->index_free;
+	} else
+		t->index_ctrl[slot] = _YTABLE_CTRL_DELETED;
+}
+/*
+ * Search the slot of an element in a hash index, from its offset in the array.
+ * @param	index_ctrl	Control bytes of the index.
+ * @param	index_slots	Element offsets of the index.
+ * @param	index_size	Number of slots of the index.
+ * @param	hash_value	Hash value of the element (with its key type bits).
+ * @param	element_offset	Offset of the element in the table's array.
+ * @return	The slot of the element, or _YTABLE_NOT_FOUND.
+ */
+static uint32_t _ytable_index_probe_offset(const uint8_t *index_ctrl, const uint32_t *index_slots,
+                                           uint32_t index_size, uint64_t hash_value,
+                                           uint32_t element_offset) {
+	uint64_t h = yhash_mix64(hash_value);
+	uint8_t h2 = h >> 57;
+	uint32_t mask = (index_size / _YTABLE_GROUP_SIZE) - 1;
+	uint32_t group = h & mask;
+	for (uint32_t step = 1; step <= mask + 1; ++step) {
+		const uint8_t *ctrl = &index_ctrl[group * _YTABLE_GROUP_SIZE];
+		for (uint32_t bits = _ytable_index_match(ctrl, h2); bits; bits &= bits - 1) {
+			uint32_t slot = (group * _YTABLE_GROUP_SIZE) + __builtin_ctz(bits);
+			if (index_slots[slot] == element_offset)
+				return (slot);
+		}
+		if (_ytable_index_match(ctrl, _YTABLE_CTRL_EMPTY))
+			break;
+		group = (group + step) & mask;
+	}
+	return (_YTABLE_NOT_FOUND);
+}
+/*
+ * Update the hash index entry of a keyed element which is moved in the array, or remove
+ * it from the hash index. The index length is not updated.
+ * @param	t		Pointer to the table.
+ * @param	old_offset	Offset of the element in the array (it must still be there).
+ * @param	new_offset	New offset of the element, or _YTABLE_NOT_FOUND to remove it.
+ */
+static void _ytable_index_relocate(ytable_t *t, uint32_t old_offset, uint32_t new_offset) {
+	// no hash index: the keyed elements are searched in the array
+	if (!t->index_ctrl)
+		return;
+	uint64_t hash_value = t->elements[old_offset].hash_value;
+	uint32_t slot = _ytable_index_probe_offset(t->index_ctrl, t->index_slots, t->index_size,
+	                                           hash_value, old_offset);
+	if (slot != _YTABLE_NOT_FOUND) {
+		if (new_offset == _YTABLE_NOT_FOUND)
+			_ytable_index_remove(t, slot);
+		else
+			t->index_slots[slot] = new_offset;
+		return;
+	}
+	// the element was not moved to the new index yet
+	if (!t->rehash_ctrl)
+		return;
+	slot = _ytable_index_probe_offset(t->rehash_ctrl, t->rehash_slots, t->rehash_size,
+	                                  hash_value, old_offset);
+	if (slot == _YTABLE_NOT_FOUND)
+		return;
+	if (new_offset == _YTABLE_NOT_FOUND)
+		t->rehash_ctrl[slot] = _YTABLE_CTRL_DELETED;
+	else
+		t->rehash_slots[slot] = new_offset;
+}
+/*
+ * Compute the size of a hash index, for a given number of elements. The index will be
+ * half-full (at most), leaving room for as many new elements.
+ * @param	length	Number of elements.
+ * @return	The number of slots.
+ */
+static uint32_t _ytable_index_compute_size(uint32_t length) {
+	uint32_t size = _YTABLE_INDEX_MIN_SIZE;
+	while ((uint64_t)length * 2 > _YTABLE_INDEX_CAPACITY(size))
+		size *= 2;
+	return (size);
+}
+/*
+ * Start the resize of the hash index. A new empty index is created, and the current one
+ * becomes the previous index; its elements will be moved a few at a time by
+ * _ytable_index_migrate(), so no modification of the table has to move all of them.
+ * @param	t	Pointer to the table.
+ * @param	size	New number of slots.
+ * @return	YENOERR if OK.
+ */
+static ystatus_t _ytable_index_resize(ytable_t *t, uint32_t size) {
+	// a resize is already in progress (should not happen): rebuild the index at once
+	if (t->rehash_ctrl)
+		return (_ytable_index_rebuild(t, size));
+	_YTABLE_COUNT(t, resizes, size > t->index_size);
+	_YTABLE_COUNT(t, shrinks, size < t->index_size);
+	uint8_t *ctrl = _ytable_calloc(t, size, sizeof(uint8_t));
+	uint32_t *slots = _ytable_calloc(t, size, sizeof(uint32_t));
+	if (!ctrl || !slots) {
+		_YTABLE_FREE(t, ctrl);
+		_YTABLE_FREE(t, slots);
+		return (YENOMEM);
+	}
+	memset(ctrl, _YTABLE_CTRL_EMPTY, size);
+	t->rehash_ctrl = t->index_ctrl;
+	t->rehash_slots = t->index_slots;
+	t->rehash_size = t->index_size;
+	t->rehash_offset = 0;
+	t->index_ctrl = ctrl;
+	t->index_slots = slots;
+	t->index_size = size;
+	t->index_free = _YTABLE_INDEX_CAPACITY(size);
+	return (YENOERR);
+}
+/*
+ * Move some elements from the previous hash index to the current one, if a resize is
+ * in progress. The previous index is freed when all its elements were moved.
+ * @param	t		Pointer to the table.
+ * @param	nb_groups	Number of groups of slots to process.
+ */
+static void _ytable_index_migrate(ytable_t *t, uint32_t nb_groups) {
+	if (!t->rehash_ctrl)
+		return;
+	uint32_t end = MIN(t->rehash_offset + (nb_groups * _YTABLE_GROUP_SIZE), t->rehash_size);
+	for (uint32_t offset = t->rehash_offset; offset < end; offset += _YTABLE_GROUP_SIZE) {
+		// used slots are those whose control byte is not empty or deleted
+		uint32_t bits = ~_ytable_index_match_free(&t->rehash_ctrl[offset]) & 0xFFFF;
+		for (; bits; bits &= bits - 1) {
+			uint32_t slot = offset + __builtin_ctz(bits);
+			uint32_t element_offset = t->rehash_slots[slot];
+			_ytable_index_put(t, t->elements[element_offset].hash_value, element_offset);
+			t->rehash_ctrl[slot] = _YTABLE_CTRL_DELETED;
 		}
-		// decrements the used size of the bucket
-		--bucket[1];
-		// check if it's the last element in the bucket
-		if (bucket_offset == (bucket_length - 1)) {
-			return (result);
+	}
+	t->rehash_offset = end;
+	if (end == t->rehash_size)
+		_ytable_index_free_rehash(t);
+}
+/*
+ * Free the previous hash index.
+ * @param	t	Pointer to the table.
+ */
+static void _ytable_index_free_rehash(ytable_t *t) {
+	_YTABLE_FREE(t, t->rehash_ctrl);
+	_YTABLE_FREE(t, t->rehash_slots);
+	t->rehash_size = 0;
+	t->rehash_offset = 0;
+}
+/*
+ * Update the element offsets of a hash index, when some elements were moved in the array.
+ * @param	index_ctrl	Control bytes of the index.
+ * @param	index_slots	Element offsets of the index.
+ * @param	index_size	Number of slots of the index.
+ * @param	end		Elements whose offset is lower than this value were moved.
+ * @param	delta		Value added to the offsets of the moved elements.
+ */
+static void _ytable_index_move_offsets(uint8_t *index_ctrl, uint32_t *index_slots,
+                                       uint32_t index_size, uint32_t end, uint32_t delta) {
+	for (uint32_t slot = 0; slot < index_size; ++slot)
+		if (!(index_ctrl[slot] & _YTABLE_CTRL_EMPTY) && index_slots[slot] < end)
+			index_slots[slot] += delta;
+}
+/*
+ * Rebuild the hash index of a ytable from its keyed elements. If the size doesn't change,
+ * the index is rebuilt in place and the function can't fail. A resize in progress is
+ * cancelled.
+ * @param	t	Pointer to the table.
+ * @param	size	New number of slots (power of 2, multiple of _YTABLE_GROUP_SIZE).
+ * @return	YENOERR if OK.
+ */
+static ystatus_t _ytable_index_rebuild(ytable_t *t, uint32_t size) {
+	if (size != t->index_size || !t->index_ctrl) {
+		uint8_t *ctrl = _ytable_calloc(t, size, sizeof(uint8_t));
+		uint32_t *slots = _ytable_calloc(t, size, sizeof(uint32_t));
+		if (!ctrl || !slots) {
+			_YTABLE_FREE(t, ctrl);
+			_YTABLE_FREE(t, slots);
+			return (YENOMEM);
+		}
+		_YTABLE_COUNT(t, resizes, t->index_ctrl && size > t->index_size);
+		_YTABLE_COUNT(t, shrinks, t->index_ctrl && size < t->index_size);
+		_YTABLE_FREE(t, t->index_ctrl);
+		_YTABLE_FREE(t, t->index_slots);
+		t->index_ctrl = ctrl;
+		t->index_slots = slots;
+		t->index_size = size;
+	}
+	_ytable_index_free_rehash(t);
+	memset(t->index_ctrl, _YTABLE_CTRL_EMPTY, size);
+	t->index_length = 0;
+	t->index_free = _YTABLE_INDEX_CAPACITY(size);
+	for (uint32_t position = 0; position < t->length; ++position) {
+		uint32_t offset = _ytable_offset(t, position);
+		uint64_t hash_value = t->elements[offset].hash_value;
+		if (hash_value) {
+			_ytable_index_put(t, hash_value, offset);
+			++t->index_length;
 		}
-		// it's an element in the middle of the bucket
-		memmove(&bucket[bucket_offset + 2], &bucket[bucket_offset + 3],
-			(bucket_length - bucket_offset - 1) * sizeof(uint32_t));
-		return (result);
 	}
-	return (result_undef);
+	return (YENOERR);
 }
-
+#ifdef USE_HASH_STATS
+/*
+ * Add the probe lengths of the elements of a hash index to a histogram: the number of
+ * groups of slots visited by a search, from the group given by the hash value to the
+ * group where the element is stored.
+ * @param	t		Pointer to the table.
+ * @param	index_ctrl	Control bytes of the index.
+ * @param	index_slots	Element offsets of the index.
+ * @param	index_size	Number of slots of the index.
+ * @param	histogram	Histogram to update (YHASH_STATS_HISTOGRAM_SIZE entries).
+ */
+static void _ytable_index_histogram(const ytable_t *t, const uint8_t *index_ctrl,
+                                    const uint32_t *index_slots, uint32_t index_size,
+                                    size_t *histogram) {
+	uint32_t mask = (index_size / _YTABLE_GROUP_SIZE) - 1;
+	for (uint32_t slot = 0; slot < index_size; ++slot) {
+		if (index_ctrl[slot] & _YTABLE_CTRL_EMPTY)
+			continue;
+		uint32_t group = yhash_mix64(t->elements[index_slots[slot]].hash_value) & mask;
+		uint32_t length = 1;
+		for (uint32_t step = 1; group != slot / _YTABLE_GROUP_SIZE; ++step, ++length)
+			group = (group + step) & mask;
+		++histogram[MIN(length, YHASH_STATS_HISTOGRAM_SIZE - 1)];
+	}
+}
+#endif /* USE_HASH_STATS */
@@ -8,29 +8,134 @@
 
 #include <stdint.h>
 #include "ystatus.h"
+#include "yarena.h"
+#include "yhash.h"
+
+/* Bits of the hash value of elements (see _ytable_element_t). */
+/** @define _YTABLE_HAS_NUMERIC_KEY	Returns 1 if an element has a numeric key. */
+#define _YTABLE_HAS_NUMERIC_KEY(h)	((h) & ((uint64_t)1 << 63)) // 0b10...00 (64 bits)
+/** @define _YTABLE_HAS_STRING_KEY	Returns 1 if an element has a string key. */
+#define _YTABLE_HAS_STRING_KEY(h)	((h) & ((uint64_t)1 << 62)) // 0b01...00 (64 bits)
+/** @define _YTABLE_HAS_NO_KEY		Returns 1 if an element has no defined key. */
+#define _YTABLE_HAS_NO_KEY(h)		(!((h) & ((uint64_t)3 << 62))) // 0b11...00 (64 bits)
+/** @define _YTABLE_HASH_VALUE		Extract the real hash value from a hash field. */
+#define _YTABLE_HASH_VALUE(h)		((h) & 0x3FFFFFFFFFFFFFFF) // 0b0011...11 (64 bits)
+/** @define _YTABLE_SET_NUMERIC_KEY	Set the numeric key bit to a hash value. */
+#define _YTABLE_SET_NUMERIC_KEY(h)	(_YTABLE_HASH_VALUE(h) | ((uint64_t)1 << 63)) // 0b10..00
+/** @define _YTABLE_SET_STRING_KEY	Set the string key bit to a hash value. */
+#define _YTABLE_SET_STRING_KEY(h)	(_YTABLE_HASH_VALUE(h) | ((uint64_t)1 << 62)) // 0b01..00
+/** @define _YTABLE_SET_NO_KEY		Set no key bit to a hash value. */
+#define _YTABLE_SET_NO_KEY		(_YTABLE_HASH_VALUE(h))
 
 /** @typedef ytable_function_t	Function pointer. */
 typedef ystatus_t (*ytable_function_t)(uint64_t hash, char *key, void *data, void *user_data);
+/**
+ * @typedef	ytable_copy_function_t
+ *		Function used to copy an element, when a cloned ytable stops sharing its
+ *		elements. It could replace the key and the data by copies of them.
+ */
+typedef ystatus_t (*ytable_copy_function_t)(uint64_t hash, char **key, void **data,
+                                            void *user_data);
+/**
+ * @typedef	_ytable_element_t
+ *		Storage structure of an element. Private, defined here for the inline
+ *		iterator functions.
+ * @field	data		Pointer to the stored data.
+ * @field	key		String key.
+ * @field	hash_value	- 64th bit: 1 if numeric key (0 if keyless array-like)
+ *				- 63rd bit: 1 if string key (0 if keyless array-like)
+ *				- 62 bits: numéric key or computed hash from the string key
+ */
+typedef struct _ytable_element_s {
+	void *data;
+	const char *key;
+	uint64_t hash_value;
+} _ytable_element_t;
 /**
  * @typedef	_ytable_t
  *		ytable structure.
  * @field	length		Number of stored elements.
  * @field	array_size	Allocated size of the array.
  * @field	next_index	Next numeric index.
+ * @field	head		Offset of the first element in the array. The array is used as a
+ *				ring buffer, so elements can be added or removed at both ends
+ *				without moving the others.
  * @field	elements	Array of table's elements.
- * @field	buckets		Array of bucket lists.
+ * @field	index_ctrl	Control bytes of the hash index (one per slot): empty, deleted or
+ *				7 bits of the hash. NULL if the table has no keyed element, or if
+ *				it is short enough for its keyed elements to be searched linearly.
+ * @field	index_slots	Offsets of the keyed elements in the array (one per slot).
+ * @field	index_size	Number of slots of the hash index (power of 2, multiple of 16).
+ * @field	index_length	Number of keyed elements (in both hash indexes while resizing, in
+ *				the array only if there is no hash index).
+ * @field	numeric_length	Number of keyed elements whose key is numeric.
+ * @field	index_free	Number of empty slots which could be used before resizing the index.
+ * @field	rehash_ctrl	Control bytes of the previous hash index, while it is resized. Its
+ *				elements are moved to the new index a few at a time, on each
+ *				modification of the table. NULL if no resize is in progress.
+ * @field	rehash_slots	Element offsets of the previous hash index.
+ * @field	rehash_size	Number of slots of the previous hash index.
+ * @field	rehash_offset	Next slot of the previous hash index to move.
+ * @field	hash_function	Function used to hash string keys, or NULL to use yhash_string().
+ * @field	hash_seed	Seed given to the hash function.
  * @field	delete_function	Pointer to a function used to delete elements.
  * @field	delete_data	Pointer to data pass to the delete function.
+ * @field	copy_function	Pointer to a function used to copy elements when the table stops
+ *				sharing them with its clones, or NULL.
+ * @field	copy_data	Pointer to data pass to the copy function.
+ * @field	share		Reference counter of the array and hash indexes, if they are shared
+ *				with clones of the table (copied on the first modification).
+ *				NULL if the table is the only one to use them.
+ * @field	arena		Pointer to the arena used to allocate the table's memory,
+ *				or NULL to use the heap.
+ * @field	stats		Counters of resizes and searches of the hash index (only if the
+ *				library is compiled with USE_HASH_STATS).
  */
 typedef struct ytable_s {
 	uint32_t length;
 	uint32_t array_size;
 	uint64_t next_index;
-	struct _ytable_element_s *elements;
-	uint32_t **buckets;
+	uint32_t head;
+	_ytable_element_t *elements;
+	uint8_t *index_ctrl;
+	uint32_t *index_slots;
+	uint32_t index_size;
+	uint32_t index_length;
+	uint32_t numeric_length;
+	uint32_t index_free;
+	uint8_t *rehash_ctrl;
+	uint32_t *rehash_slots;
+	uint32_t rehash_size;
+	uint32_t rehash_offset;
+	yhash_function_t hash_function;
+	uint64_t hash_seed;
 	ytable_function_t delete_function;
 	void *delete_data;
+	ytable_copy_function_t copy_function;
+	void *copy_data;
+	struct _ytable_share_s *share;
+	yarena_t *arena;
+#ifdef USE_HASH_STATS
+	yhash_counters_t stats;
+#endif /* USE_HASH_STATS */
 } ytable_t;
+/**
+ * @typedef	ytable_iterator_t
+ *		Iterator on the elements of a ytable, allocated by the caller (usually on the
+ *		stack). See ytable_iterator().
+ * @field	table		Pointer to the ytable.
+ * @field	position	Position of the next element.
+ * @field	hash		Index of the current element (numeric key or position).
+ * @field	key		String key of the current element, or NULL.
+ * @field	data		Data of the current element.
+ */
+typedef struct {
+	ytable_t *table;
+	uint32_t position;
+	uint64_t hash;
+	const char *key;
+	void *data;
+} ytable_iterator_t;
 
 #include "yresult.h"
 
@@ -50,6 +155,17 @@ ytable_t *ytable_new(void);
  * @return	A pointer to the allocated ytable.
  */
 ytable_t *ytable_create(size_t size, ytable_function_t delete_function, void *delete_data);
+/**
+ * @function	ytable_create_arena
+ *		Create a new ytable whose memory (the structure itself, its elements and
+ *		its hashmap) is allocated from an arena. The memory is never given back
+ *		individually: ytable_free() calls the delete function on the elements
+ *		but doesn't free anything, and the memory is released with the arena.
+ * @param	size	Table size. If set to zero, the default size will be used.
+ * @param	arena	Pointer to the arena.
+ * @return	A pointer to the allocated ytable.
+ */
+ytable_t *ytable_create_arena(size_t size, yarena_t *arena);
 /**
  * @function	ytable_init
  *		Initialize a ytable (for static usage).
@@ -69,6 +185,30 @@ ytable_t *ytable_init(ytable_t *table, ytable_function_t delete_function, void *
  */
 ytable_t *ytable_set_delete_function(ytable_t *table, ytable_function_t delete_function,
                                      void *delete_data);
+/**
+ * @function	ytable_set_copy_function
+ *		Define the copy function of a ytable. When a cloned table is modified for the
+ *		first time, it gets its own copy of the array, and the copy function is called
+ *		on each element, so the table doesn't share its keys and data with its clones.
+ *		Without copy function, the pointers are simply copied.
+ * @param	table		Pointer to the ytable.
+ * @param	copy_function	Pointer to the function used to copy elements. Could be NULL.
+ * @param	copy_data	Pointer to some data given to the copy function. Could be NULL.
+ * @return	A pointer to the given ytable.
+ */
+ytable_t *ytable_set_copy_function(ytable_t *table, ytable_copy_function_t copy_function,
+                                   void *copy_data);
+/**
+ * @function	ytable_set_hash_function
+ *		Define the function used to hash the string keys of a ytable. If the table
+ *		already contains keyed elements, they are rehashed.
+ * @param	table		Pointer to the ytable.
+ * @param	hash_function	Pointer to the hash function, or NULL to use the default one
+ *				(yhash_string()).
+ * @param	seed		Seed given to the hash function.
+ * @return	YENOERR if OK.
+ */
+ystatus_t ytable_set_hash_function(ytable_t *table, yhash_function_t hash_function, uint64_t seed);
 /**
  * @function	ytable_free
  *		Destroy a ytable.
@@ -77,11 +217,45 @@ ytable_t *ytable_set_delete_function(ytable_t *table, ytable_function_t delete_f
 void ytable_free(ytable_t *table);
 /**
  * @function	ytable_clone
- *		Clone a ytable. Pointers are simply copied, as well as destruction data.
+ *		Clone a ytable, in constant time: the clone shares the array and the hash
+ *		index of the original table. The first modification of any of them copies
+ *		the shared memory (and calls the copy function on the elements), so they
+ *		stay independent. The delete function is called on the shared elements
+ *		only when the last of them is freed.
+ *		The copies go to the table which is modified, whether it is the original
+ *		table or a clone: the other tables keep the shared elements. So if the
+ *		table has a copy function, the data pointers (and string keys) obtained from
+ *		a table before its first modification belong to the tables it was shared
+ *		with afterwards; they must be read again from the modified table.
+ *		Destruction and copy data are copied.
+ *		The clone of an arena-backed ytable is copied at once, on the heap.
+ *		Several threads could clone the same table at the same time, as long as
+ *		it is not modified.
  * @param	table	Pointer to the ytable.
  * @return	The cloned table.
  */
 ytable_t *ytable_clone(ytable_t *table);
+/**
+ * @function	ytable_detach
+ *		Give its own array and hash index to a ytable which shares them with its
+ *		clones (see ytable_clone()). It is done by all the functions which modify the
+ *		table, but must be called before modifying the data of its elements in place:
+ *		the copy function is then called on them. The pointers to the data of the
+ *		elements read before the call are not valid for this table anymore (see
+ *		ytable_clone()).
+ * @param	table	Pointer to the ytable.
+ * @return	YENOERR if OK.
+ *		YENOMEM if the memory couldn't be allocated.
+ *		Other error code if the copy function failed.
+ */
+ystatus_t ytable_detach(ytable_t *table);
+/**
+ * @function	ytable_is_shared
+ *		Tell if a ytable shares its elements with some of its clones.
+ * @param	table	Pointer to the ytable.
+ * @return	True if the elements are shared.
+ */
+bool ytable_is_shared(const ytable_t *table);
 
 /* ********** ARRAY-LIKE ********** */
 /**
@@ -104,6 +278,10 @@ ystatus_t ytable_madd(ytable_t *table, uint32_t count, ...);
 /**
  * @function	ytable_push
  *		Add an element at the beginning of a ytable (used as an array).
+ *		The other elements are not moved, but their positions change: an
+ *		element whose numeric key becomes equal to its position loses its key
+ *		(like if it had been added as an array element). Done in constant time
+ *		if the table has no element with a numeric key.
  * @param	table	Pointer to the ytable.
  * @param	data	Pointer to data.
  * @return	YENOERR if OK.
@@ -112,6 +290,10 @@ ystatus_t ytable_push(ytable_t *table, void *data);
 /**
  * @function	ytable_mpush
  *		Add multiple elements at the beginning of a ytable (used as an array).
+ *		The other elements are not moved, but their positions change: an
+ *		element whose numeric key becomes equal to its position loses its key
+ *		(like if it had been added as an array element). Done in constant time
+ *		if the table has no element with a numeric key.
  * @param	table	Pointer to the ytable.
  * @param	count	Number of elements to add.
  * @param	...	Elements to add.
@@ -128,6 +310,10 @@ void *ytable_pop(ytable_t *table);
 /**
  * @function	ytable_shift
  *		Remove the first element of a ytable and return it.
+ *		The other elements are not moved, but their positions change: an
+ *		element whose numeric key becomes equal to its position loses its key
+ *		(like if it had been added as an array element). Done in constant time
+ *		if the table has no element with a numeric key.
  * @param	table	Pointer to the ytable.
  * @return	A pointer to the removed data.
  */
@@ -168,6 +354,21 @@ yres_pointer_t ytable_get_index(ytable_t *table, uint64_t index);
  * @return	A pointer to the element's data, or NULL if the element doesn't exist.
  */
 void *ytable_get_index_data(ytable_t *table, uint64_t index);
+/**
+ * @function	ytable_get_indexes_batch
+ *		Return the data values associated to a list of indexes. Faster than
+ *		calling ytable_get_index() for each of them: the elements are searched
+ *		by small batches, and their memory is prefetched for all the elements of
+ *		a batch before any of them is read, so the cache misses overlap.
+ * @param	table	Pointer to the ytable.
+ * @param	count	Number of indexes.
+ * @param	indexes	Array of indexes.
+ * @param	results	Array of (at least) count pointers, filled with the data of the
+ *			elements, or NULL for the elements which don't exist.
+ * @return	The number of elements found.
+ */
+uint32_t ytable_get_indexes_batch(ytable_t *table, uint32_t count, const uint64_t *indexes,
+                                  void **results);
 /**
  * @function	ytable_set_index
  *		Add an element in a ytable using an index.
@@ -231,6 +432,28 @@ bool ytable_key_isset(ytable_t *table, const char *key);
  *		YEUNDEF if the index doesn't exist.
  */
 yres_pointer_t ytable_get_key(ytable_t *table, const char *key);
+/**
+ * @function	ytable_get_key_hashed
+ *		Return the value associated to the given string key, whose hash value was
+ *		already computed (using ytable_hash_key(), or yhash_string() for tables using
+ *		the default hash function). Unlike ytable_get_key(), numeric string keys are
+ *		not managed as indexes; use ytable_get_index() for them.
+ * @param	table		Pointer to the ytable.
+ * @param	key		String key of the search element.
+ * @param	hash_value	Hash value of the key.
+ * @return	YENOERR if the element exists, and a pointer to the element's data.
+ *		YEINVAL if the table doesn't exist.
+ *		YEUNDEF if the key doesn't exist.
+ */
+yres_pointer_t ytable_get_key_hashed(ytable_t *table, const char *key, uint64_t hash_value);
+/**
+ * @function	ytable_hash_key
+ *		Compute the hash value of a string key, using the hash function of a ytable.
+ * @param	table	Pointer to the ytable.
+ * @param	key	String key.
+ * @return	The hash value.
+ */
+uint64_t ytable_hash_key(const ytable_t *table, const char *key);
 /**
  * @function	ytable_get_key_data
  *		Return the data value associated to the given string key.
@@ -239,6 +462,22 @@ yres_pointer_t ytable_get_key(ytable_t *table, const char *key);
  * @return	A pointer to the element's data, or NULL if the element doesn't exist.
  */
 void *ytable_get_key_data(ytable_t *table, const char *key);
+/**
+ * @function	ytable_get_keys_batch
+ *		Return the data values associated to a list of string keys. Faster than
+ *		calling ytable_get_key() for each of them: the keys are hashed by small
+ *		batches, and the memory used to search them (hash index slots, elements,
+ *		keys) is prefetched for all the keys of a batch before any of them is
+ *		compared, so the cache misses overlap.
+ * @param	table	Pointer to the ytable.
+ * @param	count	Number of keys.
+ * @param	keys	Array of string keys.
+ * @param	results	Array of (at least) count pointers, filled with the data of the
+ *			elements, or NULL for the keys which don't exist.
+ * @return	The number of elements found.
+ */
+uint32_t ytable_get_keys_batch(ytable_t *table, uint32_t count, const char **keys,
+                               void **results);
 /**
  * @function	ytable_set_key
  *		Add an element in a ytable using a string key.
@@ -283,4 +522,66 @@ bool ytable_is_array(ytable_t *table);
  * @return	YENOERR if the callback return YENOERR for all elements.
  */
 ystatus_t ytable_foreach(ytable_t *table, ytable_function_t func, void *user_data);
+#ifdef USE_HASH_STATS
+/**
+ * @function	ytable_stats
+ *		Compute the statistics of a ytable's hash index. The histogram gives the number
+ *		of groups of slots visited to find each keyed element (or the number of elements
+ *		compared, for short tables without hash index).
+ * @param	table	Pointer to the ytable.
+ * @param	stats	Pointer to the statistics structure to fill.
+ * @return	YENOERR if OK.
+ *		YEINVAL if a parameter is NULL.
+ */
+ystatus_t ytable_stats(const ytable_t *table, yhash_stats_t *stats);
+#endif /* USE_HASH_STATS */
 
+/* ********** ITERATORS ********** */
+/**
+ * @function	ytable_iterator
+ *		Create an iterator on the elements of a ytable. Unlike ytable_foreach(), no
+ *		function is called for each element, and the loop could be stopped at any time
+ *		(there is nothing to free).
+ *		ytable_iterator_t it = ytable_iterator(table);
+ *		while (ytable_iterator_next(&it))
+ *			printf("%s\n", (char*)it.data);
+ * @param	table	Pointer to the ytable.
+ * @return	The iterator, placed before the first element.
+ */
+static inline ytable_iterator_t ytable_iterator(ytable_t *table) {
+	return ((ytable_iterator_t){
+		.table = table,
+	});
+}
+/**
+ * @function	ytable_iterator_next
+ *		Move an iterator to the next element of its ytable. The table must not be
+ *		modified during the iteration, except with ytable_iterator_remove().
+ * @param	it	Pointer to the iterator.
+ * @return	True if the iterator is on an element, false if there is no more element.
+ */
+static inline bool ytable_iterator_next(ytable_iterator_t *it) {
+	ytable_t *table = it->table;
+	if (!table || it->position >= table->length)
+		return (false);
+	uint32_t position = it->position++;
+	// the array is a ring buffer whose size is a power of 2
+	const _ytable_element_t *elem = &table->elements[(table->head + position) &
+	                                                 (table->array_size - 1)];
+	it->hash = _YTABLE_HAS_NUMERIC_KEY(elem->hash_value) ?
+	           _YTABLE_HASH_VALUE(elem->hash_value) : position;
+	it->key = elem->key;
+	it->data = elem->data;
+	return (true);
+}
+/**
+ * @function	ytable_iterator_remove
+ *		Remove the current element of an iterator from its ytable (the delete function
+ *		is called on it). The next call to ytable_iterator_next() returns the element
+ *		that followed the removed one. Must not be called twice on the same element.
+ * @param	it	Pointer to the iterator.
+ * @return	YENOERR if OK.
+ *		YEINVAL if the iterator is not on an element.
+ *		Other error code if the delete function failed.
+ */
+ystatus_t ytable_iterator_remove(ytable_iterator_t *it);
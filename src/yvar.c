@@ -2,6 +2,7 @@
 
 /* ********** PRIVATE FUNCTIONS ********** */
 static ystatus_t _yvar_delete_table_item(uint64_t index, char *key, void *data, void *user_data);
+static ystatus_t _yvar_copy_table_item(uint64_t index, char **key, void **data, void *user_data);
 
 /* ********** FUNCTIONS ********** */
 /* Create a new undefined yvar. */
@@ -129,6 +130,7 @@ yvar_t *yvar_init_table(yvar_t *var, ytable_t *value) {
 	else if (!(var->table_value = ytable_new()))
 		return (NULL);
 	ytable_set_delete_function(var->table_value, _yvar_delete_table_item, NULL);
+	ytable_set_copy_function(var->table_value, _yvar_copy_table_item, NULL);
 	return (var);
 }
 /* Create a new pointer yvar. */
@@ -185,7 +187,10 @@ yvar_t *yvar_clone(const yvar_t *var) {
 			result->string_value = ys_dup(var->string_value);
 			break;
 		case YVAR_TABLE:
-			result->table_value = ytable_clone(var->table_value);
+			if (!(result->table_value = ytable_clone(var->table_value))) {
+				free0(result);
+				return (NULL);
+			}
 			break;
 		case YVAR_POINTER:
 			result->pointer_value = var->pointer_value;
@@ -216,6 +221,24 @@ static ystatus_t _yvar_delete_table_item(uint64_t index, char *key, void *data,
 	yvar_delete((yvar_t*)data);
 	return (YENOERR);
 }
+/*
+ * Copy an item of a cloned table, when the table stops sharing its items: the key is
+ * duplicated and the value is cloned (its own items are shared until it is modified).
+ */
+static ystatus_t _yvar_copy_table_item(uint64_t index, char **key, void **data,
+                                       void *user_data) {
+	char *new_key = NULL;
+	yvar_t *new_data = NULL;
+	if ((*key && !(new_key = ys_copy(*key))) ||
+	    (*data && !(new_data = yvar_clone((yvar_t*)*data)))) {
+		ys_free(new_key);
+		return (YENOMEM);
+	}
+	if (*key)
+		*key = new_key;
+	*data = new_data;
+	return (YENOERR);
+}
 void yvar_delete(yvar_t *var) {
 	if (!var)
 		return;
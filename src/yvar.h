@@ -35,6 +35,9 @@
  * 	    "bb": 23
  * 	}
  * </code>
+ * With yjson_parse_arena(), all the yvars of the document (with their strings and tables) are
+ * allocated from an arena (see yarena.h). They must not be destroyed individually; the whole
+ * document is released with yarena_free().
  *
  * <h2>Path</h2>
  * From a given yvar, it is possible to extract deep data using a "vpath" similar to XPath for
@@ -281,7 +284,12 @@ yvar_t *yvar_init_pointer(yvar_t *var, void *value);
 yvar_t *yvar_new_object(void *value, yvar_function_t delete_function, void *delete_data);
 /**
  * @function	yvar_clone
- *		Create a copy of a given yvar.
+ *		Create a copy of a given yvar. Tables are cloned in constant time: the
+ *		copy shares the items of the original table until one of them is modified
+ *		(see ytable_clone()). Then its keys are duplicated and its values are
+ *		cloned the same way, so a tree is copied lazily, one level at a time.
+ *		ytable_detach() must be called on a table before modifying its values in
+ *		place.
  * @param	var	A pointer to the yvar.
  * @return	A pointer to the newly allocated yvar.
  */
@@ -381,14 +389,78 @@ ytable_t *yvar_get_table(yvar_t *var);
 void *yvar_get_pointer(yvar_t *var);
 
 /* ********** PATH ********** */
+/**
+ * @typedef	yvar_path_step_type_t
+ *		Type of a compiled path step.
+ * @constant	YVAR_PATH_KEY		String key of an associative table ("/foo").
+ * @constant	YVAR_PATH_KEY_INDEX	Numeric key of an associative table ("/12").
+ * @constant	YVAR_PATH_INDEX		Index of an array ("[12]").
+ * @constant	YVAR_PATH_ARRAY		Check that the value is an array ("[]").
+ */
+typedef enum {
+	YVAR_PATH_KEY = 0,
+	YVAR_PATH_KEY_INDEX,
+	YVAR_PATH_INDEX,
+	YVAR_PATH_ARRAY,
+} yvar_path_step_type_t;
+/**
+ * @typedef	yvar_path_step_t
+ *		Step of a compiled path.
+ * @field	type	Type of the step.
+ * @field	key	String key (for YVAR_PATH_KEY steps).
+ * @field	hash	Hash value of the string key (computed with yhash_string()), or numeric
+ *			index.
+ */
+typedef struct {
+	yvar_path_step_type_t type;
+	const char *key;
+	uint64_t hash;
+} yvar_path_step_t;
+/**
+ * @typedef	yvar_path_t
+ *		Compiled path (see yvar_path_compile()). Allocated as one block of memory.
+ * @field	nb_steps	Number of steps.
+ * @field	steps		Array of steps.
+ */
+typedef struct {
+	uint32_t nb_steps;
+	yvar_path_step_t steps[];
+} yvar_path_t;
+
 /**
  * @function	yvar_get_from_path
  *		Return a value from a yvar root element and a path (similar to XPath).
+ *		To evaluate the same path many times, yvar_path_compile() and
+ *		yvar_path_eval() should be used instead.
  * @param	root	JSON root element.
  * @param	path	Path selector, similar to XPath.
  * @return	The selectedd value.
  */
 yvar_t *yvar_get_from_path(yvar_t *root, const char *path);
+/**
+ * @function	yvar_path_compile
+ *		Compile a path (see yvar_get_from_path()) into a list of steps, with
+ *		precomputed key hashes and indexes, that could be evaluated many times.
+ * @param	path	Path selector, similar to XPath.
+ * @return	A pointer to the compiled path, or NULL if the path is not valid (it
+ *		would never select any value) or if a memory allocation failed.
+ */
+yvar_path_t *yvar_path_compile(const char *path);
+/**
+ * @function	yvar_path_eval
+ *		Return a value from a yvar root element and a compiled path. No memory
+ *		is allocated.
+ * @param	path	Pointer to the compiled path.
+ * @param	root	JSON root element.
+ * @return	The selected value, or NULL if it doesn't exist.
+ */
+yvar_t *yvar_path_eval(const yvar_path_t *path, yvar_t *root);
+/**
+ * @function	yvar_path_free
+ *		Destroy a compiled path.
+ * @param	path	Pointer to the compiled path.
+ */
+void yvar_path_free(yvar_path_t *path);
 
 #if defined(__cplusplus) || defined(c_plusplus)
 }
@@ -2,68 +2,127 @@
 
 /* Return a value from a JSON root element and a path (similar to XPath). */
 yvar_t *yvar_get_from_path(yvar_t *root, const char *path) {
-	const char *pt = NULL;
-	yvar_t *result = root;
-	ystr_t s = NULL;
-
 	if (!root || !path || !strlen(path))
 		return (root);
+	yvar_path_t *compiled = yvar_path_compile(path);
+	yvar_t *result = yvar_path_eval(compiled, root);
+	yvar_path_free(compiled);
+	return (result);
+}
+/* Compile a path. */
+yvar_path_t *yvar_path_compile(const char *path) {
+	if (!path)
+		return (NULL);
+	// the path and the steps are allocated in the same block, using maximum sizes
+	size_t len = strlen(path);
+	size_t max_steps = 0;
+	for (const char *pt = path; *pt; ++pt)
+		if (*pt == SLASH || *pt == LBRACKET)
+			++max_steps;
+	yvar_path_t *result = malloc0(sizeof(yvar_path_t) + max_steps * sizeof(yvar_path_step_t) +
+	                              len + max_steps);
+	if (!result)
+		return (NULL);
+	char *keys = (char*)&result->steps[max_steps];
 	// loop
-	for (pt = path; *pt; ++pt) {
+	for (const char *pt = path; *pt; ++pt) {
 		if (isspace(*pt))
 			continue;
 		if (*pt == SLASH) {
-			++pt;
-			s = ys_new("");
-			for (bool loop = true; loop && *pt; ++pt) {
-				if (*pt == SLASH || *pt == LBRACKET) {
-					loop = false;
-					break;
-				}
-				ys_addc(&s, *pt);
-			}
+			// key: copy it up to the next slash or bracket
+			const char *start = ++pt;
+			while (*pt && *pt != SLASH && *pt != LBRACKET)
+				++pt;
+			size_t key_len = pt - start;
 			--pt;
-			if (ys_bytesize(s)) {
-				if (!yvar_is_table(result) ||
-				    ytable_is_array(result->table_value))
-					goto error;
-				result = ytable_get_key_data(result->table_value, s);
-				if (!result)
-					goto error;
+			if (!key_len)
+				continue;
+			memcpy(keys, start, key_len);
+			keys[key_len] = '\0';
+			yvar_path_step_t *step = &result->steps[result->nb_steps++];
+			if (ys_is_numeric(keys)) {
+				*step = (yvar_path_step_t){
+					.type = YVAR_PATH_KEY_INDEX,
+					.hash = (uint64_t)atol(keys),
+				};
+			} else {
+				*step = (yvar_path_step_t){
+					.type = YVAR_PATH_KEY,
+					.key = keys,
+					.hash = yhash_string(keys),
+				};
+				keys += key_len + 1;
 			}
 		} else if (*pt == LBRACKET) {
-			if (!yvar_is_array(result))
-				goto error;
-			// get the content of the expression
-			s = ys_new("");
-			for (++pt; *pt; ++pt) {
-				if (*pt == RBRACKET)
-					break;
-				else if (*pt == LBRACKET)
-					goto error;
-				else
-					ys_addc(&s, *pt);
-			}
-			if (!*pt)
+			// get the content of the expression, without spaces
+			const char *start = ++pt;
+			while (*pt && *pt != RBRACKET && *pt != LBRACKET)
+				++pt;
+			if (*pt != RBRACKET)
 				goto error;
-			ys_trim(s);
-			// empty expression
-			if (!ys_bytesize(s))
+			const char *end = pt;
+			while (start < end && isspace(*start))
+				++start;
+			while (end > start && isspace(end[-1]))
+				--end;
+			// empty expression: only check that the value is an array
+			if (start == end) {
+				result->steps[result->nb_steps++] = (yvar_path_step_t){
+					.type = YVAR_PATH_ARRAY,
+				};
 				continue;
+			}
 			// numerical expression: get the nth element of a list
-			if (ys_is_numeric(s)) {
-				size_t index = strtoll(s, NULL, 10);
-				result = ytable_get_index_data(result->table_value, index);
-				continue;
+			uint64_t index = 0;
+			for (const char *digit = start; digit < end; ++digit) {
+				if (!isdigit(*digit))
+					goto error;
+				index = (index * 10) + (*digit - '0');
 			}
-			goto error;
+			result->steps[result->nb_steps++] = (yvar_path_step_t){
+				.type = YVAR_PATH_INDEX,
+				.hash = index,
+			};
 		} else
 			goto error;
-		ys_delete(&s);
 	}
 	return (result);
 error:
-	ys_free(s);
+	free0(result);
 	return (NULL);
 }
+/* Return a value from a JSON root element and a compiled path. */
+yvar_t *yvar_path_eval(const yvar_path_t *path, yvar_t *root) {
+	yvar_t *result = root;
 
+	if (!path)
+		return (NULL);
+	for (uint32_t i = 0; i < path->nb_steps && result; ++i) {
+		const yvar_path_step_t *step = &path->steps[i];
+		if (!yvar_is_table(result))
+			return (NULL);
+		bool is_array = ytable_is_array(result->table_value);
+		if (step->type == YVAR_PATH_INDEX || step->type == YVAR_PATH_ARRAY) {
+			if (!is_array)
+				return (NULL);
+			if (step->type == YVAR_PATH_INDEX)
+				result = ytable_get_index_data(result->table_value, step->hash);
+		} else if (is_array) {
+			return (NULL);
+		} else if (step->type == YVAR_PATH_KEY_INDEX) {
+			result = ytable_get_index_data(result->table_value, step->hash);
+		} else if (result->table_value->hash_function) {
+			// the precomputed hash is only valid for the default hash function
+			result = ytable_get_key_data(result->table_value, step->key);
+		} else {
+			yres_pointer_t res = ytable_get_key_hashed(result->table_value, step->key,
+			                                           step->hash);
+			result = (YRES_STATUS(res) == YENOERR) ? YRES_VAL(res) : NULL;
+		}
+	}
+	return (result);
+}
+/* Destroy a compiled path. */
+void yvar_path_free(yvar_path_t *path) {
+	free0(path);
+}
@@ -0,0 +1,53 @@
+#include <stdint.h>
+#include "y.h"
+
+/* ************ PRIVATE DEFINITIONS AND MACROS ************ */
+/** @define _YVECTOR_MIN_SIZE Minimal number of elements allocated for a vector. */
+#define _YVECTOR_MIN_SIZE	16
+
+/* ************ FUNCTIONS ************* */
+/* Make sure a vector could contain a given number of elements. */
+void *yvector_reserve(void *v, size_t size, size_t item_size) {
+	yarray_head_t *y = v ? YVECTOR_HEAD(v) : NULL;
+
+	if (y && size <= y->total)
+		return (v);
+	// the capacity is doubled at least, to amortize the copies
+	if (y && size < (y->total * 2))
+		size = y->total * 2;
+	size = COMPUTE_SIZE(size, _YVECTOR_MIN_SIZE);
+	if (!item_size || size > ((SIZE_MAX - sizeof(yarray_head_t)) / item_size))
+		return (NULL);
+	yarray_head_t *ny = realloc0(y, sizeof(yarray_head_t) + (size * item_size));
+	if (!ny)
+		return (NULL);
+	if (!y)
+		ny->used = 0;
+	ny->total = size;
+	return ((void*)((char*)ny + sizeof(yarray_head_t)));
+}
+/* Reduce the allocated memory of a vector to its length. */
+void *yvector_shrink(void *v, size_t item_size) {
+	if (!v)
+		return (NULL);
+	yarray_head_t *y = YVECTOR_HEAD(v);
+	if (!y->used) {
+		free0(y);
+		return (NULL);
+	}
+	if (y->used == y->total)
+		return (v);
+	yarray_head_t *ny = realloc0(y, sizeof(yarray_head_t) + (y->used * item_size));
+	// if the reallocation failed, the vector is kept as is
+	if (!ny)
+		return (v);
+	ny->total = ny->used;
+	return ((void*)((char*)ny + sizeof(yarray_head_t)));
+}
+/* Free a vector. */
+void yvector_free(void *v) {
+	if (!v)
+		return;
+	yarray_head_t *y = YVECTOR_HEAD(v);
+	free0(y);
+}
@@ -0,0 +1,205 @@
+/**
+ * @header	yvector.h
+ * @abstract	Typed vectors, storing their values contiguously.
+ * @discussion	A yarray stores pointers, so an array of integers or small structures
+ *		needs an allocation per element. A typed vector stores the values
+ *		themselves, after a yarray_head_t header; like a yarray, it is a pointer to
+ *		its first element, so values are read with the [] operator.
+ *		The functions of a vector type are generated by YVECTOR_DECLARE(). An empty
+ *		vector is NULL; it is allocated by the first addition, and its capacity is
+ *		doubled when needed.
+ *		<code>
+ *		typedef struct { uint32_t id; float score; } record_t;
+ *		YVECTOR_DECLARE(records, record_t);
+ *
+ *		records_t v = NULL;
+ *		records_push(&v, (record_t){.id = 12, .score = 0.5});
+ *		for (size_t i = 0; i < records_length(v); i++)
+ *			printf("%u\n", v[i].id);
+ *		records_delete(&v);
+ *		</code>
+ * @version	1.0.0 Oct 16 2026
+ * @author	Amaury Bouchard <amaury@amaury.net>
+ */
+#pragma once
+
+#if defined(__cplusplus) || defined(c_plusplus)
+extern "C" {
+#endif /* __cplusplus || c_plusplus */
+
+#include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
+#include "ystatus.h"
+#include "yarray.h"
+
+/** @define YVECTOR_HEAD Get a pointer to a vector's header. */
+#define YVECTOR_HEAD(v)	((yarray_head_t*)((char*)(v) - sizeof(yarray_head_t)))
+
+/* ********** GENERIC FUNCTIONS ********** */
+/**
+ * @function	yvector_reserve
+ *		Make sure a vector could contain a given number of elements. Used by the
+ *		functions generated by YVECTOR_DECLARE().
+ * @param	v		The vector, or NULL to create a new one.
+ * @param	size		Minimal number of elements.
+ * @param	item_size	Size of an element.
+ * @return	The vector (which could have moved), or NULL if the memory couldn't be
+ *		allocated (the vector is not modified).
+ */
+void *yvector_reserve(void *v, size_t size, size_t item_size);
+/**
+ * @function	yvector_shrink
+ *		Reduce the allocated memory of a vector to its length. Used by the functions
+ *		generated by YVECTOR_DECLARE().
+ * @param	v		The vector.
+ * @param	item_size	Size of an element.
+ * @return	The vector (which could have moved). If the vector is empty, it is freed
+ *		and NULL is returned.
+ */
+void *yvector_shrink(void *v, size_t item_size);
+/**
+ * @function	yvector_free
+ *		Free a vector.
+ * @param	v	The vector. Could be NULL.
+ */
+void yvector_free(void *v);
+/**
+ * @function	yvector_length
+ *		Return the number of elements of a vector.
+ * @param	v	The vector. Could be NULL.
+ * @return	The vector's length.
+ */
+static inline size_t yvector_length(const void *v) {
+	return (v ? ((const yarray_head_t*)((const char*)v - sizeof(yarray_head_t)))->used : 0);
+}
+/**
+ * @function	yvector_size
+ *		Return the number of elements a vector could contain without reallocation.
+ * @param	v	The vector. Could be NULL.
+ * @return	The vector's size.
+ */
+static inline size_t yvector_size(const void *v) {
+	return (v ? ((const yarray_head_t*)((const char*)v - sizeof(yarray_head_t)))->total : 0);
+}
+
+/* ********** TYPED VECTORS ********** */
+/**
+ * @define	YVECTOR_DECLARE
+ *		Declare a vector type and its functions. For a name "foo":
+ *		- foo_t: the vector type (pointer to the element type).
+ *		- foo_item_t: the element type.
+ *		- foo_t foo_create(size_t size): create a vector which could contain the given
+ *		  number of elements without reallocation (NULL on error).
+ *		- void foo_delete(foo_t *v): free a vector and set it to NULL.
+ *		- size_t foo_length(const foo_t v): number of elements.
+ *		- size_t foo_size(const foo_t v): number of allocated elements.
+ *		- ystatus_t foo_reserve(foo_t *v, size_t size): make sure the vector could
+ *		  contain the given number of elements (YENOMEM on error).
+ *		- void foo_shrink(foo_t *v): release the unused memory.
+ *		- void foo_trunc(foo_t v): remove all the elements (the memory is kept).
+ *		- foo_item_t *foo_get(const foo_t v, size_t offset): pointer to an element, or
+ *		  NULL if the offset is out of bounds.
+ *		- ystatus_t foo_push(foo_t *v, foo_item_t item): add an element at the end
+ *		  (YENOMEM on error).
+ *		- bool foo_pop(foo_t v, foo_item_t *item): remove the last element and copy it
+ *		  if the pointer is not NULL (false if the vector is empty).
+ *		- ystatus_t foo_insert(foo_t *v, foo_item_t item, size_t offset): insert an
+ *		  element, the next ones are shifted to the right (YEINVAL if the offset is
+ *		  greater than the length, YENOMEM on error).
+ *		- bool foo_extract(foo_t v, size_t offset, foo_item_t *item): remove an element
+ *		  and copy it if the pointer is not NULL, the next ones are shifted to the left
+ *		  (false if the offset is out of bounds).
+ *		- void foo_sort(foo_t v, int (*f)(const void*, const void*)): sort the elements
+ *		  (see qsort(3); the function gets pointers to elements).
+ *		- long long int foo_search(const foo_t v, const foo_item_t *item,
+ *		  int (*f)(const void*, const void*)): offset of an element in a sorted vector
+ *		  (see bsearch(3)), or -1 if it can't be found.
+ * @param	name	Name of the vector type.
+ * @param	type	Type of the elements.
+ */
+#define YVECTOR_DECLARE(name, type) \
+	typedef type *name##_t; \
+	static inline name##_t name##_create(size_t size) { \
+		return ((name##_t)yvector_reserve(NULL, size, sizeof(type))); \
+	} \
+	static inline void name##_delete(name##_t *v) { \
+		yvector_free(*v); \
+		*v = NULL; \
+	} \
+	static inline size_t name##_length(const name##_t v) { \
+		return (yvector_length(v)); \
+	} \
+	static inline size_t name##_size(const name##_t v) { \
+		return (yvector_size(v)); \
+	} \
+	static inline ystatus_t name##_reserve(name##_t *v, size_t size) { \
+		name##_t nv = (name##_t)yvector_reserve(*v, size, sizeof(type)); \
+		if (!nv) \
+			return (YENOMEM); \
+		*v = nv; \
+		return (YENOERR); \
+	} \
+	static inline void name##_shrink(name##_t *v) { \
+		*v = (name##_t)yvector_shrink(*v, sizeof(type)); \
+	} \
+	static inline void name##_trunc(name##_t v) { \
+		if (v) \
+			YVECTOR_HEAD(v)->used = 0; \
+	} \
+	static inline type *name##_get(const name##_t v, size_t offset) { \
+		return ((offset < yvector_length(v)) ? &v[offset] : NULL); \
+	} \
+	static inline ystatus_t name##_push(name##_t *v, type item) { \
+		size_t length = yvector_length(*v); \
+		if (length == yvector_size(*v) && name##_reserve(v, length + 1) != YENOERR) \
+			return (YENOMEM); \
+		(*v)[length] = item; \
+		YVECTOR_HEAD(*v)->used++; \
+		return (YENOERR); \
+	} \
+	static inline bool name##_pop(name##_t v, type *item) { \
+		if (!yvector_length(v)) \
+			return (false); \
+		size_t offset = --YVECTOR_HEAD(v)->used; \
+		if (item) \
+			*item = v[offset]; \
+		return (true); \
+	} \
+	static inline ystatus_t name##_insert(name##_t *v, type item, size_t offset) { \
+		size_t length = yvector_length(*v); \
+		if (offset > length) \
+			return (YEINVAL); \
+		if (length == yvector_size(*v) && name##_reserve(v, length + 1) != YENOERR) \
+			return (YENOMEM); \
+		memmove(&(*v)[offset + 1], &(*v)[offset], (length - offset) * sizeof(type)); \
+		(*v)[offset] = item; \
+		YVECTOR_HEAD(*v)->used++; \
+		return (YENOERR); \
+	} \
+	static inline bool name##_extract(name##_t v, size_t offset, type *item) { \
+		size_t length = yvector_length(v); \
+		if (offset >= length) \
+			return (false); \
+		if (item) \
+			*item = v[offset]; \
+		memmove(&v[offset], &v[offset + 1], (length - offset - 1) * sizeof(type)); \
+		YVECTOR_HEAD(v)->used--; \
+		return (true); \
+	} \
+	static inline void name##_sort(name##_t v, int (*f)(const void*, const void*)) { \
+		if (yvector_length(v) > 1) \
+			qsort(v, yvector_length(v), sizeof(type), f); \
+	} \
+	static inline long long int name##_search(const name##_t v, const type *item, \
+	                                          int (*f)(const void*, const void*)) { \
+		if (!yvector_length(v)) \
+			return (-1); \
+		const type *found = (const type*)bsearch(item, v, yvector_length(v), sizeof(type), f); \
+		return (found ? (long long int)(found - v) : -1); \
+	} \
+	typedef type name##_item_t
+
+#if defined(__cplusplus) || defined(c_plusplus)
+}
+#endif /* __cplusplus || c_plusplus */